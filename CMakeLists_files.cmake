@@ -80,6 +80,7 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/blackoil/blackoiltwophaseindices.hh
              opm/models/blackoil/blackoilpolymermodules.hh
              opm/models/blackoil/blackoilboundaryratevector.hh
+             opm/models/common/intensivequantitiessoacache.hh
              opm/models/common/multiphasebaseproperties.hh
              opm/models/common/multiphasebasemodel.hh
              opm/models/common/quantitycallbacks.hh
@@ -118,7 +119,9 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/discretization/common/fvbaseproperties.hh
              opm/models/discretization/common/fvbaseextensivequantities.hh
              opm/models/discretization/common/fvbaselinearizer.hh
+             opm/models/discretization/common/reorderedmapper.hh
              opm/models/discretization/common/restrictprolong.hh
+             opm/models/discretization/common/sparsitypattern.hh
              opm/models/discretization/common/fvbasediscretization.hh
              opm/models/discretization/common/fvbasegradientcalculator.hh
              opm/models/discretization/common/fvbaseproblem.hh
@@ -152,9 +155,12 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/io/vtkscalarfunction.hh
              opm/models/io/vtkenergymodule.hh
              opm/models/io/restart.hh
+             opm/models/io/asyncrestartwriter.hh
              opm/models/io/cubegridvanguard.hh
              opm/models/io/baseoutputwriter.hh
              opm/models/io/vtkmultiwriter.hh
+             opm/models/io/vtkstaticgridwriter.hh
+             opm/models/io/xdmfwriter.hh
              opm/models/io/vtkmultiphasemodule.hh
              opm/models/io/vtkdiscretefracturemodule.hh
              opm/models/io/vtkdiffusionmodule.hh
@@ -189,6 +195,7 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/parallel/gridcommhandles.hh
              opm/models/parallel/mpibuffer.hh
              opm/models/parallel/threadedentityiterator.hh
+             opm/models/parallel/threadedelementscheduler.hh
              opm/models/pvs/pvsboundaryratevector.hh
              opm/models/pvs/pvsratevector.hh
              opm/models/pvs/pvsindices.hh
@@ -220,6 +227,7 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/models/utils/quadraturegeometries.hh
              opm/models/utils/alignedallocator.hh
              opm/models/utils/timer.hh
+             opm/models/utils/profiler.hh
              opm/models/utils/signum.hh
              opm/models/utils/genericguard.hh
              opm/models/utils/basicproperties.hh
@@ -230,6 +238,8 @@ list (APPEND PUBLIC_HEADER_FILES
              opm/simulators/linalg/linearsolverreport.hh
              opm/simulators/linalg/istlsparsematrixadapter.hh
              opm/simulators/linalg/istlpreconditionerwrappers.hh
+             opm/simulators/linalg/threadedilu0.hh
+             opm/simulators/linalg/mixedprecisionpreconditioner.hh
              opm/simulators/linalg/residreductioncriterion.hh
              opm/simulators/linalg/overlappingbcrsmatrix.hh
              opm/simulators/linalg/blacklist.hh
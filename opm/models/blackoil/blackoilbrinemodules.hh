@@ -30,6 +30,7 @@
 
 #include "blackoilproperties.hh"
 #include <opm/models/common/quantitycallbacks.hh>
+#include <opm/models/io/restart.hh>
 
 #include <opm/material/common/Tabulated1DFunction.hpp>
 #include <opm/material/common/IntervalTabulated2DFunction.hpp>
@@ -275,7 +276,7 @@ public:
 
         unsigned dofIdx = model.dofMapper().index(dof);
         const PrimaryVariables& priVars = model.solution(/*timeIdx=*/0)[dofIdx];
-        outstream << priVars[saltConcentrationIdx];
+        Restart::serializeValue(outstream, priVars[saltConcentrationIdx]);
     }
 
     template <class DofEntity>
@@ -288,7 +289,7 @@ public:
         PrimaryVariables& priVars0 = model.solution(/*timeIdx=*/0)[dofIdx];
         PrimaryVariables& priVars1 = model.solution(/*timeIdx=*/1)[dofIdx];
 
-        instream >> priVars0[saltConcentrationIdx];
+        Restart::deserializeValue(instream, priVars0[saltConcentrationIdx]);
 
         // set the primary variables for the beginning of the current time step.
         priVars1[saltConcentrationIdx] = priVars0[saltConcentrationIdx];
@@ -31,6 +31,7 @@
 #include "blackoilproperties.hh"
 #include <opm/models/io/vtkblackoilenergymodule.hh>
 #include <opm/models/common/quantitycallbacks.hh>
+#include <opm/models/io/restart.hh>
 
 #include <opm/material/common/Tabulated1DFunction.hpp>
 
@@ -297,7 +298,7 @@ public:
 
         unsigned dofIdx = model.dofMapper().index(dof);
         const PrimaryVariables& priVars = model.solution(/*timeIdx=*/0)[dofIdx];
-        outstream << priVars[temperatureIdx];
+        Restart::serializeValue(outstream, priVars[temperatureIdx]);
     }
 
     template <class DofEntity>
@@ -310,7 +311,7 @@ public:
         PrimaryVariables& priVars0 = model.solution(/*timeIdx=*/0)[dofIdx];
         PrimaryVariables& priVars1 = model.solution(/*timeIdx=*/1)[dofIdx];
 
-        instream >> priVars0[temperatureIdx];
+        Restart::deserializeValue(instream, priVars0[temperatureIdx]);
 
         // set the primary variables for the beginning of the current time step.
         priVars1 = priVars0[temperatureIdx];
@@ -31,6 +31,7 @@
 #include "blackoilproperties.hh"
 //#include <opm/models/io/vtkblackoilfoammodule.hh>
 #include <opm/models/common/quantitycallbacks.hh>
+#include <opm/models/io/restart.hh>
 
 #include <opm/material/common/Tabulated1DFunction.hpp>
 //#include <opm/material/common/IntervalTabulated2DFunction.hpp>
@@ -381,7 +382,7 @@ public:
 
         unsigned dofIdx = model.dofMapper().index(dof);
         const PrimaryVariables& priVars = model.solution(/*timeIdx=*/0)[dofIdx];
-        outstream << priVars[foamConcentrationIdx];
+        Restart::serializeValue(outstream, priVars[foamConcentrationIdx]);
     }
 
     template <class DofEntity>
@@ -394,7 +395,7 @@ public:
         PrimaryVariables& priVars0 = model.solution(/*timeIdx=*/0)[dofIdx];
         PrimaryVariables& priVars1 = model.solution(/*timeIdx=*/1)[dofIdx];
 
-        instream >> priVars0[foamConcentrationIdx];
+        Restart::deserializeValue(instream, priVars0[foamConcentrationIdx]);
 
         // set the primary variables for the beginning of the current time step.
         priVars1[foamConcentrationIdx] = priVars0[foamConcentrationIdx];
@@ -48,6 +48,7 @@
 #include "blackoildarcyfluxmodule.hh"
 
 #include <opm/models/common/multiphasebasemodel.hh>
+#include <opm/models/io/restart.hh>
 #include <opm/models/io/vtkcompositionmodule.hh>
 #include <opm/models/io/vtkblackoilmodule.hh>
 
@@ -457,11 +458,11 @@ public:
         // write the primary variables
         const auto& priVars = this->solution(/*timeIdx=*/0)[dofIdx];
         for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-            outstream << priVars[eqIdx] << " ";
+            Restart::serializeValue(outstream, priVars[eqIdx]);
 
         // write the pseudo primary variables
-        outstream << priVars.primaryVarsMeaning() << " ";
-        outstream << priVars.pvtRegionIndex() << " ";
+        Restart::serializeValue(outstream, static_cast<unsigned>(priVars.primaryVarsMeaning()));
+        Restart::serializeValue(outstream, static_cast<unsigned>(priVars.pvtRegionIndex()));
 
         SolventModule::serializeEntity(*this, outstream, dof);
         PolymerModule::serializeEntity(*this, outstream, dof);
@@ -487,15 +488,15 @@ public:
         for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
             if (!instream.good())
                 throw std::runtime_error("Could not deserialize degree of freedom "+std::to_string(dofIdx));
-            instream >> priVars[eqIdx];
+            Restart::deserializeValue(instream, priVars[eqIdx]);
         }
 
         // read the pseudo primary variables
         unsigned primaryVarsMeaning;
-        instream >> primaryVarsMeaning;
+        Restart::deserializeValue(instream, primaryVarsMeaning);
 
         unsigned pvtRegionIdx;
-        instream >> pvtRegionIdx;
+        Restart::deserializeValue(instream, pvtRegionIdx);
 
         if (!instream.good())
             throw std::runtime_error("Could not deserialize degree of freedom "+std::to_string(dofIdx));
@@ -35,6 +35,9 @@
 
 #include <opm/material/common/Unused.hpp>
 
+#include <memory>
+#include <vector>
+
 namespace Opm::Properties {
 
 template <class TypeTag, class MyTypeTag>
@@ -91,6 +94,7 @@ class BlackOilNewtonMethod : public GetPropType<TypeTag, Properties::DiscNewtonM
     using Indices = GetPropType<TypeTag, Properties::Indices>;
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using Linearizer = GetPropType<TypeTag, Properties::Linearizer>;
+    using ThreadManager = GetPropType<TypeTag, Properties::ThreadManager>;
 
     static const unsigned numEq = getPropValue<TypeTag, Properties::NumEq>();
 
@@ -110,8 +114,8 @@ public:
     {
         ParentType::finishInit();
 
-        wasSwitched_.resize(this->model().numTotalDof());
-        std::fill(wasSwitched_.begin(), wasSwitched_.end(), false);
+        wasSwitched_.assign(this->model().numTotalDof(), 0);
+        threadNumSwitched_.reset(new ThreadCounter_[ThreadManager::maxThreads()]);
     }
 
     /*!
@@ -145,6 +149,8 @@ protected:
     void beginIteration_()
     {
         numPriVarsSwitched_ = 0;
+        for (unsigned threadId = 0; threadId < ThreadManager::maxThreads(); ++threadId)
+            threadNumSwitched_[threadId].value = 0;
         ParentType::beginIteration_();
     }
 
@@ -198,6 +204,12 @@ public:
         if (!succeeded)
             throw Opm::NumericalIssue("A process did not succeed in adapting the primary variables");
 
+        // the primary variables are updated by all threads, each of which counts the
+        // switches on its own
+        numPriVarsSwitched_ = 0;
+        for (unsigned threadId = 0; threadId < ThreadManager::maxThreads(); ++threadId)
+            numPriVarsSwitched_ += threadNumSwitched_[threadId].value;
+
         numPriVarsSwitched_ = comm.sum(numPriVarsSwitched_);
     }
 
@@ -336,7 +348,7 @@ protected:
             wasSwitched_[globalDofIdx] = nextValue.adaptPrimaryVariables(this->problem(), globalDofIdx);
 
         if (wasSwitched_[globalDofIdx])
-            ++ numPriVarsSwitched_;
+            ++ threadNumSwitched_[ThreadManager::threadId()].value;
         if(projectSaturations_){
             nextValue.chopAndNormalizeSaturations();
         }
@@ -345,7 +357,14 @@ protected:
     }
 
 private:
+    // each thread gets its own cache line for its counter to avoid false sharing
+    struct alignas(64) ThreadCounter_
+    {
+        int value = 0;
+    };
+
     int numPriVarsSwitched_;
+    std::unique_ptr<ThreadCounter_[]> threadNumSwitched_;
 
     Scalar priVarOscilationThreshold_;
     Scalar dpMaxRel_;
@@ -353,8 +372,9 @@ private:
     bool projectSaturations_;
 
     // keep track of cells where the primary variable meaning has changed
-    // to detect and hinder oscillations
-    std::vector<bool> wasSwitched_;
+    // to detect and hinder oscillations. std::vector<bool> cannot be used here because
+    // the entries are written concurrently
+    std::vector<unsigned char> wasSwitched_;
 };
 } // namespace Opm
 
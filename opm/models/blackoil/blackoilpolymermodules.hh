@@ -31,6 +31,7 @@
 #include "blackoilproperties.hh"
 #include <opm/models/io/vtkblackoilpolymermodule.hh>
 #include <opm/models/common/quantitycallbacks.hh>
+#include <opm/models/io/restart.hh>
 
 #include <opm/material/common/Tabulated1DFunction.hpp>
 #include <opm/material/common/IntervalTabulated2DFunction.hpp>
@@ -701,8 +702,8 @@ public:
 
         unsigned dofIdx = model.dofMapper().index(dof);
         const PrimaryVariables& priVars = model.solution(/*timeIdx=*/0)[dofIdx];
-        outstream << priVars[polymerConcentrationIdx];
-        outstream << priVars[polymerMoleWeightIdx];
+        Restart::serializeValue(outstream, priVars[polymerConcentrationIdx]);
+        Restart::serializeValue(outstream, priVars[polymerMoleWeightIdx]);
     }
 
     template <class DofEntity>
@@ -715,8 +716,8 @@ public:
         PrimaryVariables& priVars0 = model.solution(/*timeIdx=*/0)[dofIdx];
         PrimaryVariables& priVars1 = model.solution(/*timeIdx=*/1)[dofIdx];
 
-        instream >> priVars0[polymerConcentrationIdx];
-        instream >> priVars0[polymerMoleWeightIdx];
+        Restart::deserializeValue(instream, priVars0[polymerConcentrationIdx]);
+        Restart::deserializeValue(instream, priVars0[polymerMoleWeightIdx]);
 
         // set the primary variables for the beginning of the current time step.
         priVars1[polymerConcentrationIdx] = priVars0[polymerConcentrationIdx];
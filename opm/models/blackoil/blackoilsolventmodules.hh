@@ -31,6 +31,7 @@
 #include "blackoilproperties.hh"
 #include <opm/models/io/vtkblackoilsolventmodule.hh>
 #include <opm/models/common/quantitycallbacks.hh>
+#include <opm/models/io/restart.hh>
 
 #include <opm/material/fluidsystems/blackoilpvt/SolventPvt.hpp>
 #include <opm/material/common/Tabulated1DFunction.hpp>
@@ -657,7 +658,7 @@ public:
         unsigned dofIdx = model.dofMapper().index(dof);
 
         const PrimaryVariables& priVars = model.solution(/*timeIdx=*/0)[dofIdx];
-        outstream << priVars[solventSaturationIdx];
+        Restart::serializeValue(outstream, priVars[solventSaturationIdx]);
     }
 
     template <class DofEntity>
@@ -671,7 +672,7 @@ public:
         PrimaryVariables& priVars0 = model.solution(/*timeIdx=*/0)[dofIdx];
         PrimaryVariables& priVars1 = model.solution(/*timeIdx=*/1)[dofIdx];
 
-        instream >> priVars0[solventSaturationIdx];
+        Restart::deserializeValue(instream, priVars0[solventSaturationIdx]);
 
         // set the primary variables for the beginning of the current time step.
         priVars1 = priVars0[solventSaturationIdx];
@@ -31,6 +31,7 @@
 #define EWOMS_DARCY_FLUX_MODULE_HH
 
 #include "multiphasebaseproperties.hh"
+#include "intensivequantitiessoacache.hh"
 #include <opm/models/common/quantitycallbacks.hh>
 
 #include <opm/material/common/Valgrind.hpp>
@@ -131,6 +132,46 @@ class DarcyExtensiveQuantities
     using DimVector = Dune::FieldVector<Scalar, dimWorld>;
     using DimMatrix = Dune::FieldMatrix<Scalar, dimWorld, dimWorld>;
 
+    using IntensiveQuantitiesSoa = Opm::IntensiveQuantitiesSoaCache<TypeTag>;
+
+    // provides the phase pressures to the gradient calculator. if possible, they are
+    // taken from the structure of arrays of the cached intensive quantities
+    class SoaPressureCallback_
+    {
+        using FallbackCallback = Opm::PressureCallback<TypeTag>;
+
+    public:
+        using ResultType = typename FallbackCallback::ResultType;
+        using ResultValueType = typename FallbackCallback::ResultValueType;
+
+        SoaPressureCallback_(const ElementContext& elemCtx,
+                             const IntensiveQuantitiesSoa* soa)
+            : fallback_(elemCtx)
+            , elemCtx_(elemCtx)
+            , soa_(soa)
+        {}
+
+        void setPhaseIndex(unsigned phaseIdx)
+        {
+            fallback_.setPhaseIndex(phaseIdx);
+            phaseIdx_ = phaseIdx;
+        }
+
+        ResultType operator()(unsigned dofIdx) const
+        {
+            int soaIdx = soaIndex_(elemCtx_, soa_, dofIdx);
+            if (soaIdx >= 0)
+                return soa_->pressure(phaseIdx_, static_cast<unsigned>(soaIdx));
+            return fallback_(dofIdx);
+        }
+
+    private:
+        FallbackCallback fallback_;
+        const ElementContext& elemCtx_;
+        const IntensiveQuantitiesSoa* soa_;
+        unsigned phaseIdx_;
+    };
+
 public:
     /*!
      * \brief Returns the intrinsic permeability tensor for a given
@@ -170,6 +211,20 @@ public:
     { return volumeFlux_[phaseIdx]; }
 
 protected:
+    // returns the index of a DOF in the structure of arrays of the cached intensive
+    // quantities of the most recent time index or -1 if its quantities cannot be taken
+    // from there
+    static int soaIndex_(const ElementContext& elemCtx,
+                         const IntensiveQuantitiesSoa* soa,
+                         unsigned dofIdx)
+    {
+        if (!soa || !elemCtx.intensiveQuantitiesCached(dofIdx, /*timeIdx=*/0))
+            return -1;
+
+        unsigned globalIdx = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+        return soa->isValid(globalIdx) ? static_cast<int>(globalIdx) : -1;
+    }
+
     short upstreamIndex_(unsigned phaseIdx) const
     { return upstreamDofIdx_[phaseIdx]; }
 
@@ -186,7 +241,12 @@ protected:
                              unsigned timeIdx)
     {
         const auto& gradCalc = elemCtx.gradientCalculator();
-        Opm::PressureCallback<TypeTag> pressureCallback(elemCtx);
+
+        // if the model stores the quantities required here as a structure of arrays,
+        // they are taken from there for all DOFs which refer to the cached intensive
+        // quantities
+        const IntensiveQuantitiesSoa* soa = timeIdx == 0 ? elemCtx.model().intensiveQuantitiesSoa() : nullptr;
+        SoaPressureCallback_ pressureCallback(elemCtx, soa);
 
         const auto& scvf = elemCtx.stencil(timeIdx).interiorFace(faceIdx);
         const auto& faceNormal = scvf.normal();
@@ -235,6 +295,9 @@ protected:
             distVecEx -= posFace;
             distVecTotal -= posIn;
             Scalar absDistTotalSquared = distVecTotal.two_norm2();
+
+            int soaIdxIn = soaIndex_(elemCtx, soa, i);
+            int soaIdxEx = soaIndex_(elemCtx, soa, j);
             for (unsigned phaseIdx=0; phaseIdx < numPhases; phaseIdx++) {
                 if (!elemCtx.model().phaseIsConsidered(phaseIdx))
                     continue;
@@ -242,31 +305,29 @@ protected:
                 // calculate the hydrostatic pressure at the integration point of the face
                 Evaluation pStatIn;
 
+                const Evaluation& rhoIn =
+                    (soaIdxIn >= 0)
+                    ? soa->density(phaseIdx, static_cast<unsigned>(soaIdxIn))
+                    : intQuantsIn.fluidState().density(phaseIdx);
                 if (std::is_same<Scalar, Evaluation>::value ||
                     interiorDofIdx_ == static_cast<int>(focusDofIdx))
-                {
-                    const Evaluation& rhoIn = intQuantsIn.fluidState().density(phaseIdx);
                     pStatIn = - rhoIn*(gIn*distVecIn);
-                }
-                else {
-                    Scalar rhoIn = Toolbox::value(intQuantsIn.fluidState().density(phaseIdx));
-                    pStatIn = - rhoIn*(gIn*distVecIn);
-                }
+                else
+                    pStatIn = - Toolbox::value(rhoIn)*(gIn*distVecIn);
 
                 // the quantities on the exterior side of the face do not influence the
                 // result for the TPFA scheme, so they can be treated as scalar values.
                 Evaluation pStatEx;
 
+                const Evaluation& rhoEx =
+                    (soaIdxEx >= 0)
+                    ? soa->density(phaseIdx, static_cast<unsigned>(soaIdxEx))
+                    : intQuantsEx.fluidState().density(phaseIdx);
                 if (std::is_same<Scalar, Evaluation>::value ||
                     exteriorDofIdx_ == static_cast<int>(focusDofIdx))
-                {
-                    const Evaluation& rhoEx = intQuantsEx.fluidState().density(phaseIdx);
-                    pStatEx = - rhoEx*(gEx*distVecEx);
-                }
-                else {
-                    Scalar rhoEx = Toolbox::value(intQuantsEx.fluidState().density(phaseIdx));
                     pStatEx = - rhoEx*(gEx*distVecEx);
-                }
+                else
+                    pStatEx = - Toolbox::value(rhoEx)*(gEx*distVecEx);
 
                 // compute the hydrostatic gradient between the two control volumes (this
                 // gradient exhibitis the same direction as the vector between the two
@@ -314,11 +375,16 @@ protected:
 
             // we only carry the derivatives along if the upstream DOF is the one which
             // we currently focus on
-            const auto& up = elemCtx.intensiveQuantities(upstreamDofIdx_[phaseIdx], timeIdx);
+            unsigned upIdx = static_cast<unsigned>(upstreamDofIdx_[phaseIdx]);
+            int soaIdxUp = soaIndex_(elemCtx, soa, upIdx);
+            const Evaluation& upMobility =
+                (soaIdxUp >= 0)
+                ? soa->mobility(phaseIdx, static_cast<unsigned>(soaIdxUp))
+                : elemCtx.intensiveQuantities(upIdx, timeIdx).mobility(phaseIdx);
             if (upstreamDofIdx_[phaseIdx] == static_cast<int>(focusDofIdx))
-                mobility_[phaseIdx] = up.mobility(phaseIdx);
+                mobility_[phaseIdx] = upMobility;
             else
-                mobility_[phaseIdx] = Toolbox::value(up.mobility(phaseIdx));
+                mobility_[phaseIdx] = Toolbox::value(upMobility);
         }
     }
 
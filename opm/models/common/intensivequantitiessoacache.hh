@@ -0,0 +1,179 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::IntensiveQuantitiesSoaCache
+ */
+#ifndef EWOMS_INTENSIVE_QUANTITIES_SOA_CACHE_HH
+#define EWOMS_INTENSIVE_QUANTITIES_SOA_CACHE_HH
+
+#include "multiphasebaseproperties.hh"
+
+#include <opm/models/discretization/common/fvbaseproperties.hh>
+#include <opm/models/utils/alignedallocator.hh>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \ingroup MultiPhaseBaseModel
+ *
+ * \brief Stores the quantities of the cached intensive quantities which are required
+ *        to compute the fluxes as a structure of arrays.
+ *
+ * The phase pressures, densities and mobilities of all degrees of freedom are stored in
+ * a contiguous array per quantity and fluid phase. Compared to accessing the
+ * IntensiveQuantities objects, this considerably reduces the amount of memory which
+ * needs to be transferred by the flux computations. Only the most recent time index is
+ * considered.
+ *
+ * The validity of each entry is tracked using a stamp which is compared to an epoch,
+ * i.e., invalidating all entries is a constant time operation. Entries for different
+ * degrees of freedom may be updated concurrently.
+ */
+template <class TypeTag>
+class IntensiveQuantitiesSoaCache
+{
+    using IntensiveQuantities = GetPropType<TypeTag, Properties::IntensiveQuantities>;
+    using FluidState = typename std::decay<decltype(std::declval<IntensiveQuantities>().fluidState())>::type;
+
+    enum { numPhases = getPropValue<TypeTag, Properties::NumPhases>() };
+
+public:
+    using PressureType = typename std::decay<decltype(std::declval<FluidState>().pressure(0))>::type;
+    using DensityType = typename std::decay<decltype(std::declval<FluidState>().density(0))>::type;
+    using MobilityType = typename std::decay<decltype(std::declval<IntensiveQuantities>().mobility(0))>::type;
+
+    IntensiveQuantitiesSoaCache()
+        : epoch_(1)
+    {}
+
+    /*!
+     * \brief Returns the number of degrees of freedom for which storage is allocated.
+     */
+    size_t size() const
+    { return stamp_.size(); }
+
+    /*!
+     * \brief Allocate storage for a given number of degrees of freedom.
+     *
+     * All entries are invalid afterwards.
+     */
+    void resize(size_t numDof)
+    {
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            pressure_[phaseIdx].resize(numDof);
+            density_[phaseIdx].resize(numDof);
+            mobility_[phaseIdx].resize(numDof);
+        }
+        stamp_.assign(numDof, 0);
+        epoch_ = 1;
+    }
+
+    /*!
+     * \brief Returns true if the entries for a degree of freedom are up to date.
+     */
+    bool isValid(unsigned globalIdx) const
+    {
+        assert(globalIdx < stamp_.size());
+        return stamp_[globalIdx] == epoch_;
+    }
+
+    /*!
+     * \brief Invalidate the entries for all degrees of freedom.
+     */
+    void invalidate()
+    {
+        // the stamp 0 is never valid. if the epochs are exhausted, the stamps need to be
+        // reset explicitly
+        if (++ epoch_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            epoch_ = 1;
+        }
+    }
+
+    /*!
+     * \brief Invalidate the entries for a single degree of freedom.
+     */
+    void invalidate(unsigned globalIdx)
+    {
+        assert(globalIdx < stamp_.size());
+        stamp_[globalIdx] = 0;
+    }
+
+    /*!
+     * \brief Set the entries for a degree of freedom from an intensive quantities object.
+     */
+    void update(unsigned globalIdx, const IntensiveQuantities& intQuants)
+    {
+        assert(globalIdx < stamp_.size());
+
+        const auto& fs = intQuants.fluidState();
+        for (unsigned phaseIdx = 0; phaseIdx < numPhases; ++phaseIdx) {
+            pressure_[phaseIdx][globalIdx] = fs.pressure(phaseIdx);
+            density_[phaseIdx][globalIdx] = fs.density(phaseIdx);
+            mobility_[phaseIdx][globalIdx] = intQuants.mobility(phaseIdx);
+        }
+        stamp_[globalIdx] = epoch_;
+    }
+
+    /*!
+     * \brief Returns the pressure of a fluid phase at a degree of freedom.
+     */
+    const PressureType& pressure(unsigned phaseIdx, unsigned globalIdx) const
+    { return pressure_[phaseIdx][globalIdx]; }
+
+    /*!
+     * \brief Returns the density of a fluid phase at a degree of freedom.
+     */
+    const DensityType& density(unsigned phaseIdx, unsigned globalIdx) const
+    { return density_[phaseIdx][globalIdx]; }
+
+    /*!
+     * \brief Returns the mobility of a fluid phase at a degree of freedom.
+     */
+    const MobilityType& mobility(unsigned phaseIdx, unsigned globalIdx) const
+    { return mobility_[phaseIdx][globalIdx]; }
+
+private:
+    template <class T>
+    using Array_ = std::vector<T, Opm::aligned_allocator<T, alignof(T)> >;
+
+    std::array<Array_<PressureType>, numPhases> pressure_;
+    std::array<Array_<DensityType>, numPhases> density_;
+    std::array<Array_<MobilityType>, numPhases> mobility_;
+
+    std::vector<uint32_t> stamp_;
+    uint32_t epoch_;
+};
+
+} // namespace Opm
+
+#endif
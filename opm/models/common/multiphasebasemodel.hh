@@ -33,6 +33,7 @@
 #include "multiphasebaseproperties.hh"
 #include "multiphasebaseproblem.hh"
 #include "multiphasebaseextensivequantities.hh"
+#include "intensivequantitiessoacache.hh"
 
 #include <opm/models/common/flux.hh>
 #include <opm/models/discretization/vcfv/vcfvdiscretization.hh>
@@ -45,6 +46,8 @@
 #include <opm/material/thermal/NullSolidEnergyLaw.hpp>
 #include <opm/material/common/Unused.hpp>
 
+#include <stdexcept>
+
 namespace Opm {
 template <class TypeTag>
 class MultiPhaseBaseModel;
@@ -139,6 +142,11 @@ struct ThermalConductionLawParams<TypeTag, TTag::MultiPhaseBaseModel>
 template<class TypeTag>
 struct EnableGravity<TypeTag, TTag::MultiPhaseBaseModel> { static constexpr bool value = false; };
 
+//! do not store the quantities required by the flux computations as a structure of
+//! arrays by default
+template<class TypeTag>
+struct EnableIntensiveQuantitiesSoa<TypeTag, TTag::MultiPhaseBaseModel> { static constexpr bool value = false; };
+
 
 } // namespace Opm::Properties
 
@@ -162,9 +170,12 @@ class MultiPhaseBaseModel : public GetPropType<TypeTag, Properties::Discretizati
     using ElementContext = GetPropType<TypeTag, Properties::ElementContext>;
     using EqVector = GetPropType<TypeTag, Properties::EqVector>;
     using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using IntensiveQuantities = GetPropType<TypeTag, Properties::IntensiveQuantities>;
+    using IntensiveQuantitiesSoa = IntensiveQuantitiesSoaCache<TypeTag>;
 
     using ElementIterator = typename GridView::template Codim<0>::Iterator;
     using Element = typename GridView::template Codim<0>::Entity;
+    using ElementScheduler = Opm::ThreadedElementScheduler<GridView>;
 
     enum { numPhases = getPropValue<TypeTag, Properties::NumPhases>() };
     enum { numComponents = FluidSystem::numComponents };
@@ -172,7 +183,12 @@ class MultiPhaseBaseModel : public GetPropType<TypeTag, Properties::Discretizati
 public:
     MultiPhaseBaseModel(Simulator& simulator)
         : ParentType(simulator)
-    { }
+    {
+        enableIntensiveQuantitiesSoa_ = EWOMS_GET_PARAM(TypeTag, bool, EnableIntensiveQuantitiesSoa);
+        if (enableIntensiveQuantitiesSoa_ && !EWOMS_GET_PARAM(TypeTag, bool, EnableIntensiveQuantityCache))
+            throw std::invalid_argument("Storing the intensive quantities as a structure of arrays "
+                                        "requires the intensive quantity cache to be enabled");
+    }
 
     /*!
      * \brief Register all run-time parameters for the immiscible model.
@@ -181,6 +197,10 @@ public:
     {
         ParentType::registerParameters();
 
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIntensiveQuantitiesSoa,
+                             "Additionally store the cached quantities which are required to "
+                             "compute the fluxes as a structure of arrays");
+
         // register runtime parameters of the VTK output modules
         Opm::VtkMultiPhaseModule<TypeTag>::registerParameters();
         Opm::VtkTemperatureModule<TypeTag>::registerParameters();
@@ -194,6 +214,77 @@ public:
     bool phaseIsConsidered(unsigned phaseIdx OPM_UNUSED) const
     { return true; }
 
+    /*!
+     * \brief Returns the structure of arrays which stores the quantities of the cached
+     *        intensive quantities that are used by the flux modules.
+     *
+     * If this storage mode is disabled, a null pointer is returned. The entries for a
+     * DOF are only meaningful if the entry is valid.
+     */
+    const IntensiveQuantitiesSoa* intensiveQuantitiesSoa() const
+    { return enableIntensiveQuantitiesSoa_ ? &intensiveQuantitiesSoa_ : nullptr; }
+
+    /*!
+     * \copydoc FvBaseDiscretization::updateCachedIntensiveQuantities
+     */
+    void updateCachedIntensiveQuantities(const IntensiveQuantities& intQuants,
+                                         unsigned globalIdx,
+                                         unsigned timeIdx) const
+    {
+        ParentType::updateCachedIntensiveQuantities(intQuants, globalIdx, timeIdx);
+
+        if (enableIntensiveQuantitiesSoa_ && timeIdx == 0)
+            intensiveQuantitiesSoa_.update(globalIdx, intQuants);
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::setIntensiveQuantitiesCacheEntryValidity
+     */
+    void setIntensiveQuantitiesCacheEntryValidity(unsigned globalIdx,
+                                                  unsigned timeIdx,
+                                                  bool newValue) const
+    {
+        ParentType::setIntensiveQuantitiesCacheEntryValidity(globalIdx, timeIdx, newValue);
+
+        if (!enableIntensiveQuantitiesSoa_ || timeIdx != 0)
+            return;
+
+        // an entry which becomes valid is taken from the cached object
+        const auto* intQuants = this->cachedIntensiveQuantities(globalIdx, timeIdx);
+        if (intQuants)
+            intensiveQuantitiesSoa_.update(globalIdx, *intQuants);
+        else
+            intensiveQuantitiesSoa_.invalidate(globalIdx);
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::invalidateIntensiveQuantitiesCache
+     */
+    void invalidateIntensiveQuantitiesCache(unsigned timeIdx) const
+    {
+        ParentType::invalidateIntensiveQuantitiesCache(timeIdx);
+
+        if (enableIntensiveQuantitiesSoa_ && timeIdx == 0) {
+            // the number of DOFs changes if the grid was adapted
+            if (intensiveQuantitiesSoa_.size() != this->numGridDof())
+                intensiveQuantitiesSoa_.resize(this->numGridDof());
+            intensiveQuantitiesSoa_.invalidate();
+        }
+    }
+
+    /*!
+     * \copydoc FvBaseDiscretization::updateFailed
+     */
+    void updateFailed()
+    {
+        ParentType::updateFailed();
+
+        // the cached intensive quantities of the most recent time index now are the
+        // ones of the previous time step
+        if (enableIntensiveQuantitiesSoa_)
+            intensiveQuantitiesSoa_.invalidate();
+    }
+
     /*!
      * \brief Compute the total storage inside one phase of all
      *        conservation quantities.
@@ -207,7 +298,8 @@ public:
 
         storage = 0;
 
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(this->gridView());
+        typename ElementScheduler::Loop elemLoop(this->elementScheduler(),
+                                                 ThreadManager::maxThreads());
         std::mutex mutex;
 #ifdef _OPENMP
 #pragma omp parallel
@@ -217,14 +309,9 @@ public:
             // moved in front of the #pragma!
             unsigned threadId = ThreadManager::threadId();
             ElementContext elemCtx(this->simulator_);
-            ElementIterator elemIt = threadedElemIt.beginParallel();
             EqVector tmp;
 
-            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
-                const Element& elem = *elemIt;
-                if (elem.partitionType() != Dune::InteriorEntity)
-                    continue; // ignore ghost and overlap elements
-
+            elemLoop.forEach(threadId, [&](const Element& elem) {
                 elemCtx.updateStencil(elem);
                 elemCtx.updateIntensiveQuantities(/*timeIdx=*/0);
 
@@ -246,7 +333,7 @@ public:
                     storage += tmp;
                     mutex.unlock();
                 }
-            }
+            });
         }
 
         storage = this->gridView_.comm().sum(storage);
@@ -264,6 +351,12 @@ public:
 private:
     const Implementation& asImp_() const
     { return *static_cast<const Implementation *>(this); }
+
+    // the entries of the structure of arrays are not touched when the time level is
+    // advanced: the cached intensive quantities of the most recent time index then
+    // refer to the ones of the previous time index, i.e., they stay the same.
+    mutable IntensiveQuantitiesSoa intensiveQuantitiesSoa_;
+    bool enableIntensiveQuantitiesSoa_;
 };
 } // namespace Opm
 
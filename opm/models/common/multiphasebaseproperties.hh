@@ -80,6 +80,10 @@ struct EnableGravity { using type = UndefinedProperty; };
 //! Enable diffusive fluxes?
 template<class TypeTag, class MyTypeTag>
 struct EnableDiffusion { using type = UndefinedProperty; };
+//! Specifies whether the quantities of the cached intensive quantities which are
+//! required for the flux computations are also stored as a structure of arrays
+template<class TypeTag, class MyTypeTag>
+struct EnableIntensiveQuantitiesSoa { using type = UndefinedProperty; };
 
 } // namespace Opm::Properties
 
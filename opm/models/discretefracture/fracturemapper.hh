@@ -30,34 +30,26 @@
 #include <opm/models/utils/propertysystem.hh>
 
 #include <algorithm>
-#include <set>
+#include <cassert>
+#include <utility>
+#include <vector>
 
 namespace Opm {
 
 /*!
  * \ingroup DiscreteFractureModel
  * \brief Stores the topology of fractures.
+ *
+ * The fracture edges are first collected using addFractureEdge(). Afterwards, finalize()
+ * must be called, which converts them to a read-only representation: A bitmap which
+ * specifies whether a vertex is cut by a fracture and, for each vertex, the sorted list
+ * of vertices to which it is connected by a fracture edge (compressed row storage
+ * format). With this, the queries neither need to search a tree nor to allocate memory,
+ * so they are cheap and can be used concurrently by multiple threads.
  */
 template <class TypeTag>
 class FractureMapper
 {
-    struct FractureEdge
-    {
-        FractureEdge(unsigned edgeVertex1Idx, unsigned edgeVertex2Idx)
-            : i_(std::min(edgeVertex1Idx, edgeVertex2Idx)),
-              j_(std::max(edgeVertex1Idx, edgeVertex2Idx))
-        {}
-
-        bool operator<(const FractureEdge& e) const
-        { return i_ < e.i_ || (i_ == e.i_ && j_ < e.j_); }
-
-        bool operator==(const FractureEdge& e) const
-        { return i_ == e.i_ && j_ == e.j_; }
-
-        unsigned i_;
-        unsigned j_;
-    };
-
 public:
     /*!
      * \brief Constructor
@@ -68,14 +60,65 @@ public:
     /*!
      * \brief Marks an edge as having a fracture.
      *
+     * The edge only becomes visible for the queries after finalize() has been called.
+     * Until then, the mapper must not be queried.
+     *
      * \param vertexIdx1 The index of the edge's first vertex.
      * \param vertexIdx2 The index of the edge's second vertex.
      */
     void addFractureEdge(unsigned vertexIdx1, unsigned vertexIdx2)
     {
-        fractureEdges_.insert(FractureEdge(vertexIdx1, vertexIdx2));
-        fractureVertices_.insert(vertexIdx1);
-        fractureVertices_.insert(vertexIdx2);
+        newEdges_.emplace_back(vertexIdx1, vertexIdx2);
+        newEdges_.emplace_back(vertexIdx2, vertexIdx1);
+    }
+
+    /*!
+     * \brief Build the tables which are used by the queries from the fracture edges
+     *        which have been added so far.
+     *
+     * \param numVertices The total number of vertices of the grid. The indices of all
+     *                    fracture vertices must be smaller than this.
+     */
+    void finalize(unsigned numVertices)
+    {
+        // also keep the edges which have been added by a previous call
+        for (unsigned vertexIdx = 0; vertexIdx < isFractureVertex_.size(); ++vertexIdx)
+            for (unsigned i = edgeOffsets_[vertexIdx]; i < edgeOffsets_[vertexIdx + 1]; ++i)
+                newEdges_.emplace_back(vertexIdx, fractureNeighbors_[i]);
+
+        std::sort(newEdges_.begin(), newEdges_.end());
+        newEdges_.erase(std::unique(newEdges_.begin(), newEdges_.end()), newEdges_.end());
+
+        isFractureVertex_.assign(numVertices, false);
+        edgeOffsets_.assign(numVertices + 1, 0);
+        fractureNeighbors_.resize(newEdges_.size());
+        for (size_t i = 0; i < newEdges_.size(); ++i) {
+            const auto& edge = newEdges_[i];
+            assert(edge.first < numVertices && edge.second < numVertices);
+
+            isFractureVertex_[edge.first] = true;
+            ++ edgeOffsets_[edge.first + 1];
+            fractureNeighbors_[i] = edge.second;
+        }
+        for (unsigned vertexIdx = 0; vertexIdx < numVertices; ++vertexIdx)
+            edgeOffsets_[vertexIdx + 1] += edgeOffsets_[vertexIdx];
+
+        std::vector<std::pair<unsigned, unsigned> >().swap(newEdges_);
+    }
+
+    /*!
+     * \brief Returns the number of vertices which are known to the mapper.
+     */
+    unsigned numVertices() const
+    { return static_cast<unsigned>(isFractureVertex_.size()); }
+
+    /*!
+     * \brief Returns the number of fracture edges.
+     */
+    unsigned numFractureEdges() const
+    {
+        assert(isFinalized_());
+        return static_cast<unsigned>(fractureNeighbors_.size()/2);
     }
 
     /*!
@@ -84,7 +127,10 @@ public:
      * \param vertexIdx The index of the vertex.
      */
     bool isFractureVertex(unsigned vertexIdx) const
-    { return fractureVertices_.count(vertexIdx) > 0; }
+    {
+        assert(isFinalized_());
+        return vertexIdx < numVertices() && isFractureVertex_[vertexIdx];
+    }
 
     /*!
      * \brief Returns true iff a fracture is associated with a given edge.
@@ -94,13 +140,57 @@ public:
      */
     bool isFractureEdge(unsigned vertex1Idx, unsigned vertex2Idx) const
     {
-        FractureEdge tmp(vertex1Idx, vertex2Idx);
-        return fractureEdges_.count(tmp) > 0;
+        // most edges are rejected by the bitmap. otherwise, the fracture vertex usually
+        // only has very few fracture neighbors, so a linear search is the cheapest way
+        // to find the edge.
+        assert(isFinalized_());
+        if (!isFractureVertex(vertex1Idx) || !isFractureVertex(vertex2Idx))
+            return false;
+
+        const unsigned* it = fractureNeighbors_.data() + edgeOffsets_[vertex1Idx];
+        const unsigned* endIt = fractureNeighbors_.data() + edgeOffsets_[vertex1Idx + 1];
+        return std::find(it, endIt, vertex2Idx) != endIt;
+    }
+
+    /*!
+     * \brief Returns the number of fracture edges which are attached to a vertex.
+     *
+     * \param vertexIdx The index of the vertex.
+     */
+    unsigned numFractureNeighbors(unsigned vertexIdx) const
+    {
+        assert(isFinalized_());
+        if (vertexIdx >= numVertices())
+            return 0;
+        return edgeOffsets_[vertexIdx + 1] - edgeOffsets_[vertexIdx];
+    }
+
+    /*!
+     * \brief Returns the index of the vertex at the other end of a fracture edge which
+     *        is attached to a vertex.
+     *
+     * \param vertexIdx The index of the vertex.
+     * \param neighborIdx The local index of the fracture edge. It must be smaller than
+     *                    numFractureNeighbors(vertexIdx).
+     */
+    unsigned fractureNeighbor(unsigned vertexIdx, unsigned neighborIdx) const
+    {
+        assert(neighborIdx < numFractureNeighbors(vertexIdx));
+        return fractureNeighbors_[edgeOffsets_[vertexIdx] + neighborIdx];
     }
 
 private:
-    std::set<FractureEdge> fractureEdges_;
-    std::set<unsigned> fractureVertices_;
+    // returns true if all edges which have been added are visible for the queries
+    bool isFinalized_() const
+    { return newEdges_.empty(); }
+
+    // the edges which have been added since the last call to finalize(). each edge is
+    // stored for both directions.
+    std::vector<std::pair<unsigned, unsigned> > newEdges_;
+
+    std::vector<bool> isFractureVertex_;
+    std::vector<unsigned> edgeOffsets_;
+    std::vector<unsigned> fractureNeighbors_;
 };
 
 } // namespace Opm
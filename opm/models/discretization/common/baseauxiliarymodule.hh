@@ -99,6 +99,10 @@ public:
     /*!
      * \brief Specify the additional neighboring correlations caused by the auxiliary
      *        module.
+     *
+     * The sets passed to this method only contain the connections added by the
+     * auxiliary modules, not the ones caused by the grid. They are merged into the
+     * sparsity pattern of the Jacobian matrix afterwards.
      */
     virtual void addNeighbors(std::vector<NeighborSet>& neighbors) const = 0;
 
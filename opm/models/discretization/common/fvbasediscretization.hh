@@ -46,14 +46,17 @@
 #include "fvbaseintensivequantities.hh"
 #include "fvbaseextensivequantities.hh"
 #include "baseauxiliarymodule.hh"
+#include "reorderedmapper.hh"
 
 #include <opm/models/parallel/gridcommhandles.hh>
 #include <opm/models/parallel/threadmanager.hh>
+#include <opm/models/parallel/threadedelementscheduler.hh>
 #include <opm/simulators/linalg/nullborderlistmanager.hh>
 #include <opm/models/utils/simulator.hh>
 #include <opm/models/utils/alignedallocator.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
+#include <opm/models/io/restart.hh>
 #include <opm/models/io/vtkprimaryvarsmodule.hh>
 #include <opm/simulators/linalg/matrixblock.hh>
 
@@ -74,8 +77,12 @@
 #include <dune/fem/misc/capabilities.hh>
 #endif
 
+#include <array>
+#include <cstdint>
+#include <exception>
 #include <limits>
 #include <list>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -95,12 +102,12 @@ struct Simulator<TypeTag, TTag::FvBaseDiscretization> { using type = Opm::Simula
 //! Mapper for the grid view's vertices.
 template<class TypeTag>
 struct VertexMapper<TypeTag, TTag::FvBaseDiscretization>
-{ using type = Dune::MultipleCodimMultipleGeomTypeMapper<GetPropType<TypeTag, Properties::GridView>>; };
+{ using type = Opm::ReorderedMapper<GetPropType<TypeTag, Properties::GridView>>; };
 
 //! Mapper for the grid view's elements.
 template<class TypeTag>
 struct ElementMapper<TypeTag, TTag::FvBaseDiscretization>
-{ using type = Dune::MultipleCodimMultipleGeomTypeMapper<GetPropType<TypeTag, Properties::GridView>>; };
+{ using type = Opm::ReorderedMapper<GetPropType<TypeTag, Properties::GridView>>; };
 
 //! marks the border indices (required for the algebraic overlap stuff)
 template<class TypeTag>
@@ -220,6 +227,8 @@ template<class TypeTag>
 struct ThreadsPerProcess<TypeTag, TTag::FvBaseDiscretization> { static constexpr int value = 1; };
 template<class TypeTag>
 struct UseLinearizationLock<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = true; };
+template<class TypeTag>
+struct UseLinearizationColoring<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
 
 /*!
  * \brief Linearizer for the global system of equations.
@@ -265,10 +274,42 @@ struct EnableAsyncVtkOutput<TypeTag, TTag::FvBaseDiscretization> { static conste
 template<class TypeTag>
 struct VtkOutputFormat<TypeTag, TTag::FvBaseDiscretization> { static constexpr int value = Dune::VTK::ascii; };
 
+//! By default, use Dune::VTKWriter to write the VTK files
+template<class TypeTag>
+struct EnableVtkStaticGrid<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
+//! By default, a single thread writes the VTK files
+template<class TypeTag>
+struct VtkOutputThreads<TypeTag, TTag::FvBaseDiscretization> { static constexpr unsigned value = 1; };
+
+//! Do not compress the VTK files by default
+template<class TypeTag>
+struct EnableVtkCompression<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
+//! By default, the simulation may run ahead of the VTK output by two time steps
+template<class TypeTag>
+struct VtkMaxPendingOutputs<TypeTag, TTag::FvBaseDiscretization> { static constexpr unsigned value = 2; };
+
+//! By default, the output is written to VTK files
+template<class TypeTag>
+struct EnableXdmfOutput<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
+//! By default, the solution is written after every time step
+template<class TypeTag>
+struct VtkOutputInterval<TypeTag, TTag::FvBaseDiscretization> { static constexpr unsigned value = 1; };
+
 // disable caching the storage term by default
 template<class TypeTag>
 struct EnableStorageCache<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
 
+// disable caching the element stencils by default
+template<class TypeTag>
+struct EnableStencilCache<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
+
+// number the degrees of freedom like the grid does by default
+template<class TypeTag>
+struct DofOrdering<TypeTag, TTag::FvBaseDiscretization> { static constexpr auto value = "none"; };
+
 // disable constraints by default
 template<class TypeTag>
 struct EnableConstraints<TypeTag, TTag::FvBaseDiscretization> { static constexpr bool value = false; };
@@ -374,6 +415,7 @@ class FvBaseDiscretization
 
     using Element = typename GridView::template Codim<0>::Entity;
     using ElementIterator = typename GridView::template Codim<0>::Iterator;
+    using ElementScheduler = Opm::ThreadedElementScheduler<GridView>;
 
     using Toolbox = Opm::MathToolbox<Evaluation>;
     using VectorBlock = Dune::FieldVector<Evaluation, numEq>;
@@ -426,8 +468,10 @@ public:
     FvBaseDiscretization(Simulator& simulator)
         : simulator_(simulator)
         , gridView_(simulator.gridView())
-        , elementMapper_(gridView_, Dune::mcmgElementLayout())
-        , vertexMapper_(gridView_, Dune::mcmgVertexLayout())
+        , elementMapper_(gridView_, Dune::mcmgElementLayout(),
+                         EWOMS_GET_PARAM(TypeTag, std::string, DofOrdering))
+        , vertexMapper_(gridView_, Dune::mcmgVertexLayout(),
+                        EWOMS_GET_PARAM(TypeTag, std::string, DofOrdering))
         , newtonMethod_(simulator)
         , localLinearizer_(ThreadManager::maxThreads())
         , linearizer_(new Linearizer())
@@ -440,6 +484,7 @@ public:
         , enableIntensiveQuantityCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableIntensiveQuantityCache))
         , enableStorageCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache))
         , enableThermodynamicHints_(EWOMS_GET_PARAM(TypeTag, bool, EnableThermodynamicHints))
+        , enableStencilCache_(EWOMS_GET_PARAM(TypeTag, bool, EnableStencilCache))
     {
 #if HAVE_DUNE_FEM
         if (enableGridAdaptation_ && !Dune::Fem::Capabilities::isLocallyAdaptive<Grid>::v)
@@ -456,7 +501,14 @@ public:
                                         "element-centered finite volume discretization (is: "
                                         +Dune::className<Discretization>()+")");
 
+        // the solution is transferred between grids using the numbering of dune-fem's
+        // discrete function space which does not know about the reordering
+        if (enableGridAdaptation_ && elementMapper_.isReordered())
+            throw std::invalid_argument("Grid adaptation cannot be combined with reordering "
+                                        "the degrees of freedom");
+
         enableStorageCache_ = EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache);
+        stencilCacheSequenceNumber_ = -1;
 
         size_t numDof = asImp_().numGridDof();
         for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
@@ -464,12 +516,18 @@ public:
 
             if (storeIntensiveQuantities()) {
                 intensiveQuantityCache_[timeIdx].resize(numDof);
-                intensiveQuantityCacheUpToDate_[timeIdx].resize(numDof, /*value=*/false);
+                intensiveQuantityCacheStamp_[timeIdx].resize(numDof, /*value=*/0);
             }
+            intensiveQuantityCacheSlot_[timeIdx] = timeIdx;
+            intensiveQuantityCacheEpoch_[timeIdx] = 1;
 
             if (enableStorageCache_)
                 storageCache_[timeIdx].resize(numDof);
         }
+        if (storeIntensiveQuantities())
+            intensiveQuantityCacheUnshared_.resize(numDof, /*value=*/0);
+        intensiveQuantityCacheSharingEpoch_ = 0;
+        intensiveQuantityCacheSharing_ = false;
 
         resizeAndResetIntensiveQuantitiesCache_();
         asImp_().registerOutputModules_();
@@ -507,7 +565,10 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableThermodynamicHints, "Enable thermodynamic hints");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableIntensiveQuantityCache, "Turn on caching of intensive quantities");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStorageCache, "Store previous storage terms and avoid re-calculating them.");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableStencilCache, "Compute the finite volume geometry of each element only once per grid.");
         EWOMS_REGISTER_PARAM(TypeTag, std::string, OutputDir, "The directory to which result files are written");
+        EWOMS_REGISTER_PARAM(TypeTag, std::string, DofOrdering,
+                             "The numbering of the degrees of freedom. Possible values: 'none', 'rcm' and 'hilbert'");
     }
 
     /*!
@@ -515,6 +576,10 @@ public:
      */
     void finishInit()
     {
+        // (re-)compute the stencils of all elements if they ought to be cached. this
+        // needs to happen first because all element contexts use the cache.
+        updateStencilCache_();
+
         // initialize the volume of the finite volumes to zero
         size_t numDof = asImp_().numGridDof();
         dofTotalVolume_.resize(numDof);
@@ -576,7 +641,7 @@ public:
         if (storeIntensiveQuantities()) {
             // invalidate all cached intensive quantities
             for (unsigned timeIdx = 0; timeIdx < historySize; ++ timeIdx)
-                invalidateIntensiveQuantitiesCache(timeIdx);
+                asImp_().invalidateIntensiveQuantitiesCache(timeIdx);
         }
 
         newtonMethod_.finishInit();
@@ -703,8 +768,7 @@ public:
      */
     const IntensiveQuantities* cachedIntensiveQuantities(unsigned globalIdx, unsigned timeIdx) const
     {
-        if (!enableIntensiveQuantityCache_ ||
-            !intensiveQuantityCacheUpToDate_[timeIdx][globalIdx])
+        if (!enableIntensiveQuantityCache_)
             return 0;
 
         if (timeIdx > 0 && enableStorageCache_)
@@ -712,7 +776,15 @@ public:
             // recent time step are cached!
             return 0;
 
-        return &intensiveQuantityCache_[timeIdx][globalIdx];
+        // after the time level has been advanced, the objects of the most recent time
+        // index are the ones of the previous time index until they are modified
+        if (timeIdx == 0 && intQuantsShared_(globalIdx))
+            timeIdx = 1;
+
+        if (!intQuantsUpToDate_(globalIdx, timeIdx))
+            return 0;
+
+        return &intQuantsCache_(timeIdx)[globalIdx];
     }
 
     /*!
@@ -730,8 +802,13 @@ public:
         if (!storeIntensiveQuantities())
             return;
 
-        intensiveQuantityCache_[timeIdx][globalIdx] = intQuants;
-        intensiveQuantityCacheUpToDate_[timeIdx][globalIdx] = true;
+        if (timeIdx == 0)
+            setIntQuantsUnshared_(globalIdx);
+        else if (timeIdx == 1)
+            unshareCachedIntensiveQuantities_(globalIdx);
+
+        intQuantsCache_(timeIdx)[globalIdx] = intQuants;
+        setIntQuantsUpToDate_(globalIdx, timeIdx, true);
     }
 
     /*!
@@ -748,27 +825,43 @@ public:
         if (!storeIntensiveQuantities())
             return;
 
-        intensiveQuantityCacheUpToDate_[timeIdx][globalIdx] = newValue;
+        if (timeIdx == 0 && !newValue)
+            // the shared object does not need to be copied if it becomes invalid anyway
+            setIntQuantsUnshared_(globalIdx);
+        else if (timeIdx <= 1)
+            unshareCachedIntensiveQuantities_(globalIdx);
+
+        setIntQuantsUpToDate_(globalIdx, timeIdx, newValue);
     }
 
     /*!
      * \brief Invalidate the whole intensive quantity cache for time index.
      *
+     * This is a constant time operation unless the intensive quantities of the most
+     * recent time index refer to the ones of the previous time index and the latter are
+     * invalidated.
+     *
      * \param timeIdx The index used by the time discretization.
      */
     void invalidateIntensiveQuantitiesCache(unsigned timeIdx) const
     {
         if (storeIntensiveQuantities()) {
-            std::fill(intensiveQuantityCacheUpToDate_[timeIdx].begin(),
-                      intensiveQuantityCacheUpToDate_[timeIdx].end(),
-                      /*value=*/false);
+            if (timeIdx == 0)
+                intensiveQuantityCacheSharing_ = false;
+            else if (timeIdx == 1)
+                unshareCachedIntensiveQuantities_();
+
+            invalidateIntQuantsSlot_(intensiveQuantityCacheSlot_[timeIdx]);
         }
     }
 
     /*!
      * \brief Move the intensive quantities for a given time index to the back.
      *
-     * This method should only be called by the time discretization.
+     * This method should only be called by the time discretization. Shifting the cache
+     * by a single slot does not copy any intensive quantities: The slots of the cache
+     * are rotated, and the objects of the most recent time index refer to the ones of
+     * the previous time index until they get updated.
      *
      * \param numSlots The number of time step slots for which the
      *                 hints should be shifted.
@@ -787,9 +880,27 @@ public:
 
         assert(numSlots > 0);
 
-        for (unsigned timeIdx = 0; timeIdx < historySize - numSlots; ++ timeIdx) {
-            intensiveQuantityCache_[timeIdx + numSlots] = intensiveQuantityCache_[timeIdx];
-            intensiveQuantityCacheUpToDate_[timeIdx + numSlots] = intensiveQuantityCacheUpToDate_[timeIdx];
+        // the objects of the most recent time index must not refer to the ones of the
+        // previous time index anymore, because the latter are moved to the back
+        unshareCachedIntensiveQuantities_();
+
+        if (numSlots == 1) {
+            // recycle the slot of the oldest time index for the most recent one
+            unsigned recycledSlot = intensiveQuantityCacheSlot_[historySize - 1];
+            for (unsigned timeIdx = historySize - 1; timeIdx > 0; -- timeIdx)
+                intensiveQuantityCacheSlot_[timeIdx] = intensiveQuantityCacheSlot_[timeIdx - 1];
+            intensiveQuantityCacheSlot_[0] = recycledSlot;
+
+            shareCachedIntensiveQuantities_();
+        }
+        else {
+            for (unsigned timeIdx = historySize - numSlots; timeIdx-- > 0; ) {
+                unsigned srcSlot = intensiveQuantityCacheSlot_[timeIdx];
+                unsigned destSlot = intensiveQuantityCacheSlot_[timeIdx + numSlots];
+                intensiveQuantityCache_[destSlot] = intensiveQuantityCache_[srcSlot];
+                intensiveQuantityCacheStamp_[destSlot] = intensiveQuantityCacheStamp_[srcSlot];
+                intensiveQuantityCacheEpoch_[destSlot] = intensiveQuantityCacheEpoch_[srcSlot];
+            }
         }
 
         // the cache for the most recent time indices do not need to be invalidated
@@ -797,6 +908,32 @@ public:
         // no post-processing of the solution after a time step! fix it?)
     }
 
+    /*!
+     * \brief Returns the cached stencil of an element.
+     *
+     * If the stencil cache is disabled or if no up-to-date stencil is available for the
+     * element, this method returns 0.
+     *
+     * \param elem The element for which the stencil is requested.
+     */
+    const Stencil* cachedStencil(const Element& elem) const
+    {
+        if (!enableStencilCache_)
+            return 0;
+
+        unsigned elemIdx = static_cast<unsigned>(elementMapper_.index(elem));
+        if (elemIdx >= stencilCache_.size())
+            return 0;
+
+        return &stencilCache_[elemIdx];
+    }
+
+    /*!
+     * \brief Returns true iff the stencils of all elements are cached.
+     */
+    bool enableStencilCache() const
+    { return enableStencilCache_; }
+
     /*!
      * \brief Returns true iff the storage term is cached.
      *
@@ -875,8 +1012,27 @@ public:
     {
         dest = 0;
 
-        std::mutex mutex;
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_);
+        // if each DOF is written by a single element, i.e., if each element exhibits a
+        // single primary DOF like for the element centered finite volume method, the
+        // residuals of the elements can be scattered directly into the result.
+        // otherwise, each thread accumulates into its own buffer and the buffers are
+        // added up afterwards.
+        static constexpr bool directScatter = std::is_same<Discretization, EcfvDiscretization<TypeTag> >::value;
+        unsigned numThreads = ThreadManager::maxThreads();
+        bool useThreadBuffers = !directScatter && numThreads > 1;
+        if (useThreadBuffers) {
+            // OpenMP may start fewer threads than requested, so all buffers must be
+            // ready before the parallel region even if no thread writes into them
+            threadResiduals_.resize(numThreads - 1);
+            for (auto& threadResidual : threadResiduals_) {
+                threadResidual.resize(dest.size());
+                threadResidual = 0.0;
+            }
+        }
+
+        std::mutex exceptionLock;
+        std::exception_ptr exceptionPtr = nullptr;
+        typename ElementScheduler::Loop elemLoop(elementScheduler(), numThreads);
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -885,30 +1041,50 @@ public:
             // moved in front of the #pragma!
             unsigned threadId = ThreadManager::threadId();
             ElementContext elemCtx(simulator_);
-            ElementIterator elemIt = threadedElemIt.beginParallel();
-            LocalEvalBlockVector residual, storageTerm;
-
-            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
-                const Element& elem = *elemIt;
-                if (elem.partitionType() != Dune::InteriorEntity)
-                    continue;
-
-                elemCtx.updateAll(elem);
-                residual.resize(elemCtx.numDof(/*timeIdx=*/0));
-                storageTerm.resize(elemCtx.numPrimaryDof(/*timeIdx=*/0));
-                asImp_().localResidual(threadId).eval(residual, elemCtx);
-
-                size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
-                mutex.lock();
-                for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
-                    unsigned globalI = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
-                    for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
-                        dest[globalI][eqIdx] += Toolbox::value(residual[dofIdx][eqIdx]);
-                }
-                mutex.unlock();
+            LocalEvalBlockVector residual;
+
+            // the first thread uses the result vector as its buffer
+            GlobalEqVector* threadDest = &dest;
+            if (useThreadBuffers && threadId > 0)
+                threadDest = &threadResiduals_[threadId - 1];
+
+            try {
+                elemLoop.forEach(threadId, [&](const Element& elem) {
+                    elemCtx.updateAll(elem);
+                    residual.resize(elemCtx.numDof(/*timeIdx=*/0));
+                    asImp_().localResidual(threadId).eval(residual, elemCtx);
+
+                    size_t numPrimaryDof = elemCtx.numPrimaryDof(/*timeIdx=*/0);
+                    for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx) {
+                        unsigned globalI = elemCtx.globalSpaceIndex(dofIdx, /*timeIdx=*/0);
+                        for (unsigned eqIdx = 0; eqIdx < numEq; ++ eqIdx)
+                            (*threadDest)[globalI][eqIdx] += Toolbox::value(residual[dofIdx][eqIdx]);
+                    }
+                });
+            }
+            catch (...) {
+                elemLoop.setFinished();
+
+                std::lock_guard<std::mutex> take(exceptionLock);
+                exceptionPtr = std::current_exception();
+            }
+
+            if (useThreadBuffers) {
+                // add up the buffers of all threads. each thread takes care of a
+                // contiguous range of DOFs.
+#ifdef _OPENMP
+#pragma omp barrier
+#pragma omp for schedule(static)
+#endif
+                for (size_t globalI = 0; globalI < dest.size(); ++globalI)
+                    for (const auto& threadResidual : threadResiduals_)
+                        dest[globalI] += threadResidual[globalI];
             }
         }
 
+        if (exceptionPtr)
+            std::rethrow_exception(exceptionPtr);
+
         // add up the residuals on the process borders
         const auto sumHandle =
             GridCommHandleFactory::template sumHandle<EqVector>(dest, asImp_().dofMapper());
@@ -934,10 +1110,13 @@ public:
      */
     void globalStorage(EqVector& storage, unsigned timeIdx = 0) const
     {
-        storage = 0;
+        // each thread adds up the storage of its elements separately, the result is the
+        // sum of these partial sums
+        std::vector<EqVector> threadStorage(ThreadManager::maxThreads(), EqVector(0.0));
 
-        std::mutex mutex;
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView());
+        std::mutex exceptionLock;
+        std::exception_ptr exceptionPtr = nullptr;
+        typename ElementScheduler::Loop elemLoop(elementScheduler(), ThreadManager::maxThreads());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
@@ -946,34 +1125,45 @@ public:
             // moved in front of the #pragma!
             unsigned threadId = ThreadManager::threadId();
             ElementContext elemCtx(simulator_);
-            ElementIterator elemIt = threadedElemIt.beginParallel();
             LocalEvalBlockVector elemStorage;
+            EqVector localStorage(0.0);
 
             // in this method, we need to disable the storage cache because we want to
             // evaluate the storage term for other time indices than the most recent one
             elemCtx.setEnableStorageCache(false);
 
-            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
-                const Element& elem = *elemIt;
-                if (elem.partitionType() != Dune::InteriorEntity)
-                    continue; // ignore ghost and overlap elements
+            try {
+                elemLoop.forEach(threadId, [&](const Element& elem) {
+                    elemCtx.updateStencil(elem);
+                    elemCtx.updatePrimaryIntensiveQuantities(timeIdx);
 
-                elemCtx.updateStencil(elem);
-                elemCtx.updatePrimaryIntensiveQuantities(timeIdx);
+                    size_t numPrimaryDof = elemCtx.numPrimaryDof(timeIdx);
+                    elemStorage.resize(numPrimaryDof);
 
-                size_t numPrimaryDof = elemCtx.numPrimaryDof(timeIdx);
-                elemStorage.resize(numPrimaryDof);
+                    localResidual(threadId).evalStorage(elemStorage, elemCtx, timeIdx);
 
-                localResidual(threadId).evalStorage(elemStorage, elemCtx, timeIdx);
+                    for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx)
+                        for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
+                            localStorage[eqIdx] += Toolbox::value(elemStorage[dofIdx][eqIdx]);
+                });
+            }
+            catch (...) {
+                elemLoop.setFinished();
 
-                mutex.lock();
-                for (unsigned dofIdx = 0; dofIdx < numPrimaryDof; ++dofIdx)
-                    for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx)
-                        storage[eqIdx] += Toolbox::value(elemStorage[dofIdx][eqIdx]);
-                mutex.unlock();
+                std::lock_guard<std::mutex> take(exceptionLock);
+                exceptionPtr = std::current_exception();
             }
+
+            threadStorage[threadId] = localStorage;
         }
 
+        if (exceptionPtr)
+            std::rethrow_exception(exceptionPtr);
+
+        storage = 0;
+        for (const auto& localStorage : threadStorage)
+            storage += localStorage;
+
         storage = gridView_.comm().sum(storage);
     }
 
@@ -1352,6 +1542,9 @@ public:
                 // adapt the grid and load balance if necessary
                 adaptationManager().adapt();
 
+                // the cached stencils refer to the old grid
+                stencilCache_.clear();
+
                 // if the grid has potentially changed, we need to re-create the
                 // supporting data structures.
                 elementMapper_.update();
@@ -1391,7 +1584,13 @@ public:
         // previous time step so that we can start the next
         // update at a physically meaningful solution.
         solution(/*timeIdx=*/0) = solution(/*timeIdx=*/1);
-        invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
+
+        // the intensive quantities of the previous time step are thus also the ones of
+        // the most recent time index. this is only possible if they are cached.
+        if (storeIntensiveQuantities() && !enableStorageCache())
+            shareCachedIntensiveQuantities_();
+        else
+            invalidateIntensiveQuantitiesCache(/*timeIdx=*/0);
 
 #ifndef NDEBUG
         for (unsigned timeIdx = 0; timeIdx < historySize; ++timeIdx) {
@@ -1473,7 +1672,7 @@ public:
         }
 
         for (unsigned eqIdx = 0; eqIdx < numEq; ++eqIdx) {
-            outstream << solution(/*timeIdx=*/0)[dofIdx][eqIdx] << " ";
+            Restart::serializeValue(outstream, solution(/*timeIdx=*/0)[dofIdx][eqIdx]);
         }
     }
 
@@ -1495,7 +1694,7 @@ public:
             if (!instream.good())
                 throw std::runtime_error("Could not deserialize degree of freedom "
                                          +std::to_string(dofIdx));
-            instream >> solution(/*timeIdx=*/0)[dofIdx][eqIdx];
+            Restart::deserializeValue(instream, solution(/*timeIdx=*/0)[dofIdx][eqIdx]);
         }
     }
 
@@ -1699,42 +1898,52 @@ public:
      */
     void prepareOutputFields() const
     {
+        // only the modules which write any field need to look at the elements
+        std::vector<BaseOutputModule<TypeTag>*> activeModules;
         bool needFullContextUpdate = false;
         auto modIt = outputModules_.begin();
         const auto& modEndIt = outputModules_.end();
         for (; modIt != modEndIt; ++modIt) {
             (*modIt)->allocBuffers();
+            if (!(*modIt)->needElementContext())
+                continue;
+
+            activeModules.push_back(*modIt);
             needFullContextUpdate = needFullContextUpdate || (*modIt)->needExtensiveQuantities();
         }
 
-        // iterate over grid
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView());
+        if (activeModules.empty())
+            return;
+
+        const auto& outputRegion = simulator_.problem().outputRegion();
+
+        // iterate over the interior elements of the grid
+        typename ElementScheduler::Loop elemLoop(elementScheduler(), ThreadManager::maxThreads());
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
             ElementContext elemCtx(simulator_);
-            ElementIterator elemIt = threadedElemIt.beginParallel();
-            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
-                const auto& elem = *elemIt;
-                if (elem.partitionType() != Dune::InteriorEntity)
-                    // ignore non-interior entities
-                    continue;
-
-                if (needFullContextUpdate)
-                    elemCtx.updateAll(elem);
+            elemLoop.forEach(ThreadManager::threadId(), [&](const Element& elem) {
+                if (outputRegion && !outputRegion(elem))
+                    return;
+
+                if (needFullContextUpdate) {
+                    // the output only refers to the most recent solution, so the
+                    // quantities of the previous time steps are not required. the
+                    // intensive quantities are taken from the cache if it is enabled.
+                    elemCtx.updateStencil(elem);
+                    elemCtx.updateIntensiveQuantities(/*timeIdx=*/0);
+                    elemCtx.updateExtensiveQuantities(/*timeIdx=*/0);
+                }
                 else {
                     elemCtx.updatePrimaryStencil(elem);
                     elemCtx.updatePrimaryIntensiveQuantities(/*timeIdx=*/0);
                 }
 
-                // we cannot reuse the "modIt" variable here because the code here might
-                // be threaded and "modIt" is is the same for all threads, i.e., if a
-                // given thread modifies it, the changes affect all threads.
-                auto modIt2 = outputModules_.begin();
-                for (; modIt2 != modEndIt; ++modIt2)
-                    (*modIt2)->processElement(elemCtx);
-            }
+                for (auto* module : activeModules)
+                    module->processElement(elemCtx);
+            });
         }
     }
 
@@ -1756,6 +1965,21 @@ public:
     const GridView& gridView() const
     { return gridView_; }
 
+    /*!
+     * \brief Returns the object which distributes the elements of the grid amongst the
+     *        threads of an OpenMP parallel region.
+     *
+     * The element seeds stored by the scheduler are automatically updated if the grid
+     * has changed. This method must thus only be called in a sequential context. The
+     * elements are handed out in the order of the element mapper's indices.
+     */
+    const ElementScheduler& elementScheduler() const
+    {
+        elementScheduler_.update(gridView_, simulator_.vanguard().gridSequenceNumber(),
+                                 elementMapper_);
+        return elementScheduler_;
+    }
+
     /*!
      * \brief Add a module for an auxiliary equation.
      *
@@ -1852,6 +2076,118 @@ public:
     { return updateTimer_; }
 
 protected:
+    void updateStencilCache_()
+    {
+        if (!enableStencilCache_)
+            return;
+
+        int seqNum = simulator_.vanguard().gridSequenceNumber();
+        if (!stencilCache_.empty() && seqNum == stencilCacheSequenceNumber_)
+            return;
+
+        stencilCache_.clear();
+        stencilCacheSequenceNumber_ = seqNum;
+
+        // the cached stencils are stored in the order of the element indices. since
+        // stencils cannot be moved once they are updated, we first need to find the
+        // element for each index.
+        using ElementSeed = typename Grid::template Codim<0>::EntitySeed;
+        std::vector<ElementSeed> elemSeeds(elementMapper_.size());
+        ElementIterator elemIt = gridView_.template begin</*codim=*/0>();
+        const ElementIterator& elemEndIt = gridView_.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt)
+            elemSeeds[static_cast<size_t>(elementMapper_.index(*elemIt))] = elemIt->seed();
+
+        const auto& grid = gridView_.grid();
+        stencilCache_.reserve(elemSeeds.size());
+        for (const auto& elemSeed : elemSeeds) {
+            stencilCache_.emplace_back(gridView_, asImp_().dofMapper());
+            stencilCache_.back().update(grid.entity(elemSeed));
+        }
+    }
+
+    // returns the slot of the intensive quantity cache for a given time index
+    IntensiveQuantitiesVector& intQuantsCache_(unsigned timeIdx) const
+    { return intensiveQuantityCache_[intensiveQuantityCacheSlot_[timeIdx]]; }
+
+    // an entry of the intensive quantity cache is up to date if its stamp matches the
+    // epoch of its slot. invalidating a whole slot thus only requires to start a new
+    // epoch.
+    bool intQuantsUpToDate_(unsigned globalIdx, unsigned timeIdx) const
+    {
+        unsigned slot = intensiveQuantityCacheSlot_[timeIdx];
+        return intensiveQuantityCacheStamp_[slot][globalIdx] == intensiveQuantityCacheEpoch_[slot];
+    }
+
+    void setIntQuantsUpToDate_(unsigned globalIdx, unsigned timeIdx, bool upToDate) const
+    {
+        unsigned slot = intensiveQuantityCacheSlot_[timeIdx];
+        intensiveQuantityCacheStamp_[slot][globalIdx] = upToDate ? intensiveQuantityCacheEpoch_[slot] : 0;
+    }
+
+    void invalidateIntQuantsSlot_(unsigned slot) const
+    {
+        // the stamp 0 is never valid. if the epochs are exhausted, the stamps need to be
+        // reset explicitly
+        if (++ intensiveQuantityCacheEpoch_[slot] == 0) {
+            std::fill(intensiveQuantityCacheStamp_[slot].begin(),
+                      intensiveQuantityCacheStamp_[slot].end(),
+                      /*value=*/0);
+            intensiveQuantityCacheEpoch_[slot] = 1;
+        }
+    }
+
+    // the intensive quantities of the most recent time index for a DOF are shared with
+    // the ones of the previous time index if sharing is enabled and the DOF has not been
+    // unshared during the current sharing epoch
+    bool intQuantsShared_(unsigned globalIdx) const
+    {
+        return intensiveQuantityCacheSharing_
+            && intensiveQuantityCacheUnshared_[globalIdx] != intensiveQuantityCacheSharingEpoch_;
+    }
+
+    void setIntQuantsUnshared_(unsigned globalIdx) const
+    {
+        if (intensiveQuantityCacheSharing_)
+            intensiveQuantityCacheUnshared_[globalIdx] = intensiveQuantityCacheSharingEpoch_;
+    }
+
+    // let the intensive quantities of all DOFs for the most recent time index refer to
+    // the ones of the previous time index
+    void shareCachedIntensiveQuantities_() const
+    {
+        if (++ intensiveQuantityCacheSharingEpoch_ == 0) {
+            std::fill(intensiveQuantityCacheUnshared_.begin(),
+                      intensiveQuantityCacheUnshared_.end(),
+                      /*value=*/0);
+            intensiveQuantityCacheSharingEpoch_ = 1;
+        }
+        intensiveQuantityCacheSharing_ = true;
+    }
+
+    // give the intensive quantities of the most recent time index for a DOF their own
+    // copy if they are shared with the ones of the previous time index
+    void unshareCachedIntensiveQuantities_(unsigned globalIdx) const
+    {
+        if (!intQuantsShared_(globalIdx))
+            return;
+
+        intQuantsCache_(/*timeIdx=*/0)[globalIdx] = intQuantsCache_(/*timeIdx=*/1)[globalIdx];
+        setIntQuantsUpToDate_(globalIdx, /*timeIdx=*/0, intQuantsUpToDate_(globalIdx, /*timeIdx=*/1));
+        setIntQuantsUnshared_(globalIdx);
+    }
+
+    void unshareCachedIntensiveQuantities_() const
+    {
+        if (!intensiveQuantityCacheSharing_)
+            return;
+
+        size_t numDof = intensiveQuantityCacheUnshared_.size();
+        for (size_t globalIdx = 0; globalIdx < numDof; ++globalIdx)
+            unshareCachedIntensiveQuantities_(static_cast<unsigned>(globalIdx));
+        intensiveQuantityCacheSharing_ = false;
+    }
+
     void resizeAndResetIntensiveQuantitiesCache_()
     {
         // allocate the storage cache
@@ -1865,9 +2201,12 @@ protected:
         // allocate the intensive quantities cache
         if (storeIntensiveQuantities()) {
             size_t numDof = asImp_().numGridDof();
+            intensiveQuantityCacheUnshared_.assign(numDof, /*value=*/0);
+            intensiveQuantityCacheSharingEpoch_ = 0;
+            intensiveQuantityCacheSharing_ = false;
             for(unsigned timeIdx=0; timeIdx<historySize; ++timeIdx) {
                 intensiveQuantityCache_[timeIdx].resize(numDof);
-                intensiveQuantityCacheUpToDate_[timeIdx].resize(numDof);
+                intensiveQuantityCacheStamp_[timeIdx].assign(numDof, /*value=*/0);
                 invalidateIntensiveQuantitiesCache(timeIdx);
             }
         }
@@ -1921,6 +2260,9 @@ protected:
     ElementMapper elementMapper_;
     VertexMapper vertexMapper_;
 
+    // distributes the elements of the grid amongst threads
+    mutable ElementScheduler elementScheduler_;
+
     // a vector with all auxiliary equations to be considered
     std::vector<BaseAuxiliaryModule<TypeTag>*> auxEqModules_;
 
@@ -1940,7 +2282,19 @@ protected:
     // cur is the current iterative solution, prev the converged
     // solution of the previous time step
     mutable IntensiveQuantitiesVector intensiveQuantityCache_[historySize];
-    mutable std::vector<bool> intensiveQuantityCacheUpToDate_[historySize];
+    // the cached intensive quantities of a slot are up to date if their stamp matches
+    // the slot's epoch. in contrast to a std::vector<bool>, each entry can be written
+    // by a different thread.
+    mutable std::vector<uint32_t> intensiveQuantityCacheStamp_[historySize];
+    mutable std::array<uint32_t, historySize> intensiveQuantityCacheEpoch_;
+    // the slot of the arrays above which is used for a given time index
+    std::array<unsigned, historySize> intensiveQuantityCacheSlot_;
+    // specifies whether the cached intensive quantities for the most recent time index
+    // of a DOF are the ones of the previous time index. this is the case if sharing is
+    // enabled and the DOF's entry does not match the sharing epoch.
+    mutable std::vector<uint32_t> intensiveQuantityCacheUnshared_;
+    mutable uint32_t intensiveQuantityCacheSharingEpoch_;
+    mutable bool intensiveQuantityCacheSharing_;
 
     DiscreteFunctionSpace space_;
     mutable std::array< std::unique_ptr< DiscreteFunction >, historySize > solution_;
@@ -1959,10 +2313,19 @@ protected:
 
     mutable GlobalEqVector storageCache_[historySize];
 
+    // the buffers used by globalResidual() for all threads except the first one. they
+    // are kept to avoid allocating memory each time the residual is computed
+    mutable std::vector<GlobalEqVector> threadResiduals_;
+
+    // the stencils of all elements. this is only used if the stencil cache is enabled.
+    std::vector<Stencil> stencilCache_;
+    int stencilCacheSequenceNumber_;
+
     bool enableGridAdaptation_;
     bool enableIntensiveQuantityCache_;
     bool enableStorageCache_;
     bool enableThermodynamicHints_;
+    bool enableStencilCache_;
 };
 } // namespace Opm
 
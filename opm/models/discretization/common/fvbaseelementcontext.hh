@@ -32,6 +32,7 @@
 
 #include <opm/models/discretization/common/linearizationtype.hh>
 #include <opm/models/utils/alignedallocator.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <opm/material/common/Unused.hpp>
 #include <opm/material/common/Exceptions.hpp>
@@ -63,6 +64,9 @@ class FvBaseElementContext
 
     struct DofStore_ {
         IntensiveQuantities intensiveQuantities[timeDiscHistorySize];
+        // the object of the model's intensive quantities cache which is used instead of
+        // the one above. if this is a null pointer, the context's own object is used.
+        const IntensiveQuantities *cachedIntensiveQuantities[timeDiscHistorySize];
         PrimaryVariables priVars[timeDiscHistorySize];
         const IntensiveQuantities *thermodynamicHint[timeDiscHistorySize];
     };
@@ -98,6 +102,7 @@ public:
     {
         // remember the simulator object
         simulatorPtr_ = &simulator;
+        stencilPtr_ = &stencil_;
         enableStorageCache_ = EWOMS_GET_PARAM(TypeTag, bool, EnableStorageCache);
         stashedDofIdx_ = -1;
         focusDofIdx_ = -1;
@@ -134,14 +139,17 @@ public:
         // remember the current element
         elemPtr_ = &elem;
 
-        // update the stencil. the center gradients are quite expensive to calculate and
-        // most models don't need them, so that we only do this if the model explicitly
-        // enables them
-        stencil_.update(elem);
+        // update the stencil. if the stencils of all elements are cached by the model,
+        // there is nothing to compute.
+        stencilPtr_ = model().cachedStencil(elem);
+        if (!stencilPtr_) {
+            stencil_.update(elem);
+            stencilPtr_ = &stencil_;
+        }
 
         // resize the arrays containing the flux and the volume variables
-        dofVars_.resize(stencil_.numDof());
-        extensiveQuantities_.resize(stencil_.numInteriorFaces());
+        dofVars_.resize(stencilPtr_->numDof());
+        extensiveQuantities_.resize(stencilPtr_->numInteriorFaces());
     }
 
     /*!
@@ -157,6 +165,7 @@ public:
 
         // update the finite element geometry
         stencil_.updatePrimaryTopology(elem);
+        stencilPtr_ = &stencil_;
 
         dofVars_.resize(stencil_.numPrimaryDof());
     }
@@ -174,6 +183,7 @@ public:
 
         // update the finite element geometry
         stencil_.updateTopology(elem);
+        stencilPtr_ = &stencil_;
     }
 
     /*!
@@ -182,6 +192,8 @@ public:
      */
     void updateAllIntensiveQuantities()
     {
+        EWOMS_PROFILE_REGION("intensiveQuantities");
+
         if (!enableStorageCache_) {
             // if the storage cache is disabled, we need to calculate the storage term
             // from scratch, i.e. we need the intensive quantities of all of the history.
@@ -231,7 +243,10 @@ public:
      *        faces of the current element for all time indices.
      */
     void updateAllExtensiveQuantities()
-    { asImp_().updateExtensiveQuantities(/*timeIdx=*/0); }
+    {
+        EWOMS_PROFILE_REGION("extensiveQuantities");
+        asImp_().updateExtensiveQuantities(/*timeIdx=*/0);
+    }
 
     /*!
      * \brief Compute the extensive quantities of all sub-control volume
@@ -340,7 +355,7 @@ public:
      *                time discretization.
      */
     const Stencil& stencil(unsigned timeIdx OPM_UNUSED) const
-    { return stencil_; }
+    { return *stencilPtr_; }
 
     /*!
      * \brief Return the position of a local entities in global coordinates
@@ -351,7 +366,7 @@ public:
      *                time discretization.
      */
     const GlobalPosition& pos(unsigned dofIdx, unsigned timeIdx OPM_UNUSED) const
-    { return stencil_.subControlVolume(dofIdx).globalPos(); }
+    { return stencilPtr_->subControlVolume(dofIdx).globalPos(); }
 
     /*!
      * \brief Return the global spatial index for a sub-control volume
@@ -417,7 +432,10 @@ public:
                                    "for the most-recent substep (i.e. time index 0) are available!");
 #endif
 
-        return dofVars_[dofIdx].intensiveQuantities[timeIdx];
+        const auto& dofVars = dofVars_[dofIdx];
+        if (dofVars.cachedIntensiveQuantities[timeIdx])
+            return *dofVars.cachedIntensiveQuantities[timeIdx];
+        return dofVars.intensiveQuantities[timeIdx];
     }
 
     /*!
@@ -434,12 +452,20 @@ public:
         return dofVars_[dofIdx].thermodynamicHint[timeIdx];
     }
     /*!
-     * \copydoc intensiveQuantities()
+     * \brief Returns true if the intensive quantities of a degree of freedom are the
+     *        object stored by the model's intensive quantities cache.
+     *
+     * This is not the case if the intensive quantities were updated for primary
+     * variables which differ from the model's solution, e.g., by finite difference
+     * linearizations, or if the model does not cache intensive quantities.
+     *
+     * \param dofIdx The local index of the degree of freedom in the current element.
+     * \param timeIdx The index of the solution vector used by the time discretization.
      */
-    IntensiveQuantities& intensiveQuantities(unsigned dofIdx, unsigned timeIdx)
+    bool intensiveQuantitiesCached(unsigned dofIdx, unsigned timeIdx) const
     {
         assert(0 <= dofIdx && dofIdx < numDof(timeIdx));
-        return dofVars_[dofIdx].intensiveQuantities[timeIdx];
+        return dofVars_[dofIdx].cachedIntensiveQuantities[timeIdx] != nullptr;
     }
 
     /*!
@@ -491,7 +517,11 @@ public:
     {
         assert(0 <= dofIdx && dofIdx < numDof(/*timeIdx=*/0));
 
-        intensiveQuantitiesStashed_ = dofVars_[dofIdx].intensiveQuantities[/*timeIdx=*/0];
+        // the cached object is not modified while the quantities are stashed, so it
+        // suffices to remember it
+        cachedIntensiveQuantitiesStashed_ = dofVars_[dofIdx].cachedIntensiveQuantities[/*timeIdx=*/0];
+        if (!cachedIntensiveQuantitiesStashed_)
+            intensiveQuantitiesStashed_ = dofVars_[dofIdx].intensiveQuantities[/*timeIdx=*/0];
         priVarsStashed_ = dofVars_[dofIdx].priVars[/*timeIdx=*/0];
         stashedDofIdx_ = static_cast<int>(dofIdx);
     }
@@ -504,7 +534,9 @@ public:
     void restoreIntensiveQuantities(unsigned dofIdx)
     {
         dofVars_[dofIdx].priVars[/*timeIdx=*/0] = priVarsStashed_;
-        dofVars_[dofIdx].intensiveQuantities[/*timeIdx=*/0] = intensiveQuantitiesStashed_;
+        dofVars_[dofIdx].cachedIntensiveQuantities[/*timeIdx=*/0] = cachedIntensiveQuantitiesStashed_;
+        if (!cachedIntensiveQuantitiesStashed_)
+            dofVars_[dofIdx].intensiveQuantities[/*timeIdx=*/0] = intensiveQuantitiesStashed_;
         stashedDofIdx_ = -1;
     }
 
@@ -568,9 +600,11 @@ protected:
             dofVars_[dofIdx].thermodynamicHint[timeIdx] =
                 model().thermodynamicHint(globalIdx, timeIdx);
 
+            // if the intensive quantities are cached, the context refers to the cached
+            // object instead of copying it
             const auto *cachedIntQuants = model().cachedIntensiveQuantities(globalIdx, timeIdx);
             if (cachedIntQuants) {
-                dofVars_[dofIdx].intensiveQuantities[timeIdx] = *cachedIntQuants;
+                dofVars_[dofIdx].cachedIntensiveQuantities[timeIdx] = cachedIntQuants;
             }
             else {
                 updateSingleIntQuants_(dofSol, dofIdx, timeIdx);
@@ -590,10 +624,12 @@ protected:
 #endif
 
         dofVars_[dofIdx].priVars[timeIdx] = priVars;
+        dofVars_[dofIdx].cachedIntensiveQuantities[timeIdx] = nullptr;
         dofVars_[dofIdx].intensiveQuantities[timeIdx].update(/*context=*/asImp_(), dofIdx, timeIdx);
     }
 
     IntensiveQuantities intensiveQuantitiesStashed_;
+    const IntensiveQuantities *cachedIntensiveQuantitiesStashed_;
     PrimaryVariables priVarsStashed_;
 
     GradientCalculator gradientCalculator_;
@@ -605,6 +641,8 @@ protected:
     const Element *elemPtr_;
     const GridView gridView_;
     Stencil stencil_;
+    // either points to stencil_ or to the model's stencil cache
+    const Stencil *stencilPtr_;
 
     int stashedDofIdx_;
     int focusDofIdx_;
@@ -33,8 +33,10 @@
 
 #include <opm/models/parallel/gridcommhandles.hh>
 #include <opm/models/parallel/threadmanager.hh>
-#include <opm/models/parallel/threadedentityiterator.hh>
+#include <opm/models/parallel/threadedelementscheduler.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/discretization/common/baseauxiliarymodule.hh>
+#include <opm/models/discretization/common/sparsitypattern.hh>
 
 #include <opm/material/common/Exceptions.hpp>
 
@@ -47,6 +49,8 @@
 #include <vector>
 #include <thread>
 #include <set>
+#include <atomic>
+#include <limits>
 #include <exception>   // current_exception, rethrow_exception
 #include <mutex>
 
@@ -93,6 +97,8 @@ class FvBaseLinearizer
 
     using Element = typename GridView::template Codim<0>::Entity;
     using ElementIterator = typename GridView::template Codim<0>::Iterator;
+    using ElementSeed = typename GridView::Grid::template Codim<0>::EntitySeed;
+    using ElementScheduler = Opm::ThreadedElementScheduler<GridView>;
 
     using Vector = GlobalEqVector;
 
@@ -105,6 +111,9 @@ class FvBaseLinearizer
     using VectorBlock = Dune::FieldVector<Scalar, numEq>;
 
     static const bool linearizeNonLocalElements = getPropValue<TypeTag, Properties::LinearizeNonLocalElements>();
+    static const bool useLinearizationColoring = getPropValue<TypeTag, Properties::UseLinearizationColoring>();
+    static const bool useLinearizationLock =
+        getPropValue<TypeTag, Properties::UseLinearizationLock>() && !useLinearizationColoring;
 
     // copying the linearizer is not a good idea
     FvBaseLinearizer(const FvBaseLinearizer&);
@@ -290,6 +299,25 @@ public:
     const std::map<unsigned, Constraints>& constraintsMap() const
     { return constraintsMap_; }
 
+    /*!
+     * \brief Returns true if a degree of freedom is constraint.
+     *
+     * In contrast to looking up the degree of freedom in constraintsMap(), this is a
+     * constant time operation which may be called concurrently by multiple threads.
+     */
+    bool isConstraintDof(unsigned dofIdx) const
+    { return dofIdx < constraintDofs_.size() && constraintDofs_[dofIdx]; }
+
+    /*!
+     * \brief Returns the number of independent sets ("colors") of elements used for
+     *        lock-free linearization.
+     *
+     * This is zero if the UseLinearizationColoring property is not set or if the
+     * Jacobian matrix has not been created yet.
+     */
+    size_t numElementColors() const
+    { return elementColorOffsets_.empty() ? 0 : elementColorOffsets_.size() - 1; }
+
 private:
     Simulator& simulator_()
     { return *simulatorPtr_; }
@@ -334,40 +362,144 @@ private:
     void createMatrix_()
     {
         const auto& model = model_();
-        Stencil stencil(gridView_(), model_().dofMapper());
 
         // for the main model, find out the global indices of the neighboring degrees of
-        // freedom of each primary degree of freedom
-        using NeighborSet = std::set< unsigned >;
-        std::vector<NeighborSet> sparsityPattern(model.numTotalDof());
+        // freedom of each primary degree of freedom. the threads collect the
+        // non-zero entries independently and the pattern is compressed afterwards.
+        unsigned numThreads = ThreadManager::maxThreads();
+        SparsityPattern sparsityPattern(model.numTotalDof(), numThreads);
+        typename ElementScheduler::Loop elemLoop(model.elementScheduler(),
+                                                 numThreads,
+                                                 /*interiorOnly=*/false);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            unsigned threadId = ThreadManager::threadId();
+            Stencil stencil(gridView_(), model_().dofMapper());
 
-        ElementIterator elemIt = gridView_().template begin<0>();
-        const ElementIterator elemEndIt = gridView_().template end<0>();
-        for (; elemIt != elemEndIt; ++elemIt) {
-            const Element& elem = *elemIt;
-            stencil.update(elem);
+            elemLoop.forEach(threadId, [&](const Element& elem) {
+                // only the indices of the degrees of freedom are required here
+                stencil.updateTopology(elem);
 
-            for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil.numPrimaryDof(); ++primaryDofIdx) {
-                unsigned myIdx = stencil.globalSpaceIndex(primaryDofIdx);
+                for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil.numPrimaryDof(); ++primaryDofIdx) {
+                    unsigned myIdx = stencil.globalSpaceIndex(primaryDofIdx);
 
-                for (unsigned dofIdx = 0; dofIdx < stencil.numDof(); ++dofIdx) {
-                    unsigned neighborIdx = stencil.globalSpaceIndex(dofIdx);
-                    sparsityPattern[myIdx].insert(neighborIdx);
+                    for (unsigned dofIdx = 0; dofIdx < stencil.numDof(); ++dofIdx) {
+                        unsigned neighborIdx = stencil.globalSpaceIndex(dofIdx);
+                        sparsityPattern.addEntry(threadId, myIdx, neighborIdx);
+                    }
                 }
-            }
+            });
         }
 
         // add the additional neighbors and degrees of freedom caused by the auxiliary
         // equations
         size_t numAuxMod = model.numAuxiliaryModules();
-        for (unsigned auxModIdx = 0; auxModIdx < numAuxMod; ++auxModIdx)
-            model.auxiliaryModule(auxModIdx)->addNeighbors(sparsityPattern);
+        if (numAuxMod > 0) {
+            using NeighborSet = std::set< unsigned >;
+            std::vector<NeighborSet> auxSparsityPattern(model.numTotalDof());
+            for (unsigned auxModIdx = 0; auxModIdx < numAuxMod; ++auxModIdx)
+                model.auxiliaryModule(auxModIdx)->addNeighbors(auxSparsityPattern);
+            sparsityPattern.addNeighbors(auxSparsityPattern);
+        }
+
+        sparsityPattern.finalize();
 
         // allocate raw matrix
         jacobian_.reset(new SparseMatrixAdapter(simulator_()));
 
         // create matrix structure based on sparsity pattern
-        jacobian_->reserve(sparsityPattern);
+        jacobian_->reserve(sparsityPattern.rowOffsets(), sparsityPattern.columnIndices());
+
+        if (useLinearizationColoring)
+            colorElements_();
+    }
+
+    // partition the elements into sets which can be linearized concurrently without
+    // causing race conditions.
+    //
+    // linearizing an element writes to the residual of the element's primary degrees
+    // of freedom and to the columns of the Jacobian matrix which correspond to them,
+    // i.e., two elements can be linearized at the same time if they do not share any
+    // primary degree of freedom. we use a greedy coloring of the resulting element
+    // graph, which is deterministic and thus does not depend on the number of threads.
+    void colorElements_()
+    {
+        // determine the primary degrees of freedom of the elements which need to be
+        // linearized
+        std::vector<ElementSeed> elemSeeds;
+        std::vector<unsigned> elemPrimaryDofOffsets(1, 0);
+        std::vector<unsigned> elemPrimaryDofs;
+        Stencil stencil(gridView_(), model_().dofMapper());
+        ElementIterator elemIt = gridView_().template begin<0>();
+        const ElementIterator elemEndIt = gridView_().template end<0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const Element& elem = *elemIt;
+            if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
+                continue;
+
+            stencil.updatePrimaryTopology(elem);
+            elemSeeds.push_back(elem.seed());
+            for (unsigned primaryDofIdx = 0; primaryDofIdx < stencil.numPrimaryDof(); ++primaryDofIdx)
+                elemPrimaryDofs.push_back(stencil.globalSpaceIndex(primaryDofIdx));
+            elemPrimaryDofOffsets.push_back(static_cast<unsigned>(elemPrimaryDofs.size()));
+        }
+
+        size_t numElems = elemSeeds.size();
+        size_t numDof = model_().numTotalDof();
+
+        // invert the element -> primary DOF mapping
+        std::vector<unsigned> dofElemOffsets(numDof + 1, 0);
+        for (unsigned dofIdx : elemPrimaryDofs)
+            ++ dofElemOffsets[dofIdx + 1];
+        for (size_t dofIdx = 0; dofIdx < numDof; ++ dofIdx)
+            dofElemOffsets[dofIdx + 1] += dofElemOffsets[dofIdx];
+
+        std::vector<unsigned> dofElems(elemPrimaryDofs.size());
+        std::vector<unsigned> dofElemFill(dofElemOffsets.begin(), dofElemOffsets.end() - 1);
+        for (unsigned elemIdx = 0; elemIdx < numElems; ++ elemIdx)
+            for (unsigned i = elemPrimaryDofOffsets[elemIdx]; i < elemPrimaryDofOffsets[elemIdx + 1]; ++ i)
+                dofElems[dofElemFill[elemPrimaryDofs[i]]++] = elemIdx;
+
+        // greedy coloring. forbiddenColor[c] == elemIdx means that color 'c' is already
+        // used by a neighbor of element 'elemIdx'
+        const unsigned noColor = std::numeric_limits<unsigned>::max();
+        std::vector<unsigned> elemColor(numElems, noColor);
+        std::vector<unsigned> forbiddenColor;
+        unsigned numColors = 0;
+        for (unsigned elemIdx = 0; elemIdx < numElems; ++ elemIdx) {
+            for (unsigned i = elemPrimaryDofOffsets[elemIdx]; i < elemPrimaryDofOffsets[elemIdx + 1]; ++ i) {
+                unsigned dofIdx = elemPrimaryDofs[i];
+                for (unsigned j = dofElemOffsets[dofIdx]; j < dofElemOffsets[dofIdx + 1]; ++ j) {
+                    unsigned neighborColor = elemColor[dofElems[j]];
+                    if (neighborColor != noColor)
+                        forbiddenColor[neighborColor] = elemIdx;
+                }
+            }
+
+            unsigned color = 0;
+            while (color < numColors && forbiddenColor[color] == elemIdx)
+                ++ color;
+            if (color == numColors) {
+                ++ numColors;
+                forbiddenColor.push_back(noColor);
+            }
+            elemColor[elemIdx] = color;
+        }
+
+        // sort the element seeds by color. the order of the elements within a color
+        // is the one of the grid traversal.
+        elementColorOffsets_.assign(numColors + 1, 0);
+        for (unsigned elemIdx = 0; elemIdx < numElems; ++ elemIdx)
+            ++ elementColorOffsets_[elemColor[elemIdx] + 1];
+        for (unsigned color = 0; color < numColors; ++ color)
+            elementColorOffsets_[color + 1] += elementColorOffsets_[color];
+
+        std::vector<size_t> colorFill(elementColorOffsets_.begin(), elementColorOffsets_.end() - 1);
+        coloredElementSeeds_.resize(numElems);
+        for (unsigned elemIdx = 0; elemIdx < numElems; ++ elemIdx)
+            coloredElementSeeds_[colorFill[elemColor[elemIdx]]++] = elemSeeds[elemIdx];
     }
 
     // reset the global linear system of equations.
@@ -387,19 +519,24 @@ private:
             return;
 
         constraintsMap_.clear();
+        constraintDofs_.assign(model_().numTotalDof(), false);
+
+        // the constraints are collected by each thread separately and merged afterwards
+        unsigned numThreads = ThreadManager::maxThreads();
+        std::vector<std::vector<std::pair<unsigned, Constraints> > > threadConstraints(numThreads);
 
         // loop over all elements...
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_());
+        typename ElementScheduler::Loop elemLoop(model_().elementScheduler(),
+                                                 numThreads,
+                                                 /*interiorOnly=*/false);
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
             unsigned threadId = ThreadManager::threadId();
-            ElementIterator elemIt = threadedElemIt.beginParallel();
-            for (; !threadedElemIt.isFinished(elemIt); elemIt = threadedElemIt.increment()) {
+            elemLoop.forEach(threadId, [&](const Element& elem) {
                 // create an element context (the solution-based quantities are not
                 // available here!)
-                const Element& elem = *elemIt;
                 ElementContext& elemCtx = *elementCtx_[threadId];
                 elemCtx.updateStencil(elem);
 
@@ -416,10 +553,17 @@ private:
                                                   /*timeIdx=*/0);
                     if (constraints.isActive()) {
                         unsigned globI = elemCtx.globalSpaceIndex(primaryDofIdx, /*timeIdx=*/0);
-                        constraintsMap_[globI] = constraints;
+                        threadConstraints[threadId].emplace_back(globI, constraints);
                         continue;
                     }
                 }
+            });
+        }
+
+        for (const auto& constraintsOfThread : threadConstraints) {
+            for (const auto& dofConstraints : constraintsOfThread) {
+                constraintsMap_[dofConstraints.first] = dofConstraints.second;
+                constraintDofs_[dofConstraints.first] = true;
             }
         }
     }
@@ -437,6 +581,18 @@ private:
 
         applyConstraintsToSolution_();
 
+        if (useLinearizationColoring)
+            linearizeColored_();
+        else
+            linearizeThreaded_();
+
+        applyConstraintsToLinearization_();
+    }
+
+    // linearize all elements using the threaded element scheduler. with multiple
+    // threads, this may require to lock the global system of equations.
+    void linearizeThreaded_()
+    {
         // to avoid a race condition if two threads handle an exception at the same time,
         // we use an explicit lock to control access to the exception storage object
         // amongst thread-local handlers
@@ -446,34 +602,32 @@ private:
         // parallel block below. initialized to null to indicate no exception
         std::exception_ptr exceptionPtr = nullptr;
 
-        // relinearize the elements...
-        ThreadedEntityIterator<GridView, /*codim=*/0> threadedElemIt(gridView_());
+        // relinearize the elements. the scheduler stores the interior elements first,
+        // so the non-local ones can be skipped by just not considering them.
+        const auto& elemScheduler = model_().elementScheduler();
+        typename ElementScheduler::Loop elemLoop(elemScheduler,
+                                                 ThreadManager::maxThreads(),
+                                                 /*interiorOnly=*/!linearizeNonLocalElements);
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
         {
-            ElementIterator elemIt = threadedElemIt.beginParallel();
-            ElementIterator nextElemIt = elemIt;
+            unsigned threadId = ThreadManager::threadId();
+            size_t chunkBegin, chunkEnd;
             try {
-                for (; !threadedElemIt.isFinished(elemIt); elemIt = nextElemIt) {
-                    // give the model and the problem a chance to prefetch the data required
-                    // to linearize the next element, but only if we need to consider it
-                    nextElemIt = threadedElemIt.increment();
-                    if (!threadedElemIt.isFinished(nextElemIt)) {
-                        const auto& nextElem = *nextElemIt;
-                        if (linearizeNonLocalElements
-                            || nextElem.partitionType() == Dune::InteriorEntity)
-                        {
+                while (elemLoop.nextChunk(threadId, chunkBegin, chunkEnd)) {
+                    for (size_t elemIdx = chunkBegin; elemIdx < chunkEnd; ++elemIdx) {
+                        // give the model and the problem a chance to prefetch the data
+                        // required to linearize the next element
+                        if (elemIdx + 1 < chunkEnd) {
+                            const auto& nextElem = elemScheduler.element(elemIdx + 1);
                             model_().prefetch(nextElem);
                             problem_().prefetch(nextElem);
                         }
-                    }
 
-                    const Element& elem = *elemIt;
-                    if (!linearizeNonLocalElements && elem.partitionType() != Dune::InteriorEntity)
-                        continue;
-
-                    linearizeElement_(elem);
+                        const auto& elem = elemScheduler.element(elemIdx);
+                        linearizeElement_(elem);
+                    }
                 }
             }
             // If an exception occurs in the parallel block, it won't escape the
@@ -488,7 +642,7 @@ private:
             catch(...) {
                 std::lock_guard<std::mutex> take(exceptionLock);
                 exceptionPtr = std::current_exception();
-                threadedElemIt.setFinished();
+                elemLoop.setFinished();
             }
         }  // parallel block
 
@@ -498,8 +652,51 @@ private:
         if(exceptionPtr) {
             std::rethrow_exception(exceptionPtr);
         }
+    }
+
+    // linearize the elements color by color. since the elements of a given color do not
+    // share any primary degrees of freedom, no locking is required.
+    void linearizeColored_()
+    {
+        std::mutex exceptionLock;
+        std::exception_ptr exceptionPtr = nullptr;
+        std::atomic<bool> failed(false);
+
+        const auto& grid = gridView_().grid();
+        size_t numColors = numElementColors();
+        for (size_t color = 0; color < numColors && !failed; ++ color) {
+            const size_t colorBegin = elementColorOffsets_[color];
+            const size_t colorEnd = elementColorOffsets_[color + 1];
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(guided)
+#endif
+            for (size_t elemIdx = colorBegin; elemIdx < colorEnd; ++ elemIdx) {
+                // OpenMP loops cannot be left using 'break', so skip the remaining
+                // elements if any thread has failed
+                if (failed)
+                    continue;
+
+                try {
+                    if (elemIdx + 1 < colorEnd) {
+                        const auto& nextElem = grid.entity(coloredElementSeeds_[elemIdx + 1]);
+                        model_().prefetch(nextElem);
+                        problem_().prefetch(nextElem);
+                    }
+
+                    const auto& elem = grid.entity(coloredElementSeeds_[elemIdx]);
+                    linearizeElement_(elem);
+                }
+                catch(...) {
+                    std::lock_guard<std::mutex> take(exceptionLock);
+                    exceptionPtr = std::current_exception();
+                    failed = true;
+                }
+            }
+        }
 
-        applyConstraintsToLinearization_();
+        if (exceptionPtr)
+            std::rethrow_exception(exceptionPtr);
     }
 
     // linearize an element in the interior of the process' grid partition
@@ -514,7 +711,8 @@ private:
         localLinearizer.linearize(*elementCtx, elem);
 
         // update the right hand side and the Jacobian matrix
-        if (getPropValue<TypeTag, Properties::UseLinearizationLock>())
+        EWOMS_PROFILE_REGION("scatter");
+        if (useLinearizationLock)
             globalMatrixMutex_.lock();
 
         size_t numPrimaryDof = elementCtx->numPrimaryDof(/*timeIdx=*/0);
@@ -532,7 +730,7 @@ private:
             }
         }
 
-        if (getPropValue<TypeTag, Properties::UseLinearizationLock>())
+        if (useLinearizationLock)
             globalMatrixMutex_.unlock();
     }
 
@@ -585,6 +783,7 @@ private:
     // The constraint equations (only non-empty if the
     // EnableConstraints property is true)
     std::map<unsigned, Constraints> constraintsMap_;
+    std::vector<bool> constraintDofs_;
 
     // the jacobian matrix
     std::unique_ptr<SparseMatrixAdapter> jacobian_;
@@ -595,6 +794,11 @@ private:
     LinearizationType linearizationType_;
 
     std::mutex globalMatrixMutex_;
+
+    // the elements to be linearized sorted by their color (only used if the
+    // UseLinearizationColoring property is set)
+    std::vector<ElementSeed> coloredElementSeeds_;
+    std::vector<size_t> elementColorOffsets_;
 };
 
 } // namespace Opm
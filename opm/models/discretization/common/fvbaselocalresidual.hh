@@ -32,6 +32,7 @@
 
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/models/utils/alignedallocator.hh>
+#include <opm/models/utils/profiler.hh>
 
 #include <opm/material/common/Valgrind.hpp>
 #include <opm/material/common/Unused.hpp>
@@ -160,6 +161,7 @@ public:
     void eval(LocalEvalBlockVector& residual,
               ElementContext& elemCtx) const
     {
+        EWOMS_PROFILE_REGION("localResidual");
         assert(residual.size() == elemCtx.numDof(/*timeIdx=*/0));
 
         residual = 0.0;
@@ -302,6 +304,7 @@ public:
                     const ElementContext& elemCtx,
                     unsigned timeIdx) const
     {
+        EWOMS_PROFILE_REGION("fluxes");
         RateVector flux;
 
         const auto& stencil = elemCtx.stencil(timeIdx);
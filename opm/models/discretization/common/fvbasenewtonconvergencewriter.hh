@@ -29,6 +29,7 @@
 #define EWOMS_FV_BASE_NEWTON_CONVERGENCE_WRITER_HH
 
 #include <opm/models/io/vtkmultiwriter.hh>
+#include <opm/models/utils/parametersystem.hh>
 #include <opm/models/utils/propertysystem.hh>
 
 #include <iostream>
@@ -97,12 +98,16 @@ public:
     void beginIteration()
     {
         ++ iteration_;
-        if (!vtkMultiWriter_)
+        if (!vtkMultiWriter_) {
+            const auto& model = newtonMethod_.problem().model();
             vtkMultiWriter_ =
                 new VtkMultiWriter(/*async=*/false,
                                    newtonMethod_.problem().gridView(),
+                                   model.elementMapper(),
+                                   model.vertexMapper(),
                                    newtonMethod_.problem().outputDir(),
                                    "convergence");
+        }
         vtkMultiWriter_->beginWrite(timeStepIdx_ + iteration_ / 100.0);
     }
 
@@ -39,6 +39,8 @@
 
 #include <dune/common/fvector.hh>
 
+#include <algorithm>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <string>
@@ -118,12 +120,14 @@ public:
     FvBaseProblem(Simulator& simulator)
         : nextTimeStepSize_(0.0)
         , gridView_(simulator.gridView())
-        , elementMapper_(gridView_, Dune::mcmgElementLayout())
-        , vertexMapper_(gridView_, Dune::mcmgVertexLayout())
+        // the model computes the ordering of the degrees of freedom
+        , elementMapper_(simulator.model().elementMapper())
+        , vertexMapper_(simulator.model().vertexMapper())
         , boundingBoxMin_(std::numeric_limits<double>::max())
         , boundingBoxMax_(-std::numeric_limits<double>::max())
         , simulator_(simulator)
         , defaultVtkWriter_(0)
+        , outputRegionSet_(false)
     {
         // calculate the bounding box of the local partition of the grid view
         VertexIterator vIt = gridView_.template begin<dim>();
@@ -142,8 +146,12 @@ public:
         }
 
         if (enableVtkOutput_()) {
+            // the static grid and the XDMF writers do not communicate, so they can also
+            // write asynchronously in parallel
+            bool staticGridVtkOutput = EWOMS_GET_PARAM(TypeTag, bool, EnableVtkStaticGrid);
+            bool xdmfOutput = EWOMS_GET_PARAM(TypeTag, bool, EnableXdmfOutput);
             bool asyncVtkOutput =
-                simulator_.gridView().comm().size() == 1 &&
+                (simulator_.gridView().comm().size() == 1 || staticGridVtkOutput || xdmfOutput) &&
                 EWOMS_GET_PARAM(TypeTag, bool, EnableAsyncVtkOutput);
 
             // asynchonous VTK output currently does not work in conjunction with grid
@@ -157,7 +165,14 @@ public:
             std::string outputDir = asImp_().outputDir();
 
             defaultVtkWriter_ =
-                new VtkMultiWriter(asyncVtkOutput, gridView_, outputDir, asImp_().name());
+                new VtkMultiWriter(asyncVtkOutput, gridView_, elementMapper_, vertexMapper_,
+                                   outputDir, asImp_().name(),
+                                   /*multiFileName=*/"",
+                                   staticGridVtkOutput,
+                                   EWOMS_GET_PARAM(TypeTag, unsigned, VtkOutputThreads),
+                                   EWOMS_GET_PARAM(TypeTag, bool, EnableVtkCompression),
+                                   EWOMS_GET_PARAM(TypeTag, unsigned, VtkMaxPendingOutputs),
+                                   xdmfOutput);
         }
     }
 
@@ -180,6 +195,24 @@ public:
                              "before the simulation bails out");
         EWOMS_REGISTER_PARAM(TypeTag, bool, EnableAsyncVtkOutput,
                              "Dispatch a separate thread to write the VTK output");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableVtkStaticGrid,
+                             "Encode the geometry of the grid only once for all VTK files and "
+                             "fill the fields directly from the output buffers");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, VtkOutputThreads,
+                             "The number of threads which encode the fields of the VTK files "
+                             "if the output is asynchronous and the geometry is encoded only once");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableVtkCompression,
+                             "Compress the data of the VTK files using zlib. This requires "
+                             "that the geometry is encoded only once");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, VtkMaxPendingOutputs,
+                             "The maximum number of time steps for which the VTK output may "
+                             "still be written when the simulation continues");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableXdmfOutput,
+                             "Write the output of all time steps and processes to a single "
+                             "binary file which is described by an XDMF index instead of "
+                             "writing VTK files");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, VtkOutputInterval,
+                             "The number of time steps between two outputs of the solution");
         EWOMS_REGISTER_PARAM(TypeTag, bool, ContinueOnConvergenceError,
                              "Continue with a non-converged solution instead of giving up "
                              "if we encounter a time step size smaller than the minimum time "
@@ -627,12 +660,40 @@ public:
      * \brief Returns true if the current solution should be written to
      *        disk (i.e. as a VTK file)
      *
-     * The default behavior is to write out the solution for every
-     * time step. This method is should be overwritten by the
-     * implementation if the default behavior is deemed insufficient.
+     * The default behavior is to write out the initial solution, the solution at the
+     * end of the simulation and the solution of every N-th time step, where N is
+     * specified by the VtkOutputInterval parameter. This method is should be
+     * overwritten by the implementation if the default behavior is deemed
+     * insufficient.
      */
     bool shouldWriteOutput() const
-    { return true; }
+    {
+        // the time step index is -1 for the initial solution
+        int stepIdx = simulator().timeStepIndex();
+        if (stepIdx < 0 || simulator().willBeFinished())
+            return true;
+
+        unsigned interval = std::max(EWOMS_GET_PARAM(TypeTag, unsigned, VtkOutputInterval), 1u);
+        return (static_cast<unsigned>(stepIdx) + 1) % interval == 0;
+    }
+
+    /*!
+     * \brief Returns the elements which should be written to disk, i.e., the region of
+     *        interest.
+     *
+     * Elements for which the returned function yields false are neither written nor
+     * are their output fields computed. An empty function selects all elements, which
+     * is the default. Restricting the output to a region of interest requires that the
+     * geometry of the grid is encoded only once (EnableVtkStaticGrid) or XDMF output.
+     *
+     * For the vertex-centered discretization, the vertices on the boundary of the
+     * region are shared with elements outside of it. Vertex fields which are
+     * accumulated over the adjacent elements, e.g., averaged velocities, are only
+     * computed from the elements inside the region there and thus differ from the
+     * values which are written if the whole domain is selected.
+     */
+    std::function<bool(const Element&)> outputRegion() const
+    { return std::function<bool(const Element&)>(); }
 
     /*!
      * \brief Called by the simulator after everything which can be
@@ -794,6 +855,15 @@ public:
             std::cout << "Writing visualization results for the current time step.\n"
                       << std::flush;
 
+        // the region of interest is specified by the implementation of the problem, so
+        // it is only known once the problem is fully initialized
+        if (!outputRegionSet_) {
+            const auto& outputRegion = asImp_().outputRegion();
+            if (outputRegion)
+                defaultVtkWriter_->setElementFilter(outputRegion);
+            outputRegionSet_ = true;
+        }
+
         // calculate the time _after_ the time was updated
         Scalar t = simulator().time() + simulator().timeStepSize();
 
@@ -836,6 +906,7 @@ private:
     // Attributes required for the actual simulation
     Simulator& simulator_;
     mutable VtkMultiWriter *defaultVtkWriter_;
+    bool outputRegionSet_;
 };
 
 } // namespace Opm
@@ -196,6 +196,13 @@ struct ThreadsPerProcess { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct UseLinearizationLock { using type = UndefinedProperty; };
 
+//! assemble the global system of equations without locking by partitioning the elements
+//! into independent sets using a graph coloring which is computed when the sparsity
+//! pattern of the Jacobian matrix is determined. (if this is enabled, the
+//! UseLinearizationLock property does not have any effect.)
+template<class TypeTag, class MyTypeTag>
+struct UseLinearizationColoring { using type = UndefinedProperty; };
+
 // high-level simulation control
 
 /*!
@@ -246,6 +253,67 @@ struct EnableAsyncVtkOutput { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct VtkOutputFormat { using type = UndefinedProperty; };
 
+/*!
+ * \brief Determines if the geometry of the grid is encoded only once for all VTK files
+ *
+ * If this is enabled, the VTK files are not written by Dune::VTKWriter but by
+ * Opm::VtkStaticGridWriter. This writer always uses binary data which is optionally
+ * compressed, i.e., the VtkOutputFormat property does not have any effect. Because it
+ * does not require any communication, asynchronous VTK output can also be used for
+ * MPI-parallel simulations.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableVtkStaticGrid { using type = UndefinedProperty; };
+
+/*!
+ * \brief The number of threads which encode and write the VTK files
+ *
+ * This only has an effect if asynchronous output and the static grid mode are enabled.
+ * In this case, the fields of a time step are encoded concurrently.
+ */
+template<class TypeTag, class MyTypeTag>
+struct VtkOutputThreads { using type = UndefinedProperty; };
+
+/*!
+ * \brief Determines if the appended data of the VTK files is compressed using zlib
+ *
+ * This is only supported in the static grid mode.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableVtkCompression { using type = UndefinedProperty; };
+
+/*!
+ * \brief The maximum number of time steps for which the VTK output may be pending
+ *
+ * If the simulation produces output faster than it can be written, it is stalled
+ * until the writer threads have caught up. This limits the memory used to store the
+ * output which has not yet been written. It only has an effect in the static grid mode.
+ */
+template<class TypeTag, class MyTypeTag>
+struct VtkMaxPendingOutputs { using type = UndefinedProperty; };
+
+/*!
+ * \brief Determines if the output is written to a single container file with an XDMF
+ *        index instead of VTK files
+ *
+ * All time steps of all processes are written to the same binary file, i.e., the
+ * number of files does not grow with the number of time steps and processes. The
+ * output modules are the same as for VTK output, and the fields are processed like in
+ * the static grid mode.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableXdmfOutput { using type = UndefinedProperty; };
+
+/*!
+ * \brief The number of time steps between two outputs of the solution
+ *
+ * The initial solution and the solution at the end of the simulation are always
+ * written. This only affects the default output behavior of the problem, i.e., it
+ * has no effect if the problem overwrites shouldWriteOutput().
+ */
+template<class TypeTag, class MyTypeTag>
+struct VtkOutputInterval { using type = UndefinedProperty; };
+
 //! Specify whether the some degrees of fredom can be constraint
 template<class TypeTag, class MyTypeTag>
 struct EnableConstraints { using type = UndefinedProperty; };
@@ -302,6 +370,16 @@ struct EnableIntensiveQuantityCache { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct EnableStorageCache { using type = UndefinedProperty; };
 
+/*!
+ * \brief Specify whether the stencils of all elements should be cached.
+ *
+ * If enabled, the finite volume geometry of each element is only computed once for
+ * each version of the grid instead of each time an element is visited. This trades
+ * memory for CPU time.
+ */
+template<class TypeTag, class MyTypeTag>
+struct EnableStencilCache { using type = UndefinedProperty; };
+
 /*!
  * \brief Specify whether to use the already calculated solutions as
  *        starting values of the intensive quantities.
@@ -0,0 +1,423 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::ReorderedMapper
+ */
+#ifndef EWOMS_REORDERED_MAPPER_HH
+#define EWOMS_REORDERED_MAPPER_HH
+
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/grid/common/rangegenerators.hh>
+#include <dune/geometry/type.hh>
+#include <dune/common/fvector.hh>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \ingroup Discretization
+ *
+ * \brief A mapper for the elements or the vertices of a grid view which optionally
+ *        renumbers the entities to improve data locality.
+ *
+ * The indices of Dune::MultipleCodimMultipleGeomTypeMapper follow the internal
+ * numbering of the grid, which can be quite arbitrary for unstructured grids. This
+ * class permutes these indices after the mapper has been created or updated. The
+ * following orderings are available:
+ *
+ * - "none": The indices of the underlying mapper are used unchanged.
+ * - "rcm": Reverse Cuthill-McKee ordering of the connectivity graph, i.e., of the
+ *   face neighbors of elements or of the vertices which share an element. This
+ *   reduces the bandwidth of the Jacobian matrix.
+ * - "hilbert": The entities are sorted along a Hilbert space-filling curve through
+ *   the centers of the elements or the positions of the vertices.
+ *
+ * Since the permutation only depends on the grid view, all mappers of a simulation
+ * which are created with the same ordering agree on the indices. Computing the
+ * permutation is expensive for large grids, though. Copies of a mapper thus copy the
+ * permutation instead of recomputing it, and objects which need the indices of the
+ * model should copy the model's mappers. Note that this also
+ * applies to restart files, i.e., a simulation must be restarted using the ordering
+ * which was used to write the files. Only layouts which either map all elements or all
+ * vertices can be reordered.
+ */
+template <class GridView>
+class ReorderedMapper
+{
+    using BaseMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+    using Element = typename GridView::template Codim<0>::Entity;
+    using CoordScalar = typename GridView::ctype;
+
+    enum { dim = GridView::dimension };
+    enum { dimWorld = GridView::dimensionworld };
+
+    using GlobalPosition = Dune::FieldVector<CoordScalar, dimWorld>;
+
+public:
+    using Index = typename BaseMapper::Index;
+    using size_type = typename BaseMapper::size_type;
+
+    template <class Layout>
+    ReorderedMapper(const GridView& gridView,
+                    const Layout& layout,
+                    const std::string& ordering = "none")
+        : gridView_(gridView)
+        , mapper_(gridView, layout)
+        , ordering_(parseOrdering_(ordering))
+    {
+        if (ordering_ != Ordering_::None) {
+            mapsVertices_ = layout(Dune::GeometryTypes::vertex, dim) > 0;
+            int codim = mapsVertices_ ? dim : 0;
+            if (mapper_.size() != static_cast<size_type>(gridView.size(codim)))
+                throw std::invalid_argument("Reordering is only supported for mappers of "
+                                            "either the elements or the vertices of a grid");
+        }
+
+        updatePermutation_();
+    }
+
+    /*!
+     * \brief Returns the index of an entity.
+     */
+    template <class Entity>
+    Index index(const Entity& entity) const
+    { return permute_(mapper_.index(entity)); }
+
+    /*!
+     * \brief Returns the index of a sub-entity of an element.
+     */
+    Index subIndex(const Element& element, int i, unsigned codim) const
+    { return permute_(mapper_.subIndex(element, i, codim)); }
+
+    /*!
+     * \brief Returns the index of an entity if it is contained in the mapper.
+     */
+    template <class Entity>
+    bool contains(const Entity& entity, Index& result) const
+    {
+        if (!mapper_.contains(entity, result))
+            return false;
+        result = permute_(result);
+        return true;
+    }
+
+    /*!
+     * \brief Returns the index of a sub-entity of an element if it is contained in
+     *        the mapper.
+     */
+    bool contains(const Element& element, int i, int cc, Index& result) const
+    {
+        if (!mapper_.contains(element, i, cc, result))
+            return false;
+        result = permute_(result);
+        return true;
+    }
+
+    /*!
+     * \brief Returns the total number of indices.
+     */
+    size_type size() const
+    { return mapper_.size(); }
+
+    /*!
+     * \brief Returns true iff the indices of the underlying mapper are permuted.
+     */
+    bool isReordered() const
+    { return !permutation_.empty(); }
+
+    /*!
+     * \brief Recompute the indices after the grid has changed.
+     */
+    void update()
+    {
+        mapper_.update();
+        updatePermutation_();
+    }
+
+private:
+    enum class Ordering_ { None, ReverseCuthillMcKee, Hilbert };
+
+    static Ordering_ parseOrdering_(const std::string& ordering)
+    {
+        if (ordering == "none")
+            return Ordering_::None;
+        else if (ordering == "rcm")
+            return Ordering_::ReverseCuthillMcKee;
+        else if (ordering == "hilbert")
+            return Ordering_::Hilbert;
+
+        throw std::invalid_argument("Unknown DOF ordering '"+ordering+"'. Valid orderings "
+                                    "are 'none', 'rcm' and 'hilbert'");
+    }
+
+    Index permute_(Index idx) const
+    { return permutation_.empty() ? idx : permutation_[static_cast<size_t>(idx)]; }
+
+    void updatePermutation_()
+    {
+        permutation_.clear();
+
+        // newToOld[i] is the index of the underlying mapper of the i-th entity in the
+        // new order
+        std::vector<Index> newToOld;
+        if (ordering_ == Ordering_::ReverseCuthillMcKee)
+            newToOld = reverseCuthillMcKeeOrder_();
+        else if (ordering_ == Ordering_::Hilbert)
+            newToOld = hilbertOrder_();
+        else
+            return;
+
+        permutation_.resize(newToOld.size());
+        for (size_t newIdx = 0; newIdx < newToOld.size(); ++newIdx)
+            permutation_[static_cast<size_t>(newToOld[newIdx])] = static_cast<Index>(newIdx);
+    }
+
+    // create the connectivity graph in compressed row storage format
+    void connectivityGraph_(std::vector<size_t>& offsets, std::vector<Index>& neighbors) const
+    {
+        std::vector<std::pair<Index, Index> > edges;
+        for (const auto& elem : elements(gridView_)) {
+            if (mapsVertices_) {
+                int numVertices = static_cast<int>(elem.subEntities(dim));
+                for (int i = 0; i < numVertices; ++i) {
+                    Index iIdx = mapper_.subIndex(elem, i, dim);
+                    for (int j = 0; j < numVertices; ++j)
+                        if (i != j)
+                            edges.emplace_back(iIdx, mapper_.subIndex(elem, j, dim));
+                }
+            }
+            else {
+                Index elemIdx = mapper_.index(elem);
+                for (const auto& intersection : intersections(gridView_, elem))
+                    if (intersection.neighbor())
+                        edges.emplace_back(elemIdx, mapper_.index(intersection.outside()));
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        size_t numEntities = static_cast<size_t>(mapper_.size());
+        offsets.assign(numEntities + 1, 0);
+        neighbors.resize(edges.size());
+        for (size_t i = 0; i < edges.size(); ++i) {
+            ++ offsets[static_cast<size_t>(edges[i].first) + 1];
+            neighbors[i] = edges[i].second;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    }
+
+    std::vector<Index> reverseCuthillMcKeeOrder_() const
+    {
+        std::vector<size_t> offsets;
+        std::vector<Index> neighbors;
+        connectivityGraph_(offsets, neighbors);
+
+        size_t numEntities = offsets.size() - 1;
+        auto degree = [&offsets](Index idx)
+        { return offsets[static_cast<size_t>(idx) + 1] - offsets[static_cast<size_t>(idx)]; };
+
+        // the entities sorted by their degree are the candidates for the start of the
+        // breadth-first search of each connected component
+        std::vector<Index> candidates(numEntities);
+        std::iota(candidates.begin(), candidates.end(), Index(0));
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [&degree](Index a, Index b) { return degree(a) < degree(b); });
+
+        std::vector<Index> order;
+        order.reserve(numEntities);
+        std::vector<int> level(numEntities, -1);
+        std::vector<Index> visited;
+        for (Index startIdx : candidates) {
+            if (level[static_cast<size_t>(startIdx)] >= 0)
+                continue;
+
+            // find a pseudo-peripheral entity of the component: repeatedly restart the
+            // search at the entity of lowest degree of the last level as long as the
+            // depth of the level structure increases
+            int depth = -1;
+            while (true) {
+                int newDepth = breadthFirstSearch_(startIdx, offsets, neighbors, level, visited);
+                Index lastIdx = visited.back();
+                for (Index idx : visited)
+                    if (level[static_cast<size_t>(idx)] == newDepth && degree(idx) < degree(lastIdx))
+                        lastIdx = idx;
+                for (Index idx : visited)
+                    level[static_cast<size_t>(idx)] = -1;
+                if (newDepth <= depth)
+                    break;
+                depth = newDepth;
+                startIdx = lastIdx;
+            }
+
+            // Cuthill-McKee: visit the neighbors of each entity in the order of
+            // increasing degree
+            size_t first = order.size();
+            order.push_back(startIdx);
+            level[static_cast<size_t>(startIdx)] = 0;
+            std::vector<Index> unvisited;
+            for (size_t i = first; i < order.size(); ++i) {
+                size_t idx = static_cast<size_t>(order[i]);
+                unvisited.clear();
+                for (size_t k = offsets[idx]; k < offsets[idx + 1]; ++k) {
+                    size_t nIdx = static_cast<size_t>(neighbors[k]);
+                    if (level[nIdx] < 0) {
+                        level[nIdx] = level[idx] + 1;
+                        unvisited.push_back(neighbors[k]);
+                    }
+                }
+                std::stable_sort(unvisited.begin(), unvisited.end(),
+                                 [&degree](Index a, Index b) { return degree(a) < degree(b); });
+                order.insert(order.end(), unvisited.begin(), unvisited.end());
+            }
+        }
+
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    // marks all entities which are reachable from startIdx with their distance in
+    // the level vector and returns the depth of the level structure
+    static int breadthFirstSearch_(Index startIdx,
+                                   const std::vector<size_t>& offsets,
+                                   const std::vector<Index>& neighbors,
+                                   std::vector<int>& level,
+                                   std::vector<Index>& visited)
+    {
+        visited.clear();
+        visited.push_back(startIdx);
+        level[static_cast<size_t>(startIdx)] = 0;
+        for (size_t i = 0; i < visited.size(); ++i) {
+            size_t idx = static_cast<size_t>(visited[i]);
+            for (size_t k = offsets[idx]; k < offsets[idx + 1]; ++k) {
+                size_t nIdx = static_cast<size_t>(neighbors[k]);
+                if (level[nIdx] < 0) {
+                    level[nIdx] = level[idx] + 1;
+                    visited.push_back(neighbors[k]);
+                }
+            }
+        }
+
+        return level[static_cast<size_t>(visited.back())];
+    }
+
+    std::vector<Index> hilbertOrder_() const
+    {
+        size_t numEntities = static_cast<size_t>(mapper_.size());
+        std::vector<GlobalPosition> positions(numEntities);
+        if (mapsVertices_) {
+            for (const auto& vertex : vertices(gridView_))
+                positions[static_cast<size_t>(mapper_.index(vertex))] = vertex.geometry().corner(0);
+        }
+        else {
+            for (const auto& elem : elements(gridView_))
+                positions[static_cast<size_t>(mapper_.index(elem))] = elem.geometry().center();
+        }
+
+        GlobalPosition minPos(std::numeric_limits<CoordScalar>::max());
+        GlobalPosition maxPos(std::numeric_limits<CoordScalar>::lowest());
+        for (const auto& pos : positions) {
+            for (unsigned k = 0; k < dimWorld; ++k) {
+                minPos[k] = std::min(minPos[k], pos[k]);
+                maxPos[k] = std::max(maxPos[k], pos[k]);
+            }
+        }
+
+        std::vector<std::pair<uint64_t, Index> > keys(numEntities);
+        for (size_t i = 0; i < numEntities; ++i) {
+            uint32_t coords[dimWorld];
+            for (unsigned k = 0; k < dimWorld; ++k) {
+                CoordScalar extent = maxPos[k] - minPos[k];
+                CoordScalar rel = (extent > 0) ? (positions[i][k] - minPos[k])/extent : 0;
+                coords[k] = static_cast<uint32_t>(rel*((1u << hilbertBits_) - 1));
+            }
+            keys[i] = std::make_pair(hilbertKey_(coords), static_cast<Index>(i));
+        }
+        std::sort(keys.begin(), keys.end());
+
+        std::vector<Index> order(numEntities);
+        for (size_t i = 0; i < numEntities; ++i)
+            order[i] = keys[i].second;
+        return order;
+    }
+
+    // compute the position of a point on the Hilbert curve using Skilling's algorithm
+    // ("Programming the Hilbert curve", AIP Conference Proceedings 707, 2004)
+    static uint64_t hilbertKey_(uint32_t (&x)[dimWorld])
+    {
+        // undo the excess work
+        for (uint32_t q = 1u << (hilbertBits_ - 1); q > 1; q >>= 1) {
+            uint32_t p = q - 1;
+            for (unsigned i = 0; i < dimWorld; ++i) {
+                if (x[i] & q)
+                    x[0] ^= p;
+                else {
+                    uint32_t t = (x[0] ^ x[i]) & p;
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+
+        // Gray encode
+        for (unsigned i = 1; i < dimWorld; ++i)
+            x[i] ^= x[i - 1];
+        uint32_t t = 0;
+        for (uint32_t q = 1u << (hilbertBits_ - 1); q > 1; q >>= 1)
+            if (x[dimWorld - 1] & q)
+                t ^= q - 1;
+        for (unsigned i = 0; i < dimWorld; ++i)
+            x[i] ^= t;
+
+        // interleave the bits of the transposed representation
+        uint64_t key = 0;
+        for (int b = hilbertBits_ - 1; b >= 0; --b)
+            for (unsigned i = 0; i < dimWorld; ++i)
+                key = (key << 1) | ((x[i] >> b) & 1u);
+        return key;
+    }
+
+    static constexpr int hilbertBits_ = 63/dimWorld < 31 ? 63/dimWorld : 31;
+
+    GridView gridView_;
+    BaseMapper mapper_;
+    Ordering_ ordering_;
+    bool mapsVertices_ = false;
+
+    // maps the indices of the underlying mapper to the reordered ones. this is empty
+    // if the indices are not reordered.
+    std::vector<Index> permutation_;
+};
+
+} // namespace Opm
+
+#endif
@@ -0,0 +1,221 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::SparsityPattern
+ */
+#ifndef EWOMS_SPARSITY_PATTERN_HH
+#define EWOMS_SPARSITY_PATTERN_HH
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \brief Builds the sparsity pattern of a matrix in compressed row storage format.
+ *
+ * The non-zero entries are collected by several threads concurrently. Each thread
+ * appends them to its own flat buffer, so that no locks need to be taken and no memory
+ * needs to be allocated for individual rows. Once all entries have been added,
+ * finalize() sorts the buffers, removes duplicate entries and produces the row offsets
+ * and column indices of the pattern.
+ */
+class SparsityPattern
+{
+    using Entry_ = uint64_t;
+
+public:
+    /*!
+     * \brief Create an empty sparsity pattern.
+     *
+     * \param numRows The number of rows of the matrix.
+     * \param numThreads The number of threads which add entries concurrently.
+     */
+    SparsityPattern(size_t numRows, unsigned numThreads)
+        : numRows_(numRows)
+        , threadBuffers_(std::max(numThreads, 1u))
+        , compactedSize_(std::max(numThreads, 1u), 0)
+    {}
+
+    /*!
+     * \brief Returns the number of rows of the matrix.
+     */
+    size_t numRows() const
+    { return numRows_; }
+
+    /*!
+     * \brief Add an entry to the pattern.
+     *
+     * Adding an entry more than once is allowed. This method may be called concurrently
+     * for different thread indices.
+     */
+    void addEntry(unsigned threadId, unsigned rowIdx, unsigned colIdx)
+    {
+        assert(threadId < threadBuffers_.size());
+        assert(rowIdx < numRows_);
+
+        auto& buffer = threadBuffers_[threadId];
+        buffer.push_back((static_cast<Entry_>(rowIdx) << 32) | colIdx);
+
+        // remove duplicate entries from time to time to limit the memory required by
+        // the buffer
+        if (buffer.size() >= 2*compactedSize_[threadId] + minCompactionSize_) {
+            compact_(buffer);
+            compactedSize_[threadId] = buffer.size();
+        }
+    }
+
+    /*!
+     * \brief Add all entries of a row-wise pattern, e.g. std::vector<std::set<unsigned> >.
+     *
+     * This method must not be called concurrently with addEntry() for thread 0.
+     */
+    template <class NeighborSet>
+    void addNeighbors(const std::vector<NeighborSet>& neighbors)
+    {
+        assert(neighbors.size() <= numRows_);
+        for (size_t rowIdx = 0; rowIdx < neighbors.size(); ++rowIdx)
+            for (unsigned colIdx : neighbors[rowIdx])
+                addEntry(/*threadId=*/0, static_cast<unsigned>(rowIdx), colIdx);
+    }
+
+    /*!
+     * \brief Convert the collected entries to compressed row storage format.
+     *
+     * This method must be called in a sequential context. The rows are distributed
+     * amongst the threads, i.e., the work is done in parallel if OpenMP is available.
+     */
+    void finalize()
+    {
+        size_t numThreads = threadBuffers_.size();
+
+        // sort the entries of each buffer
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t threadId = 0; threadId < numThreads; ++threadId)
+            compact_(threadBuffers_[threadId]);
+
+        // each thread gathers the entries of a contiguous block of rows from all
+        // buffers. since the buffers are sorted, the entries of a block are also
+        // contiguous in each buffer.
+        std::vector<std::vector<unsigned> > blockColumnIndices(numThreads);
+        std::vector<size_t> blockOffsets(numThreads + 1, 0);
+        rowOffsets_.assign(numRows_ + 1, 0);
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t blockIdx = 0; blockIdx < numThreads; ++blockIdx) {
+            size_t beginRow = (numRows_*blockIdx)/numThreads;
+            size_t endRow = (numRows_*(blockIdx + 1))/numThreads;
+            Entry_ beginEntry = static_cast<Entry_>(beginRow) << 32;
+            Entry_ endEntry = static_cast<Entry_>(endRow) << 32;
+
+            std::vector<Entry_> blockEntries;
+            for (const auto& buffer : threadBuffers_) {
+                auto it = std::lower_bound(buffer.begin(), buffer.end(), beginEntry);
+                auto endIt = std::lower_bound(it, buffer.end(), endEntry);
+                blockEntries.insert(blockEntries.end(), it, endIt);
+            }
+            compact_(blockEntries);
+
+            auto& colIndices = blockColumnIndices[blockIdx];
+            colIndices.resize(blockEntries.size());
+            for (size_t i = 0; i < blockEntries.size(); ++i) {
+                size_t rowIdx = static_cast<size_t>(blockEntries[i] >> 32);
+                colIndices[i] = static_cast<unsigned>(blockEntries[i] & 0xffffffff);
+                ++ rowOffsets_[rowIdx + 1];
+            }
+            blockOffsets[blockIdx + 1] = blockEntries.size();
+        }
+
+        // the buffers are not required anymore
+        threadBuffers_.clear();
+        compactedSize_.clear();
+
+        for (size_t blockIdx = 0; blockIdx < numThreads; ++blockIdx)
+            blockOffsets[blockIdx + 1] += blockOffsets[blockIdx];
+        for (size_t rowIdx = 0; rowIdx < numRows_; ++rowIdx)
+            rowOffsets_[rowIdx + 1] += rowOffsets_[rowIdx];
+
+        columnIndices_.resize(blockOffsets[numThreads]);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for (size_t blockIdx = 0; blockIdx < numThreads; ++blockIdx) {
+            std::copy(blockColumnIndices[blockIdx].begin(),
+                      blockColumnIndices[blockIdx].end(),
+                      columnIndices_.begin() + static_cast<std::ptrdiff_t>(blockOffsets[blockIdx]));
+            std::vector<unsigned>().swap(blockColumnIndices[blockIdx]);
+        }
+    }
+
+    /*!
+     * \brief Returns the offsets of the rows in the array of column indices.
+     *
+     * The column indices of row i are [rowOffsets()[i], rowOffsets()[i + 1]). This is
+     * only valid after finalize() has been called.
+     */
+    const std::vector<size_t>& rowOffsets() const
+    { return rowOffsets_; }
+
+    /*!
+     * \brief Returns the sorted column indices of all rows.
+     *
+     * This is only valid after finalize() has been called.
+     */
+    const std::vector<unsigned>& columnIndices() const
+    { return columnIndices_; }
+
+    /*!
+     * \brief Returns the number of non-zero entries of a row.
+     *
+     * This is only valid after finalize() has been called.
+     */
+    size_t rowSize(size_t rowIdx) const
+    { return rowOffsets_[rowIdx + 1] - rowOffsets_[rowIdx]; }
+
+private:
+    static void compact_(std::vector<Entry_>& entries)
+    {
+        std::sort(entries.begin(), entries.end());
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    }
+
+    static constexpr size_t minCompactionSize_ = 1 << 20;
+
+    size_t numRows_;
+    std::vector<std::vector<Entry_> > threadBuffers_;
+    std::vector<size_t> compactedSize_;
+
+    std::vector<size_t> rowOffsets_;
+    std::vector<unsigned> columnIndices_;
+};
+
+} // namespace Opm
+
+#endif
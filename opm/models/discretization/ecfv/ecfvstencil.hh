@@ -50,11 +50,15 @@ namespace Opm {
  * The ECFV discretization is a element centered finite volume
  * approach. This means that each element corresponds to a control
  * volume.
+ *
+ * The global indices of the degrees of freedom are determined by an ElementMapper,
+ * which may reorder the elements of the grid.
  */
 template <class Scalar,
           class GridView,
           bool needFaceIntegrationPos = true,
-          bool needFaceNormal = true>
+          bool needFaceNormal = true,
+          class ElementMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView> >
 class EcfvStencil
 {
     enum { dimWorld = GridView::dimensionworld };
@@ -63,8 +67,6 @@ class EcfvStencil
     using Intersection = typename GridView::Intersection;
     using Element = typename GridView::template Codim<0>::Entity;
 
-    using ElementMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
-
     using GlobalPosition = Dune::FieldVector<CoordScalar, dimWorld>;
 
     using WorldVector = Dune::FieldVector<Scalar, dimWorld>;
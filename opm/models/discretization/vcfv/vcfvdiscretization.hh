@@ -59,9 +59,10 @@ struct Stencil<TypeTag, TTag::VcfvDiscretization>
 private:
     using GridView = GetPropType<TypeTag, Properties::GridView>;
     using CoordScalar = typename GridView::ctype;
+    using VertexMapper = GetPropType<TypeTag, Properties::VertexMapper>;
 
 public:
-    using type = Opm::VcfvStencil<CoordScalar, GridView>;
+    using type = Opm::VcfvStencil<CoordScalar, GridView, VertexMapper>;
 };
 
 //! Mapper for the degrees of freedoms.
@@ -463,8 +463,13 @@ VcfvScvGeometries<Scalar, /*dim=*/3, ElementType::cube>::scvGeoms_[
  * For the vertex-cented finite volume method the sub-control volumes
  * are constructed by connecting the element's center with each edge
  * of the element.
+ *
+ * The global indices of the degrees of freedom are determined by a VertexMapper,
+ * which may reorder the vertices of the grid.
  */
-template <class Scalar, class GridView>
+template <class Scalar,
+          class GridView,
+          class VertexMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView> >
 class VcfvStencil
 {
     enum{dim = GridView::dimension};
@@ -724,7 +729,7 @@ private:
 
 public:
     //! exported Mapper type
-    using Mapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+    using Mapper = VertexMapper;
 
     class ScvGeometry
     {
@@ -1012,7 +1017,9 @@ public:
             }
         }
 
-        updateScvGeometry(e);
+        // the geometries of the sub-control volumes refer to the stencil's own copy of
+        // the element, so that the stencil stays valid after 'e' goes out of scope
+        updateScvGeometry(element_);
     }
 
     void updateScvGeometry(const Element& element)
@@ -1381,9 +1388,9 @@ private:
 };
 
 #if HAVE_DUNE_LOCALFUNCTIONS
-template<class Scalar, class GridView>
-typename VcfvStencil<Scalar, GridView>::LocalFiniteElementCache
-VcfvStencil<Scalar, GridView>::feCache_;
+template<class Scalar, class GridView, class VertexMapper>
+typename VcfvStencil<Scalar, GridView, VertexMapper>::LocalFiniteElementCache
+VcfvStencil<Scalar, GridView, VertexMapper>::feCache_;
 #endif // HAVE_DUNE_LOCALFUNCTIONS
 
 } // namespace Opm
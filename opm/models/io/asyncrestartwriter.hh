@@ -0,0 +1,173 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::AsyncRestartWriter
+ */
+#ifndef EWOMS_ASYNC_RESTART_WRITER_HH
+#define EWOMS_ASYNC_RESTART_WRITER_HH
+
+#include <opm/models/io/restart.hh>
+#include <opm/models/parallel/tasklets.hh>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace Opm {
+
+/*!
+ * \brief Writes restart files whose data has already been serialized in a background
+ *        thread.
+ *
+ * The serialized data of each restart file is kept in memory until it has been written,
+ * so the number of restart files which may be pending at the same time is limited. If
+ * this limit is reached, write() blocks until the oldest file has been written. Errors
+ * which occur while writing a file are reported by the next call of write() or
+ * finish().
+ */
+class AsyncRestartWriter
+{
+    class WriteTasklet_ : public TaskletInterface
+    {
+    public:
+        WriteTasklet_(AsyncRestartWriter& writer, std::unique_ptr<Restart> restart)
+            : writer_(writer)
+            , restart_(std::move(restart))
+        {}
+
+        void run() final
+        {
+            std::exception_ptr error;
+            try {
+                restart_->writeFile();
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+
+            // release the memory before the next restart file may be serialized
+            restart_.reset();
+            writer_.fileWritten_(error);
+        }
+
+    private:
+        AsyncRestartWriter& writer_;
+        std::unique_ptr<Restart> restart_;
+    };
+
+public:
+    /*!
+     * \brief Create a writer.
+     *
+     * \param asyncWriting If false, the files are written immediately by write().
+     * \param maxPending The maximum number of restart files which have been passed to
+     *                   write() but which are not yet written completely.
+     */
+    AsyncRestartWriter(bool asyncWriting, unsigned maxPending)
+        : taskletRunner_(/*numThreads=*/asyncWriting?1:0)
+        , maxPending_(std::max(maxPending, 1u))
+        , numPending_(0)
+    {}
+
+    AsyncRestartWriter(const AsyncRestartWriter&) = delete;
+
+    ~AsyncRestartWriter()
+    { taskletRunner_.barrier(); }
+
+    /*!
+     * \brief Write a restart file for which Restart::finishSerialization() has been
+     *        called.
+     */
+    void write(std::unique_ptr<Restart> restart)
+    {
+        rethrowError_();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            fileWrittenCondition_.wait(lock, [this] { return numPending_ < maxPending_; });
+            ++ numPending_;
+        }
+
+        taskletRunner_.dispatch(std::make_shared<WriteTasklet_>(*this, std::move(restart)));
+
+        // in synchronous mode, the file has been written at this point
+        if (taskletRunner_.numWorkerThreads() == 0)
+            rethrowError_();
+    }
+
+    /*!
+     * \brief Wait until all restart files have been written.
+     */
+    void finish()
+    {
+        taskletRunner_.barrier();
+        rethrowError_();
+    }
+
+    /*!
+     * \brief Returns the number of restart files which are not yet written completely.
+     */
+    unsigned numPending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return numPending_;
+    }
+
+private:
+    void fileWritten_(std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            -- numPending_;
+            if (error && !error_)
+                error_ = error;
+        }
+        fileWrittenCondition_.notify_all();
+    }
+
+    void rethrowError_()
+    {
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::swap(error, error_);
+        }
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    TaskletRunner taskletRunner_;
+    unsigned maxPending_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable fileWrittenCondition_;
+    unsigned numPending_;
+    std::exception_ptr error_;
+};
+
+} // namespace Opm
+
+#endif
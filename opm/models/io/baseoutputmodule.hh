@@ -145,6 +145,17 @@ public:
     virtual bool needExtensiveQuantities() const
     { return false; }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job.
+     *
+     * If no module needs to look at the elements, the sweep over the grid is skipped
+     * when the output fields are prepared. Returning true here is always correct, so
+     * this is the default.
+     */
+    virtual bool needElementContext() const
+    { return true; }
+
 protected:
     enum BufferType {
         //! Buffer contains data associated with the degrees of freedom
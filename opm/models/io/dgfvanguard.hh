@@ -30,6 +30,7 @@
 #include <dune/grid/io/file/dgfparser/dgfparser.hh>
 #include <dune/grid/common/mcmgmapper.hh>
 #include <opm/models/discretefracture/fracturemapper.hh>
+#include <opm/models/discretization/common/reorderedmapper.hh>
 
 #include <opm/models/io/basevanguard.hh>
 #include <opm/models/utils/propertysystem.hh>
@@ -145,8 +146,10 @@ protected:
         LevelGridView gridView = dgfPointer->levelGridView(/*level=*/0);
         const unsigned edgeCodim = Grid::dimension - 1;
 
-        using VertexMapper = Dune::MultipleCodimMultipleGeomTypeMapper<LevelGridView>;
-        VertexMapper vertexMapper(gridView, Dune::mcmgVertexLayout());
+        // the fracture vertices must be numbered like the degrees of freedom of the model
+        using VertexMapper = Opm::ReorderedMapper<LevelGridView>;
+        VertexMapper vertexMapper(gridView, Dune::mcmgVertexLayout(),
+                                  EWOMS_GET_PARAM(TypeTag, std::string, DofOrdering));
 
         // first create a map of the dune to ART vertex indices
         auto eIt = gridView.template begin</*codim=*/0>();
@@ -180,6 +183,9 @@ protected:
                     fractureMapper_.addFractureEdge(vertexIndices[0], vertexIndices[1]);
             }
         }
+
+        // convert the fracture edges to the representation used by the queries
+        fractureMapper_.finalize(static_cast<unsigned>(vertexMapper.size()));
     }
 
 private:
@@ -27,43 +27,175 @@
 #ifndef EWOMS_RESTART_HH
 #define EWOMS_RESTART_HH
 
-#include <string>
+#include <dune/common/classname.hh>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace Opm {
 
 /*!
  * \brief Load or save a state of a problem to/from the harddisk.
+ *
+ * Restart files are binary containers. They start with a header which specifies the
+ * layout of the grid, the number of processes and the floating point type used for the
+ * simulation, followed by a sequence of named sections and a trailer. Each section is
+ * protected by a checksum. The data of a section is accumulated in memory and the whole
+ * file is written using a single write operation. For reading, the file is mapped into
+ * memory and the sections are deserialized directly from the mapped region.
+ *
+ * The objects which get (de-)serialized use the serializeStream() and
+ * deserializeStream() methods to access the data of the current section. Besides
+ * formatted text, raw binary values may be stored using serializeValue() and
+ * deserializeValue().
  */
 class Restart
 {
+    static constexpr char fileMagic_[8] = { 'e', 'W', 'o', 'm', 's', 'R', 'S', 'T' };
+    static constexpr char trailerMagic_[8] = { 'e', 'W', 'o', 'm', 's', 'E', 'O', 'F' };
+    static constexpr uint32_t formatVersion_ = 1;
+    static constexpr uint32_t byteOrderMark_ = 0x01020304;
+
     /*!
-     * \brief Create a magic cookie for restart files, so that it is
-     *        unlikely to load a restart file for an incorrectly.
+     * \brief The information about the simulation which is stored in the header of
+     *        restart files.
      */
-    template <class GridView>
-    static const std::string magicRestartCookie_(const GridView& gridView)
+    struct Header_
     {
-        static const std::string gridName = "blubb"; // gridView.grid().name();
-        static const int dim = GridView::dimension;
+        uint32_t numProcesses;
+        uint32_t rank;
+        uint32_t dimension;
+        uint64_t numElements;
+        uint64_t numVertices;
+        uint32_t scalarSize;
+        std::string scalarName;
+    };
 
-        int numVertices = gridView.size(dim);
-        int numElements = gridView.size(0);
-        int numEdges = gridView.size(dim - 1);
-        int numCPUs = gridView.comm().size();
-        int rank = gridView.comm().rank();
+    /*!
+     * \brief A stream buffer which reads from a contiguous region of memory without
+     *        copying it.
+     */
+    class MemoryStreamBuffer_ : public std::streambuf
+    {
+    public:
+        void setRange(const char* begin, const char* end)
+        {
+            char* b = const_cast<char*>(begin);
+            setg(b, b, const_cast<char*>(end));
+        }
 
-        std::ostringstream oss;
-        oss << "eWoms restart file: "
-            << "gridName='" << gridName << "' "
-            << "numCPUs=" << numCPUs << " "
-            << "myRank=" << rank << " "
-            << "numElements=" << numElements << " "
-            << "numEdges=" << numEdges << " "
-            << "numVertices=" << numVertices;
-        return oss.str();
+        const char* current() const
+        { return gptr(); }
+
+        const char* end() const
+        { return egptr(); }
+    };
+
+    /*!
+     * \brief A read-only memory mapping of a file.
+     */
+    class MappedFile_
+    {
+    public:
+        MappedFile_()
+            : data_(nullptr)
+            , size_(0)
+        {}
+
+        MappedFile_(const MappedFile_&) = delete;
+
+        ~MappedFile_()
+        { close(); }
+
+        void open(const std::string& fileName)
+        {
+            close();
+
+            int fd = ::open(fileName.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Restart file '"+fileName+"' could not be opened properly");
+
+            struct stat fileStat;
+            if (::fstat(fd, &fileStat) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Could not determine the size of restart file '"+fileName+"'");
+            }
+
+            size_ = static_cast<size_t>(fileStat.st_size);
+            if (size_ == 0) {
+                ::close(fd);
+                throw std::runtime_error("Restart file '"+fileName+"' is empty");
+            }
+
+            void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, /*offset=*/0);
+            ::close(fd);
+            if (addr == MAP_FAILED) {
+                size_ = 0;
+                throw std::runtime_error("Restart file '"+fileName+"' could not be mapped into memory");
+            }
+
+            // the file is read sequentially
+            ::madvise(addr, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(addr);
+        }
+
+        void close()
+        {
+            if (data_)
+                ::munmap(const_cast<char*>(data_), size_);
+            data_ = nullptr;
+            size_ = 0;
+        }
+
+        const char* data() const
+        { return data_; }
+
+        size_t size() const
+        { return size_; }
+
+    private:
+        const char* data_;
+        size_t size_;
+    };
+
+    /*!
+     * \brief The location of a checksum which still needs to be computed.
+     */
+    struct PendingChecksum_
+    {
+        size_t checksumPos;
+        size_t payloadPos;
+        size_t payloadSize;
+    };
+
+    template <class Scalar, class GridView>
+    static Header_ header_(const GridView& gridView)
+    {
+        Header_ header;
+        header.numProcesses = static_cast<uint32_t>(gridView.comm().size());
+        header.rank = static_cast<uint32_t>(gridView.comm().rank());
+        header.dimension = static_cast<uint32_t>(GridView::dimension);
+        header.numElements = static_cast<uint64_t>(gridView.size(/*codim=*/0));
+        header.numVertices = static_cast<uint64_t>(gridView.size(GridView::dimension));
+        header.scalarSize = static_cast<uint32_t>(sizeof(Scalar));
+        header.scalarName = Dune::className<Scalar>();
+        return header;
     }
 
     /*!
@@ -87,31 +219,185 @@ class Restart
         return oss.str();
     }
 
+    /*!
+     * \brief Compute the checksum of a range of bytes.
+     *
+     * This is a variant of the FNV-1a hash which consumes 64 bits at a time.
+     */
+    static uint64_t checksum_(const char* data, size_t size)
+    {
+        constexpr uint64_t prime = 0x100000001b3ULL;
+        uint64_t hash = 0xcbf29ce484222325ULL;
+
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word)*prime;
+        }
+        for (; i < size; ++i)
+            hash = (hash ^ static_cast<unsigned char>(data[i]))*prime;
+
+        return hash;
+    }
+
+    template <class T>
+    void appendRaw_(const T& value)
+    { fileBuffer_.append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    void appendString_(const std::string& value)
+    {
+        appendRaw_(static_cast<uint32_t>(value.size()));
+        fileBuffer_.append(value);
+    }
+
+    template <class T>
+    void extractRaw_(T& value)
+    {
+        if (mappedFile_.size() - readPos_ < sizeof(T))
+            throw std::runtime_error("Restart file '"+fileName_+"' is truncated");
+        std::memcpy(&value, mappedFile_.data() + readPos_, sizeof(T));
+        readPos_ += sizeof(T);
+    }
+
+    std::string extractString_()
+    {
+        uint32_t length;
+        extractRaw_(length);
+        if (mappedFile_.size() - readPos_ < length)
+            throw std::runtime_error("Restart file '"+fileName_+"' is truncated");
+        std::string result(mappedFile_.data() + readPos_, length);
+        readPos_ += length;
+        return result;
+    }
+
+    void writeHeader_(const Header_& header)
+    {
+        fileBuffer_.append(fileMagic_, sizeof(fileMagic_));
+        appendRaw_(formatVersion_);
+        appendRaw_(byteOrderMark_);
+        appendRaw_(header.numProcesses);
+        appendRaw_(header.rank);
+        appendRaw_(header.dimension);
+        appendRaw_(header.numElements);
+        appendRaw_(header.numVertices);
+        appendRaw_(header.scalarSize);
+        appendString_(header.scalarName);
+    }
+
+    void checkHeader_(const Header_& expected)
+    {
+        if (mappedFile_.size() < sizeof(fileMagic_)
+            || std::memcmp(mappedFile_.data(), fileMagic_, sizeof(fileMagic_)) != 0)
+            throw std::runtime_error("File '"+fileName_+"' is not a restart file");
+        readPos_ = sizeof(fileMagic_);
+
+        uint32_t version, byteOrderMark;
+        extractRaw_(version);
+        extractRaw_(byteOrderMark);
+        if (byteOrderMark != byteOrderMark_)
+            throw std::runtime_error("Restart file '"+fileName_+"' was written on a machine "
+                                     "with a different byte order");
+        if (version != formatVersion_)
+            throw std::runtime_error("Restart file '"+fileName_+"' uses the unsupported format version "
+                                     +std::to_string(version));
+
+        Header_ header;
+        extractRaw_(header.numProcesses);
+        extractRaw_(header.rank);
+        extractRaw_(header.dimension);
+        extractRaw_(header.numElements);
+        extractRaw_(header.numVertices);
+        extractRaw_(header.scalarSize);
+        header.scalarName = extractString_();
+
+        auto checkField = [this](const std::string& name, auto fileValue, auto expectedValue) {
+            if (fileValue != expectedValue) {
+                std::ostringstream oss;
+                oss << "Restart file '" << fileName_ << "' does not match the simulation: "
+                    << name << " is " << fileValue << " instead of " << expectedValue;
+                throw std::runtime_error(oss.str());
+            }
+        };
+        checkField("the number of processes", header.numProcesses, expected.numProcesses);
+        checkField("the rank", header.rank, expected.rank);
+        checkField("the grid dimension", header.dimension, expected.dimension);
+        checkField("the number of elements", header.numElements, expected.numElements);
+        checkField("the number of vertices", header.numVertices, expected.numVertices);
+        checkField("the size of the scalar type", header.scalarSize, expected.scalarSize);
+        checkField("the scalar type", header.scalarName, expected.scalarName);
+
+        // make sure that the file is complete
+        size_t trailerSize = sizeof(trailerMagic_) + sizeof(uint64_t);
+        if (mappedFile_.size() < readPos_ + trailerSize
+            || std::memcmp(mappedFile_.data() + mappedFile_.size() - trailerSize,
+                           trailerMagic_, sizeof(trailerMagic_)) != 0)
+            throw std::runtime_error("Restart file '"+fileName_+"' is truncated");
+    }
+
 public:
+    Restart()
+        : inStream_(&inBuffer_)
+        , readPos_(0)
+        , numSections_(0)
+        , sectionOpen_(false)
+    {}
+
+    Restart(const Restart&) = delete;
+
     /*!
      * \brief Returns the name of the file which is (de-)serialized.
      */
     const std::string& fileName() const
     { return fileName_; }
 
+    /*!
+     * \brief Write the raw binary representation of a value to a stream of a restart
+     *        file.
+     */
+    template <class T>
+    static void serializeValue(std::ostream& outStream, const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only trivially copyable objects can be serialized as binary values");
+        outStream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /*!
+     * \brief Read a value which was written using serializeValue() from a stream of a
+     *        restart file.
+     */
+    template <class T>
+    static void deserializeValue(std::istream& inStream, T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Only trivially copyable objects can be deserialized as binary values");
+        if (!inStream.read(reinterpret_cast<char*>(&value), sizeof(T)))
+            throw std::runtime_error("Encountered unexpected EOF in restart file.");
+    }
+
     /*!
      * \brief Write the current state of the model to disk.
      */
     template <class Simulator>
     void serializeBegin(Simulator& simulator)
     {
-        const std::string magicCookie = magicRestartCookie_(simulator.gridView());
+        using Scalar = typename std::decay<decltype(simulator.time())>::type;
+
         fileName_ = restartFileName_(simulator.gridView(),
                                      simulator.problem().outputDir(),
                                      simulator.problem().name(),
                                      simulator.time());
 
-        // open output file and write magic cookie
-        outStream_.open(fileName_.c_str());
-        outStream_.precision(20);
+        fileBuffer_.clear();
+        pendingChecksums_.clear();
+        numSections_ = 0;
+        sectionOpen_ = false;
+        writeHeader_(header_<Scalar>(simulator.gridView()));
 
-        serializeSectionBegin(magicCookie);
-        serializeSectionEnd();
+        outStream_.str("");
+        outStream_.clear();
+        outStream_.precision(std::numeric_limits<Scalar>::max_digits10);
     }
 
     /*!
@@ -124,13 +410,44 @@ public:
      * \brief Start a new section in the serialized output.
      */
     void serializeSectionBegin(const std::string& cookie)
-    { outStream_ << cookie << "\n"; }
+    {
+        if (sectionOpen_)
+            throw std::logic_error("Section '"+cookie+"' started before section '"
+                                   +sectionName_+"' was finished");
+
+        sectionName_ = cookie;
+        sectionOpen_ = true;
+        outStream_.str("");
+        outStream_.clear();
+    }
 
     /*!
      * \brief End of a section in the serialized output.
      */
     void serializeSectionEnd()
-    { outStream_ << "\n"; }
+    {
+        if (!sectionOpen_)
+            throw std::logic_error("No section of the restart file has been started");
+        if (!outStream_.good())
+            throw std::runtime_error("Could not serialize section '"+sectionName_+"'");
+
+        // the checksum is computed by writeFile(), which may be called by a different
+        // thread than the one which serializes the data
+        const std::string& payload = outStream_.str();
+        appendString_(sectionName_);
+        appendRaw_(static_cast<uint64_t>(payload.size()));
+        PendingChecksum_ pending;
+        pending.checksumPos = fileBuffer_.size();
+        pending.payloadPos = pending.checksumPos + sizeof(uint64_t);
+        pending.payloadSize = payload.size();
+        pendingChecksums_.push_back(pending);
+        appendRaw_(static_cast<uint64_t>(0));
+        fileBuffer_.append(payload);
+
+        ++ numSections_;
+        sectionOpen_ = false;
+        outStream_.str("");
+    }
 
     /*!
      * \brief Serialize all leaf entities of a codim in a gridView.
@@ -152,17 +469,62 @@ public:
         const Iterator& endIt = gridView.template end<codim>();
         for (; it != endIt; ++it) {
             serializer.serializeEntity(outStream_, *it);
-            outStream_ << "\n";
+            outStream_.put('\n');
         }
 
         serializeSectionEnd();
     }
 
     /*!
-     * \brief Finish the restart file.
+     * \brief Finish the serialization of the data without writing the file.
+     *
+     * Afterwards, the data is independent of the serialized objects and writeFile()
+     * can be called by any thread.
+     */
+    void finishSerialization()
+    {
+        if (sectionOpen_)
+            throw std::logic_error("Section '"+sectionName_+"' of the restart file was not finished");
+
+        fileBuffer_.append(trailerMagic_, sizeof(trailerMagic_));
+        appendRaw_(static_cast<uint64_t>(numSections_));
+        std::ostringstream().swap(outStream_);
+    }
+
+    /*!
+     * \brief Write the data of a restart file whose serialization has been finished.
+     *
+     * The file is first written to a temporary file which is renamed afterwards, so
+     * that an existing restart file is never replaced by an incomplete one.
+     */
+    void writeFile()
+    {
+        for (const auto& pending : pendingChecksums_) {
+            uint64_t checksum = checksum_(fileBuffer_.data() + pending.payloadPos, pending.payloadSize);
+            std::memcpy(&fileBuffer_[pending.checksumPos], &checksum, sizeof(checksum));
+        }
+        pendingChecksums_.clear();
+
+        std::string tmpFileName = fileName_ + ".tmp";
+        std::ofstream os(tmpFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+        os.write(fileBuffer_.data(), static_cast<std::streamsize>(fileBuffer_.size()));
+        os.close();
+        if (!os)
+            throw std::runtime_error("Could not write restart file '"+tmpFileName+"'");
+        if (std::rename(tmpFileName.c_str(), fileName_.c_str()) != 0)
+            throw std::runtime_error("Could not rename '"+tmpFileName+"' to '"+fileName_+"'");
+
+        std::string().swap(fileBuffer_);
+    }
+
+    /*!
+     * \brief Finish the restart file and write it to disk.
      */
     void serializeEnd()
-    { outStream_.close(); }
+    {
+        finishSerialization();
+        writeFile();
+    }
 
     /*!
      * \brief Start reading a restart file at a certain simulated
@@ -171,26 +533,14 @@ public:
     template <class Simulator, class Scalar>
     void deserializeBegin(Simulator& simulator, Scalar t)
     {
-        fileName_ = restartFileName_(simulator.gridView(), simulator.problem().outputDir(), simulator.problem().name(), t);
-
-        // open input file and read magic cookie
-        inStream_.open(fileName_.c_str());
-        if (!inStream_.good()) {
-            throw std::runtime_error("Restart file '"+fileName_+"' could not be opened properly");
-        }
-
-        // make sure that we don't open an empty file
-        inStream_.seekg(0, std::ios::end);
-        auto pos = inStream_.tellg();
-        if (pos == 0) {
-            throw std::runtime_error("Restart file '"+fileName_+"' is empty");
-        }
-        inStream_.seekg(0, std::ios::beg);
+        using SimulatorScalar = typename std::decay<decltype(simulator.time())>::type;
 
-        const std::string magicCookie = magicRestartCookie_(simulator.gridView());
+        fileName_ = restartFileName_(simulator.gridView(), simulator.problem().outputDir(), simulator.problem().name(), t);
 
-        deserializeSectionBegin(magicCookie);
-        deserializeSectionEnd();
+        mappedFile_.open(fileName_);
+        checkHeader_(header_<SimulatorScalar>(simulator.gridView()));
+        numSections_ = 0;
+        sectionOpen_ = false;
     }
 
     /*!
@@ -205,12 +555,29 @@ public:
      */
     void deserializeSectionBegin(const std::string& cookie)
     {
-        if (!inStream_.good())
+        if (!mappedFile_.data())
             throw std::runtime_error("Encountered unexpected EOF in restart file.");
-        std::string buf;
-        std::getline(inStream_, buf);
-        if (buf != cookie)
+
+        std::string name = extractString_();
+        if (name != cookie)
             throw std::runtime_error("Could not start section '"+cookie+"'");
+
+        uint64_t size, checksum;
+        extractRaw_(size);
+        extractRaw_(checksum);
+        if (mappedFile_.size() - readPos_ < size)
+            throw std::runtime_error("Restart file '"+fileName_+"' is truncated");
+
+        const char* payload = mappedFile_.data() + readPos_;
+        if (checksum_(payload, static_cast<size_t>(size)) != checksum)
+            throw std::runtime_error("Restart file '"+fileName_+"' is corrupted: the checksum of "
+                                     "section '"+cookie+"' does not match");
+        readPos_ += static_cast<size_t>(size);
+
+        inBuffer_.setRange(payload, payload + size);
+        inStream_.clear();
+        sectionName_ = cookie;
+        sectionOpen_ = true;
     }
 
     /*!
@@ -218,13 +585,15 @@ public:
      */
     void deserializeSectionEnd()
     {
-        std::string dummy;
-        std::getline(inStream_, dummy);
-        for (unsigned i = 0; i < dummy.length(); ++i) {
-            if (!std::isspace(dummy[i])) {
-                throw std::logic_error("Encountered unread values while deserializing");
-            }
-        }
+        const char* endPtr = inBuffer_.end();
+        if (std::any_of(inBuffer_.current(), endPtr,
+                        [](char c) { return !std::isspace(static_cast<unsigned char>(c)); }))
+            throw std::logic_error("Encountered unread values while deserializing section '"
+                                   +sectionName_+"'");
+
+        inBuffer_.setRange(endPtr, endPtr);
+        ++ numSections_;
+        sectionOpen_ = false;
     }
 
     /*!
@@ -240,8 +609,6 @@ public:
         std::string cookie = oss.str();
         deserializeSectionBegin(cookie);
 
-        std::string curLine;
-
         // read entity data
         using Iterator = typename GridView::template Codim<codim>::Iterator;
         Iterator it = gridView.template begin<codim>();
@@ -251,9 +618,15 @@ public:
                 throw std::runtime_error("Restart file is corrupted");
             }
 
-            std::getline(inStream_, curLine);
-            std::istringstream curLineStream(curLine);
-            deserializer.deserializeEntity(curLineStream, *it);
+            deserializer.deserializeEntity(inStream_, *it);
+
+            // the data of each entity is terminated by a newline. textual data may be
+            // followed by some blanks.
+            int c = inStream_.get();
+            while (c == ' ' || c == '\t')
+                c = inStream_.get();
+            if (c != '\n')
+                throw std::runtime_error("Restart file is corrupted");
         }
 
         deserializeSectionEnd();
@@ -263,12 +636,36 @@ public:
      * \brief Stop reading the restart file.
      */
     void deserializeEnd()
-    { inStream_.close(); }
+    {
+        // make sure that all sections of the file have been read
+        uint64_t numSections = 0;
+        if (mappedFile_.size() - readPos_ != sizeof(trailerMagic_) + sizeof(numSections))
+            throw std::logic_error("Restart file '"+fileName_+"' contains sections which were not read");
+        std::memcpy(&numSections, mappedFile_.data() + readPos_ + sizeof(trailerMagic_), sizeof(numSections));
+        if (numSections != numSections_)
+            throw std::runtime_error("Restart file '"+fileName_+"' is corrupted");
+
+        mappedFile_.close();
+        readPos_ = 0;
+    }
 
 private:
     std::string fileName_;
-    std::ifstream inStream_;
-    std::ofstream outStream_;
+    std::string sectionName_;
+
+    // serialization
+    std::ostringstream outStream_;
+    std::string fileBuffer_;
+    std::vector<PendingChecksum_> pendingChecksums_;
+
+    // deserialization
+    MappedFile_ mappedFile_;
+    MemoryStreamBuffer_ inBuffer_;
+    std::istream inStream_;
+    size_t readPos_;
+
+    size_t numSections_;
+    bool sectionOpen_;
 };
 } // namespace Opm
 
@@ -208,6 +208,21 @@ public:
             this->commitPhaseBuffer_(baseWriter, "enthalpy_%s", fluidEnthalpies_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        if (!enableEnergy)
+            return false;
+
+        return rockInternalEnergyOutput_()
+            || totalThermalConductivityOutput_()
+            || fluidInternalEnergiesOutput_()
+            || fluidEnthalpiesOutput_();
+    }
+
 private:
     static bool rockInternalEnergyOutput_()
     {
@@ -329,6 +329,25 @@ public:
             this->commitScalarBuffer_(baseWriter, "primary vars meaning", primaryVarsMeaning_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return gasDissolutionFactorOutput_()
+            || oilVaporizationFactorOutput_()
+            || oilFormationVolumeFactorOutput_()
+            || gasFormationVolumeFactorOutput_()
+            || waterFormationVolumeFactorOutput_()
+            || oilSaturationPressureOutput_()
+            || gasSaturationPressureOutput_()
+            || saturatedOilGasDissolutionFactorOutput_()
+            || saturatedGasOilVaporizationFactorOutput_()
+            || saturationRatiosOutput_()
+            || primaryVarsMeaningOutput_();
+    }
+
 private:
     static bool gasDissolutionFactorOutput_()
     {
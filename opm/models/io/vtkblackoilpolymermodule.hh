@@ -236,6 +236,23 @@ public:
             this->commitScalarBuffer_(baseWriter, "water viscosity correction", waterViscosityCorrection_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        if (!enablePolymer)
+            return false;
+
+        return polymerConcentrationOutput_()
+            || polymerDeadPoreVolumeOutput_()
+            || polymerRockDensityOutput_()
+            || polymerAdsorptionOutput_()
+            || polymerViscosityCorrectionOutput_()
+            || waterViscosityCorrectionOutput_();
+    }
+
 private:
     static bool polymerConcentrationOutput_()
     {
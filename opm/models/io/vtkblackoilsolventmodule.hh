@@ -205,6 +205,21 @@ public:
             this->commitScalarBuffer_(baseWriter, "mobility_solvent", solventMobility_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        if (!enableSolvent)
+            return false;
+
+        return solventSaturationOutput_()
+            || solventDensityOutput_()
+            || solventViscosityOutput_()
+            || solventMobilityOutput_();
+    }
+
 private:
     static bool solventSaturationOutput_()
     {
@@ -253,6 +253,21 @@ public:
             this->commitPhaseComponentBuffer_(baseWriter, "fugacityCoeff_%s^%s", fugacityCoeff_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return massFracOutput_()
+            || moleFracOutput_()
+            || totalMassFracOutput_()
+            || totalMoleFracOutput_()
+            || molarityOutput_()
+            || fugacityOutput_()
+            || fugacityCoeffOutput_();
+    }
+
 private:
     static bool massFracOutput_()
     {
@@ -183,6 +183,17 @@ public:
                                               effectiveDiffusionCoefficient_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return tortuosityOutput_()
+            || diffusionCoefficientOutput_()
+            || effectiveDiffusionCoefficientOutput_();
+    }
+
 private:
     static bool tortuosityOutput_()
     {
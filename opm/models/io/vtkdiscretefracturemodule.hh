@@ -315,6 +315,30 @@ public:
         }
     }
 
+    /*!
+     * \brief Returns true iff the module needs to access the extensive quantities of a
+     * context to do its job.
+     *
+     * This is the case if the velocities in the fractures should be written.
+     */
+    virtual bool needExtensiveQuantities() const final
+    { return velocityOutput_(); }
+
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return saturationOutput_()
+            || mobilityOutput_()
+            || relativePermeabilityOutput_()
+            || porosityOutput_()
+            || intrinsicPermeabilityOutput_()
+            || volumeFractionOutput_()
+            || velocityOutput_();
+    }
+
 private:
     static bool saturationOutput_()
     {
@@ -191,6 +191,18 @@ public:
             this->commitPhaseBuffer_(baseWriter, "internalEnergy_%s", internalEnergy_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return solidInternalEnergyOutput_()
+            || thermalConductivityOutput_()
+            || enthalpyOutput_()
+            || internalEnergyOutput_();
+    }
+
 private:
     static bool solidInternalEnergyOutput_()
     {
@@ -414,6 +414,26 @@ public:
         return velocityOutput_() || potentialGradientOutput_();
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return extrusionFactorOutput_()
+            || pressureOutput_()
+            || densityOutput_()
+            || saturationOutput_()
+            || mobilityOutput_()
+            || relativePermeabilityOutput_()
+            || viscosityOutput_()
+            || averageMolarMassOutput_()
+            || porosityOutput_()
+            || intrinsicPermeabilityOutput_()
+            || velocityOutput_()
+            || potentialGradientOutput_();
+    }
+
 private:
     static bool extrusionFactorOutput_()
     {
@@ -31,8 +31,11 @@
 #include "vtkscalarfunction.hh"
 #include "vtkvectorfunction.hh"
 #include "vtktensorfunction.hh"
+#include "vtkstaticgridwriter.hh"
+#include "xdmfwriter.hh"
 
 #include <opm/models/io/baseoutputwriter.hh>
+#include <opm/models/discretization/common/reorderedmapper.hh>
 #include <opm/models/parallel/tasklets.hh>
 
 #include <opm/common/utility/FileSystem.hpp>
@@ -48,7 +51,15 @@
 #include <mpi.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
 #include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <limits>
 #include <sstream>
@@ -61,6 +72,26 @@ namespace Opm {
  * This class automatically keeps the meta file up to date and
  * simplifies writing datasets consisting of multiple files. (i.e.
  * multiple time steps or grid refinements within a time step.)
+ *
+ * The attached buffers are indexed like the mappers of the simulation, i.e., the DOF
+ * ordering which is passed to the constructor must be the one used by the model.
+ *
+ * If the static grid mode is enabled, the files are not written using Dune::VTKWriter,
+ * but using a VtkStaticGridWriter which encodes the geometry of the grid only once
+ * and fills the fields directly from the attached buffers. In this mode, the fields of
+ * a time step are processed concurrently if multiple writer threads are used, and the
+ * simulation only waits until the fields have been copied out of the attached buffers
+ * before it continues. The number of time steps which are waiting to be encoded and
+ * written is limited, i.e., the simulation is stalled if it produces output faster
+ * than it can be written.
+ *
+ * If the XDMF mode is enabled, no VTK files are written at all. Instead, an XdmfWriter
+ * writes the fields of all time steps and all processes to a single container file,
+ * and the multi-file is an XDMF index which refers to this container. Apart from this,
+ * the fields are processed like in the static grid mode, except that the writer
+ * threads are only used if the MPI library may be called from multiple threads. If a
+ * run is restarted, the new time steps are appended to the container of the previous
+ * run, so the restored index stays valid.
  */
 template <class GridView, int vtkFormat>
 class VtkMultiWriter : public BaseOutputWriter
@@ -68,43 +99,115 @@ class VtkMultiWriter : public BaseOutputWriter
     class WriteDataTasklet : public TaskletInterface
     {
     public:
-        WriteDataTasklet(VtkMultiWriter& multiWriter)
+        WriteDataTasklet(VtkMultiWriter& multiWriter, int dataSetIdx)
             : multiWriter_(multiWriter)
+            , dataSetIdx_(dataSetIdx)
         { }
 
         void run() final
         {
             std::string fileName;
-            // write the actual data as vtu or vtp (plus the pieces file in the parallel case)
-            if (multiWriter_.commSize_ > 1)
-                fileName = multiWriter_.curWriter_->pwrite(/*name=*/multiWriter_.curOutFileName_,
-                                                           /*path=*/multiWriter_.outputDir_,
-                                                           /*extendPath=*/"",
-                                                           static_cast<Dune::VTK::OutputType>(vtkFormat));
-            else
-                fileName = multiWriter_.curWriter_->write(/*name=*/multiWriter_.outputDir_ + "/" + multiWriter_.curOutFileName_,
-                                                          static_cast<Dune::VTK::OutputType>(vtkFormat));
+            try {
+                // write the actual data as vtu or vtp (plus the pieces file in the parallel case)
+                if (multiWriter_.commSize_ > 1)
+                    fileName = multiWriter_.curWriter_->pwrite(/*name=*/multiWriter_.curOutFileName_,
+                                                               /*path=*/multiWriter_.outputDir_,
+                                                               /*extendPath=*/"",
+                                                               static_cast<Dune::VTK::OutputType>(vtkFormat));
+                else
+                    fileName = multiWriter_.curWriter_->write(/*name=*/multiWriter_.outputDir_ + "/" + multiWriter_.curOutFileName_,
+                                                              static_cast<Dune::VTK::OutputType>(vtkFormat));
+            }
+            catch (...) {
+                // the data set must be skipped to keep the multi-file consistent
+                multiWriter_.addDataSet_(dataSetIdx_, "");
+                throw;
+            }
 
-            // determine name to write into the multi-file for the
-            // current time step
-            // The file names in the pvd file are relative, the path should therefore be stripped.
-            const Opm::filesystem::path fullPath{fileName};
-            const std::string localFileName = fullPath.filename();
-            multiWriter_.multiFile_.precision(16);
-            multiWriter_.multiFile_ << "   <DataSet timestep=\"" << multiWriter_.curTime_ << "\" file=\""
-                                    << localFileName << "\"/>\n";
+            multiWriter_.addDataSet_(dataSetIdx_, dataSetEntry_(multiWriter_.curTime_, fileName));
         }
 
     private:
         VtkMultiWriter& multiWriter_;
+        int dataSetIdx_;
+    };
+
+    // the state of a time step which is written by a VtkStaticGridWriter or by an
+    // XdmfWriter
+    template <class File>
+    struct StaticOutputStep_
+    {
+        std::shared_ptr<File> file;
+        std::string name;
+        double time;
+        int dataSetIdx;
+        std::atomic<size_t> numUnencodedFields;
+    };
+
+    // fills and encodes a single field of a time step. The tasklet which encodes the
+    // last field also writes the file.
+    template <class File>
+    class WriteStaticFieldTasklet : public TaskletInterface
+    {
+    public:
+        WriteStaticFieldTasklet(VtkMultiWriter& multiWriter,
+                                std::shared_ptr<StaticOutputStep_<File> > step,
+                                size_t fieldIdx)
+            : multiWriter_(multiWriter)
+            , step_(step)
+            , fieldIdx_(fieldIdx)
+        { }
+
+        void run() final
+        {
+            // neither of these methods throws; errors are reported when writing the file
+            step_->file->fillField(fieldIdx_);
+            multiWriter_.fieldFilled_();
+
+            step_->file->encodeField(fieldIdx_);
+            if (--step_->numUnencodedFields == 0)
+                multiWriter_.writeStaticFile_(*step_);
+        }
+
+    private:
+        VtkMultiWriter& multiWriter_;
+        std::shared_ptr<StaticOutputStep_<File> > step_;
+        size_t fieldIdx_;
+    };
+
+    // writes the file of a time step which does not exhibit any fields
+    template <class File>
+    class WriteStaticFileTasklet : public TaskletInterface
+    {
+    public:
+        WriteStaticFileTasklet(VtkMultiWriter& multiWriter,
+                               std::shared_ptr<StaticOutputStep_<File> > step)
+            : multiWriter_(multiWriter)
+            , step_(step)
+        { }
+
+        void run() final
+        { multiWriter_.writeStaticFile_(*step_); }
+
+    private:
+        VtkMultiWriter& multiWriter_;
+        std::shared_ptr<StaticOutputStep_<File> > step_;
     };
 
     enum { dim = GridView::dimension };
 
-    using VertexMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
-    using ElementMapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+    using VertexMapper = Opm::ReorderedMapper<GridView>;
+    using ElementMapper = Opm::ReorderedMapper<GridView>;
+    using StaticGridWriter = Opm::VtkStaticGridWriter<GridView>;
+    using StaticGridFile = typename StaticGridWriter::File;
+    using XdmfWriter = Opm::XdmfWriter<GridView>;
+    using XdmfFile = typename XdmfWriter::File;
+    using Element = typename GridView::template Codim<0>::Entity;
 
 public:
+    //! Selects the elements which are written, i.e., the region of interest
+    using ElementFilter = std::function<bool(const Element&)>;
+
     using Scalar = BaseOutputWriter::Scalar;
     using Vector = BaseOutputWriter::Vector;
     using Tensor = BaseOutputWriter::Tensor;
@@ -117,15 +220,27 @@ public:
 
     VtkMultiWriter(bool asyncWriting,
                    const GridView& gridView,
+                   const ElementMapper& elementMapper,
+                   const VertexMapper& vertexMapper,
                    const std::string& outputDir,
                    const std::string& simName = "",
-                   std::string multiFileName = "")
+                   std::string multiFileName = "",
+                   bool staticGrid = false,
+                   unsigned numWriterThreads = 1,
+                   bool compress = false,
+                   unsigned maxPendingOutputs = 2,
+                   bool xdmfOutput = false)
         : gridView_(gridView)
-        , elementMapper_(gridView, Dune::mcmgElementLayout())
-        , vertexMapper_(gridView, Dune::mcmgVertexLayout())
+        , elementMapper_(elementMapper)
+        , vertexMapper_(vertexMapper)
         , curWriter_(nullptr)
         , curWriterNum_(0)
-        , taskletRunner_(/*numThreads=*/asyncWriting?1:0)
+        , nextDataSetIdx_(0)
+        , nextWrittenDataSetIdx_(0)
+        , numUnfilledFields_(0)
+        , numPendingOutputs_(0)
+        , maxPendingOutputs_(std::max(maxPendingOutputs, 1u))
+        , taskletRunner_(/*numThreads=*/numTaskletThreads_(asyncWriting, staticGrid, xdmfOutput, numWriterThreads))
     {
         outputDir_ = outputDir;
         if (outputDir == "")
@@ -134,10 +249,22 @@ public:
         simName_ = (simName.empty()) ? "sim" : simName;
         multiFileName_ = multiFileName;
         if (multiFileName_.empty())
-            multiFileName_ = outputDir_+"/"+simName_+".pvd";
+            multiFileName_ = outputDir_+"/"+simName_+(xdmfOutput ? ".xmf" : ".pvd");
 
         commRank_ = gridView.comm().rank();
         commSize_ = gridView.comm().size();
+
+        if (xdmfOutput) {
+            if (compress)
+                throw std::runtime_error("Compression is not supported by the XDMF output");
+            xdmfWriter_.reset(new XdmfWriter(gridView, outputDir_, simName_));
+        }
+        else if (staticGrid)
+            staticGridWriter_.reset(new StaticGridWriter(gridView, compress));
+        else if (compress)
+            throw std::runtime_error("Compressed VTK output is only supported if the geometry "
+                                     "of the grid is encoded only once");
+        geometryOutdated_ = true;
     }
 
     ~VtkMultiWriter()
@@ -167,6 +294,28 @@ public:
     {
         elementMapper_.update();
         vertexMapper_.update();
+
+        // the geometry is re-encoded by the next call to beginWrite(), i.e., once the
+        // previous output is guaranteed to be written
+        geometryOutdated_ = true;
+    }
+
+    /*!
+     * \brief Restrict the output to a region of interest.
+     *
+     * Only the elements selected by the filter and their vertices are written. The
+     * fields are not defined outside of the selected elements, so this requires
+     * that the geometry of the grid is encoded only once or XDMF output.
+     */
+    void setElementFilter(const ElementFilter& elementFilter)
+    {
+        if (!staticGridWriter_ && !xdmfWriter_)
+            throw std::runtime_error("Restricting the output to a region of interest requires "
+                                     "that the geometry of the grid is encoded only once or "
+                                     "XDMF output");
+
+        elementFilter_ = elementFilter;
+        geometryOutdated_ = true;
     }
 
     /*!
@@ -178,15 +327,41 @@ public:
             startMultiFile_(multiFileName_);
         }
 
-        // make sure that all previous output has been written and no other thread
-        // accesses the memory used as the target for the extracted quantities
-        taskletRunner_.barrier();
+        if (fillsFieldsDirectly_() && !geometryOutdated_) {
+            // make sure that no other thread accesses the memory used as the target for
+            // the extracted quantities and that not too many time steps are waiting to
+            // be written. The remaining work of the previous time steps is done in the
+            // background.
+            std::unique_lock<std::mutex> lock(outputMutex_);
+            outputCondition_.wait(lock,
+                                  [this]() -> bool
+                                  {
+                                      return numUnfilledFields_ == 0
+                                          && numPendingOutputs_ < maxPendingOutputs_;
+                                  });
+        }
+        else
+            // make sure that all previous output has been written and no other thread
+            // accesses the memory used as the target for the extracted quantities
+            taskletRunner_.barrier();
         releaseBuffers_();
 
         curTime_ = t;
         curOutFileName_ = fileName_();
 
-        curWriter_ = new VtkWriter(gridView_, Dune::VTK::conforming);
+        if (staticGridWriter_) {
+            if (geometryOutdated_)
+                staticGridWriter_->updateGeometry(vertexMapper_, elementMapper_, elementFilter_);
+            curStaticFile_ = staticGridWriter_->createFile();
+        }
+        else if (xdmfWriter_) {
+            if (geometryOutdated_)
+                xdmfWriter_->updateGeometry(vertexMapper_, elementMapper_, elementFilter_);
+            curXdmfFile_ = xdmfWriter_->createFile();
+        }
+        else
+            curWriter_ = new VtkWriter(gridView_, Dune::VTK::conforming);
+        geometryOutdated_ = false;
         ++curWriterNum_;
     }
 
@@ -239,6 +414,11 @@ public:
     {
         sanitizeScalarBuffer_(buf);
 
+        if (fillsFieldsDirectly_()) {
+            attachStaticScalar_(buf, name, /*isCellData=*/false);
+            return;
+        }
+
         using VtkFn = Opm::VtkScalarFunction<GridView, VertexMapper>;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
@@ -267,6 +447,11 @@ public:
     {
         sanitizeScalarBuffer_(buf);
 
+        if (fillsFieldsDirectly_()) {
+            attachStaticScalar_(buf, name, /*isCellData=*/true);
+            return;
+        }
+
         using VtkFn = Opm::VtkScalarFunction<GridView, ElementMapper>;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
@@ -296,6 +481,11 @@ public:
     {
         sanitizeVectorBuffer_(buf);
 
+        if (fillsFieldsDirectly_()) {
+            attachStaticVector_(buf, name, /*isCellData=*/false);
+            return;
+        }
+
         using VtkFn = Opm::VtkVectorFunction<GridView, VertexMapper>;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
@@ -310,6 +500,11 @@ public:
      */
     void attachTensorVertexData(TensorBuffer& buf, std::string name)
     {
+        if (fillsFieldsDirectly_()) {
+            attachStaticTensor_(buf, name, /*isCellData=*/false);
+            return;
+        }
+
         using VtkFn = Opm::VtkTensorFunction<GridView, VertexMapper>;
 
         for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
@@ -345,6 +540,11 @@ public:
     {
         sanitizeVectorBuffer_(buf);
 
+        if (fillsFieldsDirectly_()) {
+            attachStaticVector_(buf, name, /*isCellData=*/true);
+            return;
+        }
+
         using VtkFn = Opm::VtkVectorFunction<GridView, ElementMapper>;
         FunctionPtr fnPtr(new VtkFn(name,
                                     gridView_,
@@ -359,6 +559,11 @@ public:
      */
     void attachTensorElementData(TensorBuffer& buf, std::string name)
     {
+        if (fillsFieldsDirectly_()) {
+            attachStaticTensor_(buf, name, /*isCellData=*/true);
+            return;
+        }
+
         using VtkFn = Opm::VtkTensorFunction<GridView, ElementMapper>;
 
         for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
@@ -384,12 +589,20 @@ public:
      */
     void endWrite(bool onlyDiscard = false)
     {
-        if (!onlyDiscard) {
-            auto tasklet = std::make_shared<WriteDataTasklet>(*this);
+        if (onlyDiscard)
+            --curWriterNum_;
+        else if (staticGridWriter_)
+            dispatchStaticFile_(curStaticFile_);
+        else if (xdmfWriter_) {
+            xdmfWriter_->reserveSpace(curXdmfFile_);
+            dispatchStaticFile_(curXdmfFile_);
+        }
+        else {
+            auto tasklet = std::make_shared<WriteDataTasklet>(*this, nextDataSetIdx_++);
             taskletRunner_.dispatch(tasklet);
         }
-        else
-            --curWriterNum_;
+        curStaticFile_.reset();
+        curXdmfFile_.reset();
 
         // temporarily write the closing XML mumbo-jumbo to the mashup
         // file so that the data set can be loaded even if the
@@ -403,8 +616,14 @@ public:
     template <class Restarter>
     void serialize(Restarter& res)
     {
+        // the multi-file must be complete
+        taskletRunner_.barrier();
+
         res.serializeSectionBegin("VTKMultiWriter");
-        res.serializeStream() << curWriterNum_ << "\n";
+        // the XDMF index refers to the data in the container, so the container must be
+        // continued by a restarted run
+        uint64_t xdmfDataEnd = xdmfWriter_ ? xdmfWriter_->dataEnd() : 0;
+        res.serializeStream() << curWriterNum_ << " " << xdmfDataEnd << "\n";
 
         if (commRank_ == 0) {
             std::streamsize fileLen = 0;
@@ -438,7 +657,10 @@ public:
     void deserialize(Restarter& res)
     {
         res.deserializeSectionBegin("VTKMultiWriter");
-        res.deserializeStream() >> curWriterNum_;
+        uint64_t xdmfDataEnd;
+        res.deserializeStream() >> curWriterNum_ >> xdmfDataEnd;
+        if (xdmfWriter_)
+            xdmfWriter_->restart(xdmfDataEnd);
 
         if (commRank_ == 0) {
             std::string dummy;
@@ -471,6 +693,19 @@ public:
     }
 
 private:
+    // the number of threads which write the output. the XDMF container can only be
+    // written by other threads if the MPI library supports this. otherwise, the output
+    // is written synchronously.
+    static unsigned numTaskletThreads_(bool asyncWriting, bool staticGrid, bool xdmfOutput,
+                                       unsigned numWriterThreads)
+    {
+        if (!asyncWriting || (xdmfOutput && !XdmfWriter::supportsWriterThreads()))
+            return 0;
+        if (staticGrid || xdmfOutput)
+            return std::max(numWriterThreads, 1u);
+        return 1;
+    }
+
     std::string fileName_()
     {
         // use a new file name for each time step
@@ -483,18 +718,28 @@ private:
     std::string fileSuffix_()
     { return (GridView::dimension == 1) ? "vtp" : "vtu"; }
 
+    // returns true if the fields are filled directly from the attached buffers
+    bool fillsFieldsDirectly_() const
+    { return staticGridWriter_ || xdmfWriter_; }
+
     void startMultiFile_(const std::string& multiFileName)
     {
         // only the first process writes to the multi-file
         if (commRank_ == 0) {
-            // generate one meta vtk-file holding the individual time steps
+            // generate one meta file holding the individual time steps
             multiFile_.open(multiFileName.c_str());
-            multiFile_ << "<?xml version=\"1.0\"?>\n"
-                          "<VTKFile type=\"Collection\"\n"
-                          "         version=\"0.1\"\n"
-                          "         byte_order=\"LittleEndian\"\n"
-                          "         compressor=\"vtkZLibDataCompressor\">\n"
-                          " <Collection>\n";
+            if (xdmfWriter_)
+                multiFile_ << "<?xml version=\"1.0\"?>\n"
+                              "<Xdmf Version=\"3.0\">\n"
+                              " <Domain>\n"
+                              "  <Grid Name=\"" << simName_ << "\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+            else
+                multiFile_ << "<?xml version=\"1.0\"?>\n"
+                              "<VTKFile type=\"Collection\"\n"
+                              "         version=\"0.1\"\n"
+                              "         byte_order=\"LittleEndian\"\n"
+                              "         compressor=\"vtkZLibDataCompressor\">\n"
+                              " <Collection>\n";
         }
     }
 
@@ -502,15 +747,178 @@ private:
     {
         // only the first process writes to the multi-file
         if (commRank_ == 0) {
+            std::lock_guard<std::mutex> lock(multiFileMutex_);
+
             // make sure that we always have a working meta file
             std::ofstream::pos_type pos = multiFile_.tellp();
-            multiFile_ << " </Collection>\n"
-                          "</VTKFile>\n";
+            if (xdmfWriter_)
+                multiFile_ << "  </Grid>\n"
+                              " </Domain>\n"
+                              "</Xdmf>\n";
+            else
+                multiFile_ << " </Collection>\n"
+                              "</VTKFile>\n";
             multiFile_.seekp(pos);
             multiFile_.flush();
         }
     }
 
+    // returns the entry of the .pvd file for a VTK file, or an empty string if the file
+    // was not written
+    static std::string dataSetEntry_(double time, const std::string& fileName)
+    {
+        if (fileName.empty())
+            return "";
+
+        // The file names in the pvd file are relative, the path should therefore be stripped.
+        const Opm::filesystem::path fullPath{fileName};
+        const std::string localFileName = fullPath.filename();
+        std::ostringstream oss;
+        oss.precision(16);
+        oss << "   <DataSet timestep=\"" << time << "\" file=\"" << localFileName << "\"/>\n";
+        return oss.str();
+    }
+
+    // add a data set to the multi-file. The data sets are added in the order in which
+    // they were dispatched, independent of which output is finished first. An empty
+    // entry causes the data set to be skipped.
+    void addDataSet_(int dataSetIdx, const std::string& entry)
+    {
+        std::lock_guard<std::mutex> lock(multiFileMutex_);
+
+        finishedDataSets_[dataSetIdx] = entry;
+
+        auto dataSetIt = finishedDataSets_.begin();
+        while (dataSetIt != finishedDataSets_.end() && dataSetIt->first == nextWrittenDataSetIdx_) {
+            multiFile_ << dataSetIt->second;
+            dataSetIt = finishedDataSets_.erase(dataSetIt);
+            ++nextWrittenDataSetIdx_;
+        }
+    }
+
+    // hand the fields of the current time step over to the writer threads
+    template <class File>
+    void dispatchStaticFile_(std::shared_ptr<File> file)
+    {
+        auto step = std::make_shared<StaticOutputStep_<File> >();
+        step->file = file;
+        step->name = curOutFileName_;
+        step->time = curTime_;
+        step->dataSetIdx = nextDataSetIdx_++;
+
+        size_t numFields = file->numFields();
+        step->numUnencodedFields = numFields;
+        {
+            std::lock_guard<std::mutex> lock(outputMutex_);
+            numUnfilledFields_ += numFields;
+            ++numPendingOutputs_;
+        }
+
+        if (numFields == 0)
+            taskletRunner_.dispatch(std::make_shared<WriteStaticFileTasklet<File> >(*this, step));
+        for (size_t fieldIdx = 0; fieldIdx < numFields; ++fieldIdx)
+            taskletRunner_.dispatch(std::make_shared<WriteStaticFieldTasklet<File> >(*this, step, fieldIdx));
+    }
+
+    void fieldFilled_()
+    {
+        {
+            std::lock_guard<std::mutex> lock(outputMutex_);
+            --numUnfilledFields_;
+        }
+        outputCondition_.notify_all();
+    }
+
+    template <class File>
+    void writeStaticFile_(const StaticOutputStep_<File>& step)
+    {
+        std::string entry;
+        try {
+            entry = finishStaticFile_(step);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "ERROR: Could not write output '" << step.name << "': " << e.what() << "\n";
+        }
+        catch (...) {
+            std::cerr << "ERROR: Could not write output '" << step.name << "'\n";
+        }
+        addDataSet_(step.dataSetIdx, entry);
+
+        {
+            std::lock_guard<std::mutex> lock(outputMutex_);
+            --numPendingOutputs_;
+        }
+        outputCondition_.notify_all();
+    }
+
+    // write the VTK file of a time step and return its entry for the multi-file
+    std::string finishStaticFile_(const StaticOutputStep_<StaticGridFile>& step)
+    { return dataSetEntry_(step.time, step.file->write(outputDir_, step.name, commRank_, commSize_)); }
+
+    // the fields of an XDMF time step are already written, so only the entry for the
+    // multi-file is left
+    std::string finishStaticFile_(const StaticOutputStep_<XdmfFile>& step)
+    { return step.file->indexEntry(step.time); }
+
+    // add a field to the file of the current time step
+    void addStaticField_(const std::string& name, bool isCellData, unsigned numComponents,
+                         typename StaticGridWriter::FillFunction fillFn)
+    {
+        if (xdmfWriter_)
+            curXdmfFile_->addField(name, isCellData, numComponents, std::move(fillFn));
+        else
+            curStaticFile_->addField(name, isCellData, numComponents, std::move(fillFn));
+    }
+
+    void attachStaticScalar_(const ScalarBuffer& buf, const std::string& name, bool isCellData)
+    {
+        addStaticField_(name, isCellData, /*numComponents=*/1,
+                        [&buf](const std::vector<unsigned>& dofs, unsigned, float* values)
+                        {
+                            for (size_t i = 0; i < dofs.size(); ++i)
+                                values[i] = static_cast<float>(buf[dofs[i]]);
+                        });
+    }
+
+    void attachStaticVector_(const VectorBuffer& buf, const std::string& name, bool isCellData)
+    {
+        // like Dune::VTKWriter, write two-dimensional vectors using three components
+        unsigned numComponents = buf.empty() ? 1 : static_cast<unsigned>(buf[0].size());
+        if (numComponents == 2)
+            numComponents = 3;
+
+        addStaticField_(name, isCellData, numComponents,
+                        [&buf](const std::vector<unsigned>& dofs, unsigned numComps, float* values)
+                        {
+                            for (size_t i = 0; i < dofs.size(); ++i) {
+                                const auto& v = buf[dofs[i]];
+                                for (unsigned compIdx = 0; compIdx < numComps; ++compIdx)
+                                    values[i*numComps + compIdx] =
+                                        (compIdx < v.size()) ? static_cast<float>(v[compIdx]) : 0.0f;
+                            }
+                        });
+    }
+
+    void attachStaticTensor_(const TensorBuffer& buf, const std::string& name, bool isCellData)
+    {
+        // like for Dune::VTKWriter, each column of the tensor is written as a vector
+        for (unsigned colIdx = 0; colIdx < buf[0].N(); ++colIdx) {
+            std::ostringstream oss;
+            oss << name <<  "[" << colIdx << "]";
+
+            unsigned numComponents = static_cast<unsigned>(buf[0].M());
+            addStaticField_(oss.str(), isCellData, numComponents,
+                            [&buf, colIdx](const std::vector<unsigned>& dofs, unsigned numComps, float* values)
+                            {
+                                for (size_t i = 0; i < dofs.size(); ++i) {
+                                    const auto& t = buf[dofs[i]];
+                                    for (unsigned compIdx = 0; compIdx < numComps; ++compIdx)
+                                        values[i*numComps + compIdx] = static_cast<float>(t[compIdx][colIdx]);
+                                }
+                            });
+        }
+    }
+
     // make sure the field is well defined if running under valgrind
     // and make sure that all values can be displayed by paraview
     void sanitizeScalarBuffer_(ScalarBuffer& b OPM_UNUSED)
@@ -552,6 +960,12 @@ private:
     int commRank_; // rank of the current process in the communicator
 
     VtkWriter *curWriter_;
+    std::unique_ptr<StaticGridWriter> staticGridWriter_;
+    std::shared_ptr<StaticGridFile> curStaticFile_;
+    std::unique_ptr<XdmfWriter> xdmfWriter_;
+    std::shared_ptr<XdmfFile> curXdmfFile_;
+    ElementFilter elementFilter_;
+    bool geometryOutdated_;
     double curTime_;
     std::string curOutFileName_;
     int curWriterNum_;
@@ -559,6 +973,21 @@ private:
     std::list<ScalarBuffer *> managedScalarBuffers_;
     std::list<VectorBuffer *> managedVectorBuffers_;
 
+    // the data sets which have been written but cannot yet be added to the multi-file
+    // because a previous one is not finished
+    std::map<int, std::string> finishedDataSets_;
+    int nextDataSetIdx_;
+    int nextWrittenDataSetIdx_;
+    std::mutex multiFileMutex_;
+
+    // the number of fields which are still accessing their buffers and the number of
+    // time steps which have been dispatched but not yet written
+    size_t numUnfilledFields_;
+    unsigned numPendingOutputs_;
+    unsigned maxPendingOutputs_;
+    std::mutex outputMutex_;
+    std::condition_variable outputCondition_;
+
     TaskletRunner taskletRunner_;
 };
 } // namespace Opm
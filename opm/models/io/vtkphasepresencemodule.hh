@@ -130,6 +130,15 @@ public:
             this->commitScalarBuffer_(baseWriter, "phase presence", phasePresence_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return phasePresenceOutput_();
+    }
+
 private:
     static bool phasePresenceOutput_()
     {
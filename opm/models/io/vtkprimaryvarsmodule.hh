@@ -165,6 +165,17 @@ public:
             this->commitScalarBuffer_(baseWriter, "DOF index", dofIndex_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return primaryVarsOutput_()
+            || processRankOutput_()
+            || dofIndexOutput_();
+    }
+
 private:
     static bool primaryVarsOutput_()
     {
@@ -0,0 +1,527 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::VtkStaticGridWriter
+ */
+#ifndef EWOMS_VTK_STATIC_GRID_WRITER_HH
+#define EWOMS_VTK_STATIC_GRID_WRITER_HH
+
+#include <dune/grid/common/gridenums.hh>
+#include <dune/grid/io/file/vtk/common.hh>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \brief Writes VTK files for a grid whose geometry is only encoded once.
+ *
+ * In contrast to Dune::VTKWriter, the point coordinates and the connectivity of the
+ * cells are extracted from the grid and encoded only when the grid changes. Each file
+ * then receives a verbatim copy of the encoded geometry, and only the field arrays are
+ * generated for each time step. The fields are filled directly from buffers which use
+ * the DOF numbering, via index tables that are computed together with the geometry.
+ * There is thus no need to evaluate each field through a virtual function for every
+ * corner of every element.
+ *
+ * The files use the XML format for unstructured grids with binary appended data which
+ * is either raw or compressed using zlib. The points and cells of the current process'
+ * interior elements are written. In parallel, each process writes a separate piece,
+ * and the first process also writes the .pvtu file which combines them.
+ *
+ * The fields of a file are collected by a File object. Filling and encoding its fields
+ * are separate steps which can be done concurrently for different fields, so that the
+ * buffers of the fields can be released as soon as everything has been filled.
+ */
+template <class GridView>
+class VtkStaticGridWriter
+{
+    enum { dim = GridView::dimension };
+    enum { dimWorld = GridView::dimensionworld };
+
+    using Element = typename GridView::template Codim<0>::Entity;
+
+    // the size of the blocks of uncompressed data which are compressed individually. this
+    // is the default block size of VTK.
+    static constexpr size_t compressionBlockSize_ = 32768;
+
+public:
+    /*!
+     * \brief The type of the functions which fill the values of a field.
+     *
+     * The first argument is the list of DOF indices of the file's points or cells. The
+     * second one is the number of components of the field. The third argument is the
+     * array to fill, ordered by entity first and then by component.
+     */
+    using FillFunction = std::function<void(const std::vector<unsigned>&, unsigned, float*)>;
+
+    //! Selects the elements which are written, i.e., the region of interest
+    using ElementFilter = std::function<bool(const Element&)>;
+
+    /*!
+     * \brief The fields of a single VTK file.
+     *
+     * A File object refers to the geometry of the VtkStaticGridWriter which created it,
+     * so the geometry must not be updated before the file has been written. The
+     * fillField() and encodeField() methods may be called concurrently for different
+     * fields, but each field must be filled before it is encoded and all fields must be
+     * encoded before the file is written.
+     */
+    class File
+    {
+        friend class VtkStaticGridWriter;
+
+    public:
+        /*!
+         * \brief Add a field to the file.
+         *
+         * The fill function is only called by fillField(), so the data which it accesses
+         * must stay valid until then.
+         */
+        void addField(const std::string& name, bool isCellData, unsigned numComponents, FillFunction fillFn)
+        { fields_.push_back(Field_{name, isCellData, numComponents, std::move(fillFn), {}, {}, nullptr}); }
+
+        /*!
+         * \brief Returns the number of fields which have been added to the file.
+         */
+        size_t numFields() const
+        { return fields_.size(); }
+
+        /*!
+         * \brief Copy the values of a field to an internal array.
+         *
+         * After this method has returned, the data accessed by the field's fill function
+         * is not needed anymore. If an exception is thrown, it is re-thrown by write().
+         */
+        void fillField(size_t fieldIdx)
+        {
+            Field_& field = fields_[fieldIdx];
+            try {
+                const auto& dofs = field.isCellData ? writer_.cellDofs_ : writer_.pointDofs_;
+                field.values.resize(dofs.size()*field.numComponents);
+                field.fill(dofs, field.numComponents, field.values.data());
+            }
+            catch (...) {
+                field.error = std::current_exception();
+            }
+            field.fill = nullptr;
+        }
+
+        /*!
+         * \brief Encode the values of a field which has been filled before.
+         *
+         * If compression is enabled, this is the expensive part. If an exception is
+         * thrown, it is re-thrown by write().
+         */
+        void encodeField(size_t fieldIdx)
+        {
+            Field_& field = fields_[fieldIdx];
+            if (field.error)
+                return;
+
+            try {
+                writer_.appendArray_(field.data, field.values);
+            }
+            catch (...) {
+                field.error = std::current_exception();
+            }
+            field.values = std::vector<float>();
+        }
+
+        /*!
+         * \brief Write the file using the encoded geometry and fields.
+         *
+         * \param outputDir The directory to write the files to.
+         * \param name The base name of the file, without the suffix.
+         * \param commRank The rank of the current process.
+         * \param commSize The number of processes which write a piece of the data set.
+         *
+         * \return The name of the file which must be referenced by the multi-file.
+         */
+        std::string write(const std::string& outputDir, const std::string& name, int commRank, int commSize) const
+        {
+            for (const auto& field : fields_)
+                if (field.error)
+                    std::rethrow_exception(field.error);
+
+            std::ostringstream pointDataXml;
+            std::ostringstream cellDataXml;
+            size_t offset = writer_.geometryData_.size();
+            for (const auto& field : fields_) {
+                auto& xml = field.isCellData ? cellDataXml : pointDataXml;
+                xml << "    " << dataArrayXml_("Float32", field.name, field.numComponents, offset);
+                offset += field.data.size();
+            }
+
+            std::string pieceName = name + ".vtu";
+            if (commSize > 1)
+                pieceName = parallelPrefix_(commSize) + "-p" + fourDigits_(commRank) + "-" + name + ".vtu";
+
+            std::ofstream file(outputDir + "/" + pieceName, std::ios::binary);
+            if (!file)
+                throw std::runtime_error("Could not open VTK file '" + outputDir + "/" + pieceName + "'");
+
+            file << "<?xml version=\"1.0\"?>\n"
+                 << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << byteOrder_()
+                 << "\" header_type=\"UInt64\"" << writer_.compressorXml_() << ">\n"
+                 << " <UnstructuredGrid>\n"
+                 << "  <Piece NumberOfPoints=\"" << writer_.numPoints()
+                 << "\" NumberOfCells=\"" << writer_.numCells() << "\">\n"
+                 << "   <PointData>\n" << pointDataXml.str() << "   </PointData>\n"
+                 << "   <CellData>\n" << cellDataXml.str() << "   </CellData>\n"
+                 << writer_.geometryXml_
+                 << "  </Piece>\n"
+                 << " </UnstructuredGrid>\n"
+                 << " <AppendedData encoding=\"raw\">\n"
+                 << "_";
+            const auto& geometryData = writer_.geometryData_;
+            file.write(geometryData.data(), static_cast<std::streamsize>(geometryData.size()));
+            for (const auto& field : fields_)
+                file.write(field.data.data(), static_cast<std::streamsize>(field.data.size()));
+            file << "\n </AppendedData>\n"
+                 << "</VTKFile>\n";
+            if (!file)
+                throw std::runtime_error("Could not write VTK file '" + outputDir + "/" + pieceName + "'");
+
+            if (commSize == 1)
+                return outputDir + "/" + pieceName;
+
+            std::string parallelName = parallelPrefix_(commSize) + "-" + name + ".pvtu";
+            if (commRank == 0)
+                writeParallelFile_(outputDir + "/" + parallelName, name, commSize);
+
+            return outputDir + "/" + parallelName;
+        }
+
+    private:
+        struct Field_
+        {
+            std::string name;
+            bool isCellData;
+            unsigned numComponents;
+            FillFunction fill;
+            std::vector<float> values;
+            std::vector<char> data;
+            std::exception_ptr error;
+        };
+
+        explicit File(const VtkStaticGridWriter& writer)
+            : writer_(writer)
+        {}
+
+        void writeParallelFile_(const std::string& fileName, const std::string& name, int commSize) const
+        {
+            std::ofstream file(fileName);
+            if (!file)
+                throw std::runtime_error("Could not open VTK file '" + fileName + "'");
+
+            file << "<?xml version=\"1.0\"?>\n"
+                 << "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" byte_order=\"" << byteOrder_()
+                 << "\" header_type=\"UInt64\"" << writer_.compressorXml_() << ">\n"
+                 << " <PUnstructuredGrid GhostLevel=\"0\">\n";
+
+            file << "  <PPointData>\n";
+            for (const auto& field : fields_)
+                if (!field.isCellData)
+                    file << "   " << pDataArrayXml_("Float32", field.name, field.numComponents);
+            file << "  </PPointData>\n";
+
+            file << "  <PCellData>\n";
+            for (const auto& field : fields_)
+                if (field.isCellData)
+                    file << "   " << pDataArrayXml_("Float32", field.name, field.numComponents);
+            file << "  </PCellData>\n";
+
+            file << "  <PPoints>\n"
+                 << "   " << pDataArrayXml_("Float32", "Coordinates", 3)
+                 << "  </PPoints>\n";
+
+            for (int rank = 0; rank < commSize; ++rank)
+                file << "  <Piece Source=\"" << parallelPrefix_(commSize) << "-p" << fourDigits_(rank)
+                     << "-" << name << ".vtu\"/>\n";
+
+            file << " </PUnstructuredGrid>\n"
+                 << "</VTKFile>\n";
+        }
+
+        const VtkStaticGridWriter& writer_;
+        std::vector<Field_> fields_;
+    };
+
+    /*!
+     * \brief Create a writer for a grid view.
+     *
+     * \param gridView The grid view for which the files are written.
+     * \param compress If true, the appended data is compressed using zlib.
+     */
+    explicit VtkStaticGridWriter(const GridView& gridView, bool compress = false)
+        : gridView_(gridView)
+        , compress_(compress)
+    {
+#if !HAVE_ZLIB
+        if (compress_)
+            throw std::runtime_error("Compressed VTK output requires zlib, but opm-models was "
+                                     "compiled without it");
+#endif
+    }
+
+    /*!
+     * \brief Extract the geometry of the grid and encode it.
+     *
+     * This must be called before the first file is written and whenever the grid
+     * changes. The mappers determine how the fields' buffers are indexed. If an element
+     * filter is specified, only the selected elements and their vertices are written.
+     */
+    template <class VertexMapper, class ElementMapper>
+    void updateGeometry(const VertexMapper& vertexMapper,
+                        const ElementMapper& elementMapper,
+                        const ElementFilter& elementFilter = ElementFilter())
+    {
+        pointDofs_.clear();
+        cellDofs_.clear();
+
+        std::vector<float> coordinates;
+        std::vector<int64_t> connectivity;
+        std::vector<int64_t> offsets;
+        std::vector<uint8_t> types;
+
+        // the index of the VTK point for each vertex, or -1 if the vertex is not used
+        std::vector<int64_t> vertexToPoint(static_cast<size_t>(vertexMapper.size()), -1);
+
+        auto elemIt = gridView_.template begin</*codim=*/0, Dune::Interior_Partition>();
+        const auto& elemEndIt = gridView_.template end</*codim=*/0, Dune::Interior_Partition>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const auto& elem = *elemIt;
+            if (elementFilter && !elementFilter(elem))
+                continue;
+
+            const auto& geometry = elem.geometry();
+            const auto& geomType = elem.type();
+
+            int numCorners = geometry.corners();
+            for (int vtkCornerIdx = 0; vtkCornerIdx < numCorners; ++vtkCornerIdx) {
+                int duneCornerIdx = Dune::VTK::renumber(geomType, vtkCornerIdx);
+                unsigned vertexIdx = static_cast<unsigned>(vertexMapper.subIndex(elem, duneCornerIdx, dim));
+
+                int64_t& pointIdx = vertexToPoint[vertexIdx];
+                if (pointIdx < 0) {
+                    pointIdx = static_cast<int64_t>(pointDofs_.size());
+                    pointDofs_.push_back(vertexIdx);
+
+                    // VTK always uses three-dimensional coordinates
+                    const auto& pos = geometry.corner(duneCornerIdx);
+                    for (unsigned k = 0; k < 3; ++k)
+                        coordinates.push_back(k < dimWorld ? static_cast<float>(pos[k]) : 0.0f);
+                }
+                connectivity.push_back(pointIdx);
+            }
+
+            offsets.push_back(static_cast<int64_t>(connectivity.size()));
+            types.push_back(static_cast<uint8_t>(Dune::VTK::geometryType(geomType)));
+            cellDofs_.push_back(static_cast<unsigned>(elementMapper.index(elem)));
+        }
+
+        geometryData_.clear();
+        std::ostringstream pointsXml;
+        pointsXml << "   <Points>\n"
+                  << "    " << dataArrayXml_("Float32", "Coordinates", 3, appendArray_(geometryData_, coordinates))
+                  << "   </Points>\n";
+        std::ostringstream cellsXml;
+        cellsXml << "   <Cells>\n"
+                 << "    " << dataArrayXml_("Int64", "connectivity", 1, appendArray_(geometryData_, connectivity))
+                 << "    " << dataArrayXml_("Int64", "offsets", 1, appendArray_(geometryData_, offsets))
+                 << "    " << dataArrayXml_("UInt8", "types", 1, appendArray_(geometryData_, types))
+                 << "   </Cells>\n";
+        geometryXml_ = pointsXml.str() + cellsXml.str();
+    }
+
+    /*!
+     * \brief Returns true if the geometry of the grid has been encoded.
+     */
+    bool hasGeometry() const
+    { return !geometryXml_.empty(); }
+
+    /*!
+     * \brief Returns true if the appended data is compressed.
+     */
+    bool compress() const
+    { return compress_; }
+
+    /*!
+     * \brief Returns the number of points written to each file by the current process.
+     */
+    size_t numPoints() const
+    { return pointDofs_.size(); }
+
+    /*!
+     * \brief Returns the number of cells written to each file by the current process.
+     */
+    size_t numCells() const
+    { return cellDofs_.size(); }
+
+    /*!
+     * \brief Create an empty file which uses the current geometry.
+     */
+    std::shared_ptr<File> createFile() const
+    {
+        if (!hasGeometry())
+            throw std::logic_error("The geometry of the grid must be encoded before creating a VTK file");
+
+        return std::shared_ptr<File>(new File(*this));
+    }
+
+private:
+    // append the values of an array to the appended data and return its offset
+    template <class T>
+    size_t appendArray_(std::vector<char>& data, const std::vector<T>& values) const
+    {
+        size_t offset = data.size();
+        const char* payload = reinterpret_cast<const char*>(values.data());
+        size_t numBytes = values.size()*sizeof(T);
+        if (compress_)
+            appendCompressed_(data, payload, numBytes);
+        else {
+            uint64_t header = numBytes;
+            appendBytes_(data, &header, sizeof(header));
+            appendBytes_(data, payload, numBytes);
+        }
+        return offset;
+    }
+
+    // append a block-compressed array. The header consists of the number of blocks, the
+    // uncompressed size of the blocks, the uncompressed size of the last block (zero if
+    // it is a full block) and the compressed size of each block.
+    static void appendCompressed_(std::vector<char>& data, const char* payload, size_t numBytes)
+    {
+#if HAVE_ZLIB
+        size_t numBlocks = (numBytes + compressionBlockSize_ - 1)/compressionBlockSize_;
+        std::vector<uint64_t> header(3 + numBlocks);
+        header[0] = numBlocks;
+        header[1] = compressionBlockSize_;
+        header[2] = numBytes % compressionBlockSize_;
+
+        size_t headerPos = data.size();
+        data.resize(headerPos + header.size()*sizeof(uint64_t));
+        for (size_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx) {
+            size_t blockBegin = blockIdx*compressionBlockSize_;
+            size_t blockSize = std::min(compressionBlockSize_, numBytes - blockBegin);
+
+            uLongf compressedSize = compressBound(static_cast<uLong>(blockSize));
+            size_t blockPos = data.size();
+            data.resize(blockPos + compressedSize);
+            int ret = compress2(reinterpret_cast<Bytef*>(data.data() + blockPos),
+                                &compressedSize,
+                                reinterpret_cast<const Bytef*>(payload + blockBegin),
+                                static_cast<uLong>(blockSize),
+                                Z_BEST_SPEED);
+            if (ret != Z_OK)
+                throw std::runtime_error("Compression of VTK data failed");
+
+            data.resize(blockPos + compressedSize);
+            header[3 + blockIdx] = compressedSize;
+        }
+        std::memcpy(data.data() + headerPos, header.data(), header.size()*sizeof(uint64_t));
+#else
+        (void) data;
+        (void) payload;
+        (void) numBytes;
+        throw std::logic_error("Compressed VTK output requires zlib");
+#endif
+    }
+
+    static void appendBytes_(std::vector<char>& data, const void* bytes, size_t numBytes)
+    {
+        const char* begin = static_cast<const char*>(bytes);
+        data.insert(data.end(), begin, begin + numBytes);
+    }
+
+    const char* compressorXml_() const
+    { return compress_ ? " compressor=\"vtkZLibDataCompressor\"" : ""; }
+
+    static std::string dataArrayXml_(const std::string& type, const std::string& name,
+                                     unsigned numComponents, size_t offset)
+    {
+        std::ostringstream oss;
+        oss << "<DataArray type=\"" << type << "\" Name=\"" << name
+            << "\" NumberOfComponents=\"" << numComponents
+            << "\" format=\"appended\" offset=\"" << offset << "\"/>\n";
+        return oss.str();
+    }
+
+    static std::string pDataArrayXml_(const std::string& type, const std::string& name,
+                                      unsigned numComponents)
+    {
+        std::ostringstream oss;
+        oss << "<PDataArray type=\"" << type << "\" Name=\"" << name
+            << "\" NumberOfComponents=\"" << numComponents << "\"/>\n";
+        return oss.str();
+    }
+
+    static std::string parallelPrefix_(int commSize)
+    { return "s" + fourDigits_(commSize); }
+
+    static std::string fourDigits_(int n)
+    {
+        std::ostringstream oss;
+        oss << std::setw(4) << std::setfill('0') << n;
+        return oss.str();
+    }
+
+    static const char* byteOrder_()
+    {
+        const uint16_t one = 1;
+        return (*reinterpret_cast<const uint8_t*>(&one) == 1) ? "LittleEndian" : "BigEndian";
+    }
+
+    const GridView gridView_;
+    bool compress_;
+
+    // the DOF indices of the points and of the cells in the order of the file
+    std::vector<unsigned> pointDofs_;
+    std::vector<unsigned> cellDofs_;
+
+    // the encoded geometry: the XML elements and the appended data which they refer to
+    std::string geometryXml_;
+    std::vector<char> geometryData_;
+};
+
+} // namespace Opm
+
+#endif
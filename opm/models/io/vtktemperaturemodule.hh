@@ -136,6 +136,15 @@ public:
             this->commitScalarBuffer_(baseWriter, "temperature", temperature_);
     }
 
+    /*!
+     * \brief Returns true iff processElement() needs to be called for the module to do
+     *        its job, i.e., if it writes any field.
+     */
+    virtual bool needElementContext() const final
+    {
+        return temperatureOutput_();
+    }
+
 private:
     static bool temperatureOutput_()
     {
@@ -0,0 +1,638 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::XdmfWriter
+ */
+#ifndef EWOMS_XDMF_WRITER_HH
+#define EWOMS_XDMF_WRITER_HH
+
+#include <opm/material/common/Unused.hpp>
+
+#include <dune/grid/common/gridenums.hh>
+#include <dune/grid/io/file/vtk/common.hh>
+
+#if HAVE_MPI
+#include <dune/common/parallel/mpicollectivecommunication.hh>
+
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \brief Writes all time steps of all processes to a single binary container file.
+ *
+ * The values of the fields are stored as raw binary arrays in a container file which
+ * is shared by all processes and which is written at disjoint offsets using MPI-IO
+ * (or a plain file stream if opm-models is compiled without MPI). Thus, the
+ * number of files does not depend on the number of time steps or the number of
+ * processes. The container is described by an XDMF index, which can be loaded by
+ * ParaView and VisIt. The index itself is not written by this class: For each time
+ * step, indexEntry() returns the XML element which must be added to the temporal
+ * collection of the index file.
+ *
+ * Like for Opm::VtkStaticGridWriter, the geometry of the grid is extracted only when
+ * the grid changes and it is stored in the container only once. The fields of a time
+ * step are collected by a File object whose fields can be filled and written
+ * concurrently. No communication is required to write a time step, because the
+ * offsets of all arrays can be computed from the sizes of all processes' pieces of
+ * the grid, which are exchanged when the geometry is updated.
+ *
+ * The container is opened when the geometry is written for the first time. Unless a
+ * previous run is continued using restart(), its contents are discarded.
+ */
+template <class GridView>
+class XdmfWriter
+{
+    enum { dim = GridView::dimension };
+    enum { dimWorld = GridView::dimensionworld };
+
+    using Element = typename GridView::template Codim<0>::Entity;
+
+    // the sizes of the pieces of the grid of all processes and the offsets of their
+    // geometry in the container
+    struct Geometry_
+    {
+        std::vector<uint64_t> numPoints;
+        std::vector<uint64_t> numCells;
+        std::vector<uint64_t> topologySize;
+        std::vector<uint64_t> pointsOffset;
+        std::vector<uint64_t> topologyOffset;
+    };
+
+public:
+    /*!
+     * \brief The type of the functions which fill the values of a field.
+     *
+     * The first argument is the list of DOF indices of the process' points or cells.
+     * The second one is the number of components of the field. The third argument is
+     * the array to fill, ordered by entity first and then by component.
+     */
+    using FillFunction = std::function<void(const std::vector<unsigned>&, unsigned, float*)>;
+
+    //! Selects the elements which are written, i.e., the region of interest
+    using ElementFilter = std::function<bool(const Element&)>;
+
+    /*!
+     * \brief The fields of a single time step.
+     *
+     * The fillField() and encodeField() methods may be called concurrently for
+     * different fields, but each field must be filled before it is encoded. The space
+     * for the fields must be reserved using XdmfWriter::reserveSpace() before any of
+     * them is encoded.
+     */
+    class File
+    {
+        friend class XdmfWriter;
+
+    public:
+        /*!
+         * \brief Add a field to the time step.
+         *
+         * All processes must add the same fields in the same order. The fill function
+         * is only called by fillField(), so the data which it accesses must stay valid
+         * until then.
+         */
+        void addField(const std::string& name, bool isCellData, unsigned numComponents, FillFunction fillFn)
+        { fields_.push_back(Field_{name, isCellData, numComponents, std::move(fillFn), {}, nullptr}); }
+
+        /*!
+         * \brief Returns the number of fields which have been added to the time step.
+         */
+        size_t numFields() const
+        { return fields_.size(); }
+
+        /*!
+         * \brief Copy the values of a field to an internal array.
+         *
+         * After this method has returned, the data accessed by the field's fill function
+         * is not needed anymore. If an exception is thrown, it is re-thrown by
+         * indexEntry().
+         */
+        void fillField(size_t fieldIdx)
+        {
+            Field_& field = fields_[fieldIdx];
+            try {
+                const auto& dofs = field.isCellData ? writer_.cellDofs_ : writer_.pointDofs_;
+                field.values.resize(dofs.size()*field.numComponents);
+                field.fill(dofs, field.numComponents, field.values.data());
+            }
+            catch (...) {
+                field.error = std::current_exception();
+            }
+            field.fill = nullptr;
+        }
+
+        /*!
+         * \brief Write the values of a field which has been filled before to the
+         *        container.
+         *
+         * If an exception is thrown, it is re-thrown by indexEntry().
+         */
+        void encodeField(size_t fieldIdx)
+        {
+            Field_& field = fields_[fieldIdx];
+            if (field.error)
+                return;
+
+            try {
+                writer_.writeArray_(fieldOffset_(fieldIdx, writer_.commRank_), field.values);
+            }
+            catch (...) {
+                field.error = std::current_exception();
+            }
+            field.values = std::vector<float>();
+        }
+
+        /*!
+         * \brief Returns the XML element which describes the time step in the XDMF
+         *        index.
+         *
+         * The element refers to the pieces of all processes. It must only be called
+         * after all fields have been encoded.
+         */
+        std::string indexEntry(double time) const
+        {
+            for (const auto& field : fields_)
+                if (field.error)
+                    std::rethrow_exception(field.error);
+
+            const std::string& container = writer_.containerName_;
+            const char* endian = byteOrder_();
+            const Geometry_& geometry = *geometry_;
+
+            std::ostringstream oss;
+            oss.precision(16);
+            oss << "   <Grid Name=\"step\" GridType=\"Collection\" CollectionType=\"Spatial\">\n"
+                << "    <Time Value=\"" << time << "\"/>\n";
+            uint64_t fieldOffset = offset_;
+            for (size_t rank = 0; rank < geometry.numPoints.size(); ++rank) {
+                // processes which do not write any part of the region of interest do
+                // not store anything in the container
+                if (geometry.numCells[rank] == 0)
+                    continue;
+
+                int r = static_cast<int>(rank);
+                oss << "    <Grid Name=\"p" << rank << "\" GridType=\"Uniform\">\n"
+                    << "     <Topology TopologyType=\"Mixed\" NumberOfElements=\"" << geometry.numCells[rank] << "\">\n"
+                    << "      " << dataItemXml_(container, endian, "Int", 8, geometry.topologySize[rank], 1,
+                                               geometry.topologyOffset[rank])
+                    << "     </Topology>\n"
+                    << "     <Geometry GeometryType=\"XYZ\">\n"
+                    << "      " << dataItemXml_(container, endian, "Float", 4, geometry.numPoints[rank], 3,
+                                               geometry.pointsOffset[rank])
+                    << "     </Geometry>\n";
+                for (const auto& field : fields_) {
+                    const char* type = "Matrix";
+                    if (field.numComponents == 1)
+                        type = "Scalar";
+                    else if (field.numComponents == 3)
+                        type = "Vector";
+
+                    oss << "     <Attribute Name=\"" << field.name << "\" AttributeType=\"" << type
+                        << "\" Center=\"" << (field.isCellData ? "Cell" : "Node") << "\">\n"
+                        << "      " << dataItemXml_(container, endian, "Float", 4,
+                                                   numEntities_(field, r), field.numComponents,
+                                                   fieldOffset)
+                        << "     </Attribute>\n";
+                    fieldOffset += numEntities_(field, r)*field.numComponents*sizeof(float);
+                }
+                oss << "    </Grid>\n";
+            }
+            oss << "   </Grid>\n";
+            return oss.str();
+        }
+
+    private:
+        struct Field_
+        {
+            std::string name;
+            bool isCellData;
+            unsigned numComponents;
+            FillFunction fill;
+            std::vector<float> values;
+            std::exception_ptr error;
+        };
+
+        File(XdmfWriter& writer, std::shared_ptr<const Geometry_> geometry)
+            : writer_(writer)
+            , geometry_(geometry)
+            , offset_(0)
+        {}
+
+        uint64_t numEntities_(const Field_& field, int rank) const
+        {
+            const auto& numEntities = field.isCellData ? geometry_->numCells : geometry_->numPoints;
+            return numEntities[static_cast<size_t>(rank)];
+        }
+
+        // the number of bytes written by a process
+        uint64_t pieceSize_(int rank) const
+        {
+            uint64_t result = 0;
+            for (const auto& field : fields_)
+                result += numEntities_(field, rank)*field.numComponents*sizeof(float);
+            return result;
+        }
+
+        // the pieces of the processes are stored one after the other, each containing
+        // all fields of the process
+        uint64_t fieldOffset_(size_t fieldIdx, int rank) const
+        {
+            uint64_t result = offset_;
+            for (int r = 0; r < rank; ++r)
+                result += pieceSize_(r);
+            for (size_t i = 0; i < fieldIdx; ++i)
+                result += numEntities_(fields_[i], rank)*fields_[i].numComponents*sizeof(float);
+            return result;
+        }
+
+        uint64_t size_() const
+        {
+            uint64_t result = 0;
+            for (size_t rank = 0; rank < geometry_->numPoints.size(); ++rank)
+                result += pieceSize_(static_cast<int>(rank));
+            return result;
+        }
+
+        XdmfWriter& writer_;
+        std::shared_ptr<const Geometry_> geometry_;
+        uint64_t offset_;
+        std::vector<Field_> fields_;
+    };
+
+    /*!
+     * \brief Create a writer.
+     *
+     * \param gridView The grid view for which the output is written.
+     * \param outputDir The directory in which the container is created.
+     * \param name The base name of the container file, without the suffix.
+     */
+    XdmfWriter(const GridView& gridView, const std::string& outputDir, const std::string& name)
+        : gridView_(gridView)
+        , containerName_(name + ".bin")
+        , fileName_(outputDir + "/" + containerName_)
+        , commRank_(gridView.comm().rank())
+        , dataEnd_(0)
+    {}
+
+    ~XdmfWriter()
+    {
+#if HAVE_MPI
+        if (container_ != MPI_FILE_NULL)
+            MPI_File_close(&container_);
+#endif
+    }
+
+    /*!
+     * \brief Returns true if the fields of a time step may be written by other threads
+     *        than the one which created the writer.
+     *
+     * With MPI, this requires that the MPI library may be called by multiple threads
+     * concurrently: the writer serializes its own calls, but the simulator thread
+     * continues to communicate while the fields are written.
+     */
+    static bool supportsWriterThreads()
+    {
+#if HAVE_MPI
+        int provided;
+        MPI_Query_thread(&provided);
+        return provided == MPI_THREAD_MULTIPLE;
+#else
+        return true;
+#endif
+    }
+
+    /*!
+     * \brief Continue the container of a previous run.
+     *
+     * The data which was written after the given offset is discarded. This must be
+     * called on all processes before the geometry is written for the first time.
+     *
+     * \param dataEnd The value of dataEnd() at the time the previous run was saved.
+     */
+    void restart(uint64_t dataEnd)
+    {
+        if (containerIsOpen_())
+            throw std::logic_error("The output container can only be continued before anything "
+                                   "has been written to it");
+        dataEnd_ = dataEnd;
+    }
+
+    /*!
+     * \brief Returns the offset behind the data of the geometry and of all time steps
+     *        for which space has been reserved.
+     */
+    uint64_t dataEnd() const
+    { return containerEnd_(); }
+
+    /*!
+     * \brief Extract the geometry of the grid and write it to the container.
+     *
+     * This must be called before the first time step is written and whenever the grid
+     * changes. It is a collective operation, and all previously reserved time steps
+     * must have been written. The mappers determine how the fields' buffers are
+     * indexed. If an element filter is specified, only the selected elements and their
+     * vertices are written.
+     */
+    template <class VertexMapper, class ElementMapper>
+    void updateGeometry(const VertexMapper& vertexMapper,
+                        const ElementMapper& elementMapper,
+                        const ElementFilter& elementFilter = ElementFilter())
+    {
+        if (!containerIsOpen_())
+            openContainer_();
+
+        pointDofs_.clear();
+        cellDofs_.clear();
+
+        std::vector<float> coordinates;
+        std::vector<int64_t> topology;
+
+        // the index of the point for each vertex, or -1 if the vertex is not used
+        std::vector<int64_t> vertexToPoint(static_cast<size_t>(vertexMapper.size()), -1);
+
+        auto elemIt = gridView_.template begin</*codim=*/0, Dune::Interior_Partition>();
+        const auto& elemEndIt = gridView_.template end</*codim=*/0, Dune::Interior_Partition>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            const auto& elem = *elemIt;
+            if (elementFilter && !elementFilter(elem))
+                continue;
+
+            const auto& geometry = elem.geometry();
+            const auto& geomType = elem.type();
+
+            // the cells of a mixed topology start with their type. Polylines also
+            // need the number of their vertices.
+            int numCorners = geometry.corners();
+            int cellType = xdmfCellType_(Dune::VTK::geometryType(geomType));
+            topology.push_back(cellType);
+            if (cellType == 2)
+                topology.push_back(numCorners);
+
+            // XDMF uses the same numbering of the corners as VTK
+            for (int vtkCornerIdx = 0; vtkCornerIdx < numCorners; ++vtkCornerIdx) {
+                int duneCornerIdx = Dune::VTK::renumber(geomType, vtkCornerIdx);
+                unsigned vertexIdx = static_cast<unsigned>(vertexMapper.subIndex(elem, duneCornerIdx, dim));
+
+                int64_t& pointIdx = vertexToPoint[vertexIdx];
+                if (pointIdx < 0) {
+                    pointIdx = static_cast<int64_t>(pointDofs_.size());
+                    pointDofs_.push_back(vertexIdx);
+
+                    const auto& pos = geometry.corner(duneCornerIdx);
+                    for (unsigned k = 0; k < 3; ++k)
+                        coordinates.push_back(k < dimWorld ? static_cast<float>(pos[k]) : 0.0f);
+                }
+                topology.push_back(pointIdx);
+            }
+
+            cellDofs_.push_back(static_cast<unsigned>(elementMapper.index(elem)));
+        }
+
+        // exchange the sizes of the pieces of all processes
+        const auto& comm = gridView_.comm();
+        uint64_t localSizes[3] = { static_cast<uint64_t>(pointDofs_.size()),
+                                   static_cast<uint64_t>(cellDofs_.size()),
+                                   static_cast<uint64_t>(topology.size()) };
+        std::vector<uint64_t> sizes(3*static_cast<size_t>(comm.size()));
+        comm.allgather(localSizes, 3, sizes.data());
+
+        auto geometry = std::make_shared<Geometry_>();
+        uint64_t offset = containerEnd_();
+        for (int rank = 0; rank < comm.size(); ++rank) {
+            size_t r = static_cast<size_t>(rank);
+            geometry->numPoints.push_back(sizes[3*r + 0]);
+            geometry->numCells.push_back(sizes[3*r + 1]);
+            geometry->topologySize.push_back(sizes[3*r + 2]);
+
+            geometry->pointsOffset.push_back(offset);
+            offset += geometry->numPoints[r]*3*sizeof(float);
+            geometry->topologyOffset.push_back(offset);
+            offset += geometry->topologySize[r]*sizeof(int64_t);
+        }
+
+        size_t r = static_cast<size_t>(commRank_);
+        writeArray_(geometry->pointsOffset[r], coordinates);
+        writeArray_(geometry->topologyOffset[r], topology);
+
+        geometry_ = geometry;
+        dataEnd_ = offset;
+        lastFile_.reset();
+    }
+
+    /*!
+     * \brief Returns true if the geometry of the grid has been written.
+     */
+    bool hasGeometry() const
+    { return geometry_ != nullptr; }
+
+    /*!
+     * \brief Returns the name of the container file relative to the output directory.
+     */
+    const std::string& containerName() const
+    { return containerName_; }
+
+    /*!
+     * \brief Create an empty time step which uses the current geometry.
+     */
+    std::shared_ptr<File> createFile()
+    {
+        if (!hasGeometry())
+            throw std::logic_error("The geometry of the grid must be written before creating a time step");
+
+        return std::shared_ptr<File>(new File(*this, geometry_));
+    }
+
+    /*!
+     * \brief Reserve the space for the fields of a time step in the container.
+     *
+     * This must be done after all fields have been added and in the same order on all
+     * processes. Time steps which are not written do not need to reserve any space.
+     */
+    void reserveSpace(const std::shared_ptr<File>& file)
+    {
+        file->offset_ = containerEnd_();
+        lastFile_ = file;
+    }
+
+private:
+    uint64_t containerEnd_() const
+    { return lastFile_ ? lastFile_->offset_ + lastFile_->size_() : dataEnd_; }
+
+    bool containerIsOpen_() const
+    {
+#if HAVE_MPI
+        return container_ != MPI_FILE_NULL;
+#else
+        return container_.is_open();
+#endif
+    }
+
+    // open the container and discard everything behind the current end of the data.
+    // this is a collective operation.
+    void openContainer_()
+    {
+#if HAVE_MPI
+        int ret = MPI_File_open(mpiCommunicator_(gridView_.comm()), const_cast<char*>(fileName_.c_str()),
+                                MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &container_);
+        if (ret == MPI_SUCCESS)
+            ret = MPI_File_set_size(container_, static_cast<MPI_Offset>(dataEnd_));
+        if (ret != MPI_SUCCESS)
+            throw std::runtime_error("Could not open the output container '" + fileName_ + "'");
+#else
+        // without MPI, there is only a single process. the data of a previous run
+        // which is behind the end of the data is overwritten by the next time steps.
+        auto mode = std::ios::in | std::ios::out | std::ios::binary;
+        if (dataEnd_ == 0)
+            mode |= std::ios::trunc;
+        container_.open(fileName_, mode);
+        if (!container_ && dataEnd_ > 0)
+            throw std::runtime_error("Could not continue the output container '" + fileName_ + "' "
+                                     "of the previous run. (Does the file still exist?)");
+        if (!container_)
+            throw std::runtime_error("Could not open the output container '" + fileName_ + "'");
+#endif
+    }
+
+#if HAVE_MPI
+    // the container is shared by all processes of the grid
+    static MPI_Comm mpiCommunicator_(const Dune::CollectiveCommunication<MPI_Comm>& comm)
+    { return comm; }
+
+    // grids without MPI communication are not distributed, i.e., each process writes
+    // its own container
+    template <class Communication>
+    static MPI_Comm mpiCommunicator_(const Communication& comm OPM_UNUSED)
+    { return MPI_COMM_SELF; }
+#endif
+
+    template <class T>
+    void writeArray_(uint64_t offset, const std::vector<T>& values)
+    {
+        // the MPI library is not necessarily thread safe, so only a single thread
+        // writes at any time
+        std::lock_guard<std::mutex> lock(containerMutex_);
+        const char* data = reinterpret_cast<const char*>(values.data());
+        uint64_t numBytes = values.size()*sizeof(T);
+#if HAVE_MPI
+        // the count of MPI is an int, so large arrays are written in chunks
+        bool ok = true;
+        for (uint64_t pos = 0; ok && pos < numBytes;) {
+            int chunkSize = static_cast<int>(std::min<uint64_t>(numBytes - pos, INT_MAX));
+            MPI_Status status;
+            ok = MPI_File_write_at(container_, static_cast<MPI_Offset>(offset + pos),
+                                   const_cast<char*>(data + pos), chunkSize, MPI_BYTE,
+                                   &status) == MPI_SUCCESS;
+            pos += static_cast<uint64_t>(chunkSize);
+        }
+        if (!ok)
+            throw std::runtime_error("Could not write to the output container '" + containerName_ + "'");
+#else
+        container_.seekp(static_cast<std::streamoff>(offset));
+        container_.write(data, static_cast<std::streamsize>(numBytes));
+        container_.flush();
+        if (!container_)
+            throw std::runtime_error("Could not write to the output container '" + containerName_ + "'");
+#endif
+    }
+
+    // convert the cell type used by VTK to the one of XDMF
+    static int xdmfCellType_(Dune::VTK::GeometryType vtkType)
+    {
+        switch (vtkType) {
+        case Dune::VTK::line: return 2; // polyline
+        case Dune::VTK::triangle: return 4;
+        case Dune::VTK::quadrilateral: return 5;
+        case Dune::VTK::tetrahedron: return 6;
+        case Dune::VTK::pyramid: return 7;
+        case Dune::VTK::prism: return 8; // wedge
+        case Dune::VTK::hexahedron: return 9;
+        default:
+            throw std::logic_error("Cell type not supported by the XDMF output");
+        }
+    }
+
+    static std::string dataItemXml_(const std::string& container, const char* endian,
+                                    const char* numberType, unsigned precision,
+                                    uint64_t numEntries, unsigned numComponents,
+                                    uint64_t offset)
+    {
+        std::ostringstream oss;
+        oss << "<DataItem Dimensions=\"" << numEntries;
+        if (numComponents > 1)
+            oss << " " << numComponents;
+        oss << "\" NumberType=\"" << numberType << "\" Precision=\"" << precision
+            << "\" Format=\"Binary\" Endian=\"" << endian << "\" Seek=\"" << offset << "\">"
+            << container << "</DataItem>\n";
+        return oss.str();
+    }
+
+    static const char* byteOrder_()
+    {
+        const uint16_t one = 1;
+        return (*reinterpret_cast<const uint8_t*>(&one) == 1) ? "Little" : "Big";
+    }
+
+    const GridView gridView_;
+    std::string containerName_;
+    std::string fileName_;
+    int commRank_;
+
+#if HAVE_MPI
+    MPI_File container_ = MPI_FILE_NULL;
+#else
+    std::fstream container_;
+#endif
+    std::mutex containerMutex_;
+
+    // the end of the container if no time step has been reserved since the last
+    // update of the geometry
+    uint64_t dataEnd_;
+    std::shared_ptr<const File> lastFile_;
+
+    std::shared_ptr<const Geometry_> geometry_;
+
+    // the DOF indices of the points and of the cells of the current process
+    std::vector<unsigned> pointDofs_;
+    std::vector<unsigned> cellDofs_;
+};
+
+} // namespace Opm
+
+#endif
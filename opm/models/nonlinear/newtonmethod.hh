@@ -33,6 +33,7 @@
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/simulators/linalg/linalgproperties.hh>
 
 #include <opm/material/densead/Math.hpp>
@@ -45,8 +46,12 @@
 #include <dune/common/version.hh>
 #include <dune/common/parallel/mpihelper.hh>
 
+#include <algorithm>
+#include <exception>
 #include <iostream>
+#include <mutex>
 #include <sstream>
+#include <vector>
 
 #include <unistd.h>
 
@@ -180,6 +185,7 @@ class NewtonMethod
     using Linearizer = GetPropType<TypeTag, Properties::Linearizer>;
     using LinearSolverBackend = GetPropType<TypeTag, Properties::LinearSolverBackend>;
     using ConvergenceWriter = GetPropType<TypeTag, Properties::NewtonConvergenceWriter>;
+    using ThreadManager = GetPropType<TypeTag, Properties::ThreadManager>;
 
     using Communicator = typename Dune::MPIHelper::MPICommunicator;
     using CollectiveCommunication = Dune::CollectiveCommunication<Communicator>;
@@ -362,23 +368,34 @@ public:
 
                 // do the actual linearization
                 linearizeTimer_.start();
-                asImp_().linearizeDomain_();
-                asImp_().linearizeAuxiliaryEquations_();
+                {
+                    EWOMS_PROFILE_REGION("linearize");
+                    asImp_().linearizeDomain_();
+                    asImp_().linearizeAuxiliaryEquations_();
+                }
                 linearizeTimer_.stop();
 
                 solveTimer_.start();
                 auto& residual = linearizer.residual();
-                const auto& jacobian = linearizer.jacobian();
-                linearSolver_.prepare(jacobian, residual);
-                linearSolver_.setResidual(residual);
-                linearSolver_.getResidual(residual);
+                // the Jacobian is passed as a mutable object, so that the linear solver
+                // may let the linearizer assemble it directly into its own storage
+                auto& jacobian = linearizer.jacobian();
+                {
+                    EWOMS_PROFILE_REGION("linearSolve");
+                    linearSolver_.prepare(jacobian, residual);
+                    linearSolver_.setResidual(residual);
+                    linearSolver_.getResidual(residual);
+                }
                 solveTimer_.stop();
 
                 // The preSolve_() method usually computes the errors, but it can do
                 // something else in addition. TODO: should its costs be counted to
                 // the linearization or to the update?
                 updateTimer_.start();
-                asImp_().preSolve_(currentSolution, residual);
+                {
+                    EWOMS_PROFILE_REGION("update");
+                    asImp_().preSolve_(currentSolution, residual);
+                }
                 updateTimer_.stop();
 
                 if (!asImp_().proceed_()) {
@@ -404,9 +421,13 @@ public:
                 solveTimer_.start();
                 // solve A x = b, where b is the residual, A is its Jacobian and x is the
                 // update of the solution
-                linearSolver_.setMatrix(jacobian);
-                solutionUpdate = 0.0;
-                bool converged = linearSolver_.solve(solutionUpdate);
+                bool converged;
+                {
+                    EWOMS_PROFILE_REGION("linearSolve");
+                    linearSolver_.setMatrix(jacobian);
+                    solutionUpdate = 0.0;
+                    converged = linearSolver_.solve(solutionUpdate);
+                }
                 solveTimer_.stop();
 
                 if (!converged) {
@@ -431,10 +452,13 @@ public:
                 // update the current solution (i.e. uOld) with the delta
                 // (i.e. u). The result is stored in u
                 updateTimer_.start();
-                asImp_().postSolve_(currentSolution,
-                                    residual,
-                                    solutionUpdate);
-                asImp_().update_(nextSolution, currentSolution, solutionUpdate, residual);
+                {
+                    EWOMS_PROFILE_REGION("update");
+                    asImp_().postSolve_(currentSolution,
+                                        residual,
+                                        solutionUpdate);
+                    asImp_().update_(nextSolution, currentSolution, solutionUpdate, residual);
+                }
                 updateTimer_.stop();
 
                 if (asImp_().verbose_() && isatty(fileno(stdout)))
@@ -650,28 +674,17 @@ protected:
     void preSolve_(const SolutionVector& currentSolution  OPM_UNUSED,
                    const GlobalEqVector& currentResidual)
     {
-        const auto& constraintsMap = model().linearizer().constraintsMap();
         lastError_ = error_;
         Scalar newtonMaxError = EWOMS_GET_PARAM(TypeTag, Scalar, NewtonMaxError);
 
         // calculate the error as the maximum weighted tolerance of
         // the solution's residual
-        error_ = 0;
-        for (unsigned dofIdx = 0; dofIdx < currentResidual.size(); ++dofIdx) {
-            // do not consider auxiliary DOFs for the error
-            if (dofIdx >= model().numGridDof() || model().dofTotalVolume(dofIdx) <= 0.0)
-                continue;
-
-            // also do not consider DOFs which are constraint
-            if (enableConstraints_()) {
-                if (constraintsMap.count(dofIdx) > 0)
-                    continue;
-            }
-
-            const auto& r = currentResidual[dofIdx];
+        error_ = maxDofError_(currentResidual, [this](unsigned dofIdx, const EqVector& r) {
+            Scalar dofError = 0.0;
             for (unsigned eqIdx = 0; eqIdx < r.size(); ++eqIdx)
-                error_ = Opm::max(std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx)), error_);
-        }
+                dofError = Opm::max(std::abs(r[eqIdx] * model().eqWeight(dofIdx, eqIdx)), dofError);
+            return dofError;
+        });
 
         // take the other processes into account
         error_ = comm_.max(error_);
@@ -745,7 +758,7 @@ protected:
                  const GlobalEqVector& solutionUpdate,
                  const GlobalEqVector& currentResidual)
     {
-        const auto& constraintsMap = model().linearizer().constraintsMap();
+        const auto& linearizer = model().linearizer();
 
         // first, write out the current solution to make convergence
         // analysis possible
@@ -755,15 +768,24 @@ protected:
         if (!std::isfinite(solutionUpdate.one_norm()))
             throw Opm::NumericalIssue("Non-finite update!");
 
+        // exceptions must not escape the parallel region, so the one thrown last is
+        // stored and rethrown afterwards
+        std::mutex exceptionLock;
+        std::exception_ptr exceptionPtr = nullptr;
+
+        // the primary variables of the grid DOFs are updated independently of each
+        // other, so this is done by all threads
         size_t numGridDof = model().numGridDof();
-        for (unsigned dofIdx = 0; dofIdx < numGridDof; ++dofIdx) {
-            if (enableConstraints_()) {
-                if (constraintsMap.count(dofIdx) > 0) {
-                    const auto& constraints = constraintsMap.at(dofIdx);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (size_t i = 0; i < numGridDof; ++i) {
+            unsigned dofIdx = static_cast<unsigned>(i);
+            try {
+                if (enableConstraints_() && linearizer.isConstraintDof(dofIdx))
                     asImp_().updateConstraintDof_(dofIdx,
                                                   nextSolution[dofIdx],
-                                                  constraints);
-                }
+                                                  linearizer.constraintsMap().at(dofIdx));
                 else
                     asImp_().updatePrimaryVariables_(dofIdx,
                                                      nextSolution[dofIdx],
@@ -771,14 +793,15 @@ protected:
                                                      solutionUpdate[dofIdx],
                                                      currentResidual[dofIdx]);
             }
-            else
-                asImp_().updatePrimaryVariables_(dofIdx,
-                                                 nextSolution[dofIdx],
-                                                 currentSolution[dofIdx],
-                                                 solutionUpdate[dofIdx],
-                                                 currentResidual[dofIdx]);
+            catch (...) {
+                std::lock_guard<std::mutex> take(exceptionLock);
+                exceptionPtr = std::current_exception();
+            }
         }
 
+        if (exceptionPtr)
+            std::rethrow_exception(exceptionPtr);
+
         // update the DOFs of the auxiliary equations
         size_t numDof = model().numTotalDof();
         for (size_t dofIdx = numGridDof; dofIdx < numDof; ++dofIdx) {
@@ -797,6 +820,9 @@ protected:
 
     /*!
      * \brief Update a single primary variables object.
+     *
+     * This method is called concurrently for different degrees of freedom, i.e., it
+     * must not modify any state which is shared amongst the DOFs.
      */
     void updatePrimaryVariables_(unsigned globalDofIdx  OPM_UNUSED,
                                  PrimaryVariables& nextValue,
@@ -919,6 +945,47 @@ protected:
     static bool enableConstraints_()
     { return getPropValue<TypeTag, Properties::EnableConstraints>(); }
 
+    // returns the maximum error of all grid DOFs which are neither constraint nor
+    // exhibit a zero volume. the error of each DOF is computed by a function which gets
+    // the index of the DOF and its residual. the DOFs are distributed amongst the
+    // threads.
+    template <class DofErrorFn>
+    Scalar maxDofError_(const GlobalEqVector& residual, DofErrorFn&& dofErrorFn) const
+    {
+        const auto& linearizer = model().linearizer();
+        size_t numDof = std::min<size_t>(residual.size(), model().numGridDof());
+        std::vector<Scalar> threadError(ThreadManager::maxThreads(), 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            Scalar localError = 0.0;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (size_t i = 0; i < numDof; ++i) {
+                unsigned dofIdx = static_cast<unsigned>(i);
+
+                // do not consider DOFs which are constraint or which do not have a
+                // volume
+                if (model().dofTotalVolume(dofIdx) <= 0.0)
+                    continue;
+                if (enableConstraints_() && linearizer.isConstraintDof(dofIdx))
+                    continue;
+
+                localError = Opm::max(dofErrorFn(dofIdx, residual[dofIdx]), localError);
+            }
+
+            threadError[ThreadManager::threadId()] = localError;
+        }
+
+        Scalar result = 0.0;
+        for (const auto& localError : threadError)
+            result = Opm::max(localError, result);
+        return result;
+    }
+
     Simulator& simulator_;
 
     Opm::Timer prePostProcessTimer_;
@@ -0,0 +1,273 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::ThreadedElementScheduler
+ */
+#ifndef EWOMS_THREADED_ELEMENT_SCHEDULER_HH
+#define EWOMS_THREADED_ELEMENT_SCHEDULER_HH
+
+#include <dune/grid/common/gridenums.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Opm {
+
+/*!
+ * \brief Distributes the elements of a grid view amongst the threads of an OpenMP
+ *        parallel region.
+ *
+ * In contrast to ThreadedEntityIterator, the seeds of all elements are stored in a flat
+ * array which only needs to be rebuilt if the grid changes. The interior elements are
+ * stored before all others, so that loops which ignore the non-interior elements do not
+ * need to look at them at all. The elements are handed out to the threads in chunks
+ * using a Loop object.
+ */
+template <class GridView>
+class ThreadedElementScheduler
+{
+    using Grid = typename GridView::Grid;
+
+public:
+    using Element = typename GridView::template Codim<0>::Entity;
+    using ElementSeed = typename Grid::template Codim<0>::EntitySeed;
+
+    /*!
+     * \brief Hands out chunks of elements to the threads of a single parallel loop.
+     *
+     * The chunks are distributed evenly amongst the threads before the loop starts. A
+     * thread which has processed all of its own chunks steals chunks from the other
+     * threads. All book keeping is done using atomic counters, i.e., no locks are taken.
+     *
+     * ATTENTION: This class must be instantiated in a sequential context!
+     */
+    class Loop
+    {
+        // each thread gets its own cache line for its counter to avoid false sharing
+        struct alignas(64) ThreadRange_
+        {
+            std::atomic<size_t> nextChunk;
+            size_t endChunk;
+        };
+
+    public:
+        Loop(const ThreadedElementScheduler& scheduler,
+             unsigned numThreads,
+             bool interiorOnly = true)
+            : scheduler_(scheduler)
+            , numThreads_(std::max(numThreads, 1u))
+            , threadRanges_(new ThreadRange_[std::max(numThreads, 1u)])
+        {
+            numElements_ = interiorOnly ? scheduler.numInteriorElements() : scheduler.numElements();
+
+            // make sure that there are enough chunks for each thread to allow some
+            // load balancing
+            chunkSize_ = scheduler.chunkSize();
+            size_t minChunks = 4*numThreads_;
+            if (numElements_ < chunkSize_*minChunks)
+                chunkSize_ = std::max<size_t>(1, (numElements_ + minChunks - 1)/minChunks);
+            numChunks_ = (numElements_ + chunkSize_ - 1)/chunkSize_;
+
+            for (unsigned threadId = 0; threadId < numThreads_; ++threadId) {
+                threadRanges_[threadId].nextChunk = (numChunks_*threadId)/numThreads_;
+                threadRanges_[threadId].endChunk = (numChunks_*(threadId + 1))/numThreads_;
+            }
+        }
+
+        Loop(const Loop&) = delete;
+
+        /*!
+         * \brief Retrieve the next chunk of elements for a given thread.
+         *
+         * The chunk is specified by the half-open index range [begin, end) which can be
+         * used with ThreadedElementScheduler::element(). If no work is left, false is
+         * returned.
+         */
+        bool nextChunk(unsigned threadId, size_t& begin, size_t& end)
+        {
+            for (unsigned i = 0; i < numThreads_; ++i) {
+                // start with the thread's own range, then try to steal from the others
+                auto& range = threadRanges_[(threadId + i) % numThreads_];
+                size_t chunkIdx = range.nextChunk.fetch_add(1, std::memory_order_relaxed);
+                if (chunkIdx < range.endChunk) {
+                    begin = chunkIdx*chunkSize_;
+                    end = std::min(begin + chunkSize_, numElements_);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /*!
+         * \brief Call a function for each element which is handed out to a thread.
+         *
+         * The function is called with the element as its only argument.
+         */
+        template <class Fn>
+        void forEach(unsigned threadId, Fn&& fn)
+        {
+            size_t begin, end;
+            while (nextChunk(threadId, begin, end))
+                for (size_t elemIdx = begin; elemIdx < end; ++elemIdx)
+                    fn(scheduler_.element(elemIdx));
+        }
+
+        /*!
+         * \brief Make sure that no further chunks are handed out by this loop.
+         *
+         * This is required to quickly terminate a loop if an exception was thrown.
+         */
+        void setFinished()
+        {
+            for (unsigned threadId = 0; threadId < numThreads_; ++threadId)
+                threadRanges_[threadId].nextChunk = threadRanges_[threadId].endChunk;
+        }
+
+    private:
+        const ThreadedElementScheduler& scheduler_;
+        unsigned numThreads_;
+        size_t numElements_;
+        size_t chunkSize_;
+        size_t numChunks_;
+        std::unique_ptr<ThreadRange_[]> threadRanges_;
+    };
+
+    /*!
+     * \brief Create an empty scheduler.
+     *
+     * \param chunkSize The maximum number of elements which are handed out to a thread
+     *                  at once.
+     */
+    explicit ThreadedElementScheduler(size_t chunkSize = 64)
+        : grid_(nullptr)
+        , numInterior_(0)
+        , chunkSize_(std::max<size_t>(chunkSize, 1))
+        , sequenceNumber_(-1)
+    {}
+
+    /*!
+     * \brief Rebuild the array of element seeds if the grid has changed.
+     *
+     * The array is only rebuilt if the sequence number differs from the one which was
+     * passed to the last call of this method. The elements are stored in the grid's
+     * iteration order.
+     */
+    void update(const GridView& gridView, int sequenceNumber)
+    { update_(gridView, sequenceNumber, [](const Element&) { return 0; }); }
+
+    /*!
+     * \brief Rebuild the array of element seeds if the grid has changed.
+     *
+     * In contrast to the method above, the interior and the non-interior elements are
+     * each sorted by their index of the element mapper. If the mapper reorders the
+     * elements to improve data locality, the threads thus process them in this order.
+     */
+    template <class ElementMapper>
+    void update(const GridView& gridView, int sequenceNumber, const ElementMapper& elementMapper)
+    {
+        update_(gridView, sequenceNumber,
+                [&elementMapper](const Element& elem) { return elementMapper.index(elem); });
+    }
+
+    /*!
+     * \brief Returns the number of elements which are known to the scheduler.
+     */
+    size_t numElements() const
+    { return seeds_.size(); }
+
+    /*!
+     * \brief Returns the number of elements in the interior of the process' partition.
+     *
+     * These correspond to the indices [0, numInteriorElements()).
+     */
+    size_t numInteriorElements() const
+    { return numInterior_; }
+
+    /*!
+     * \brief Returns the maximum number of elements in a chunk.
+     */
+    size_t chunkSize() const
+    { return chunkSize_; }
+
+    /*!
+     * \brief Returns the element for a given index.
+     */
+    Element element(size_t elemIdx) const
+    {
+        assert(elemIdx < seeds_.size());
+        return grid_->entity(seeds_[elemIdx]);
+    }
+
+private:
+    template <class SortKeyFn>
+    void update_(const GridView& gridView, int sequenceNumber, SortKeyFn&& sortKey)
+    {
+        if (grid_ && sequenceNumber == sequenceNumber_)
+            return;
+
+        grid_ = &gridView.grid();
+        sequenceNumber_ = sequenceNumber;
+
+        using SortKey = decltype(sortKey(std::declval<const Element&>()));
+        std::vector<std::pair<SortKey, ElementSeed> > interiorSeeds;
+        std::vector<std::pair<SortKey, ElementSeed> > nonInteriorSeeds;
+        interiorSeeds.reserve(static_cast<size_t>(gridView.size(/*codim=*/0)));
+        auto elemIt = gridView.template begin</*codim=*/0>();
+        const auto& elemEndIt = gridView.template end</*codim=*/0>();
+        for (; elemIt != elemEndIt; ++elemIt) {
+            if (elemIt->partitionType() == Dune::InteriorEntity)
+                interiorSeeds.emplace_back(sortKey(*elemIt), elemIt->seed());
+            else
+                nonInteriorSeeds.emplace_back(sortKey(*elemIt), elemIt->seed());
+        }
+
+        // the sort is stable, i.e., the iteration order is kept for equal keys
+        auto keyLess = [](const auto& a, const auto& b) { return a.first < b.first; };
+        std::stable_sort(interiorSeeds.begin(), interiorSeeds.end(), keyLess);
+        std::stable_sort(nonInteriorSeeds.begin(), nonInteriorSeeds.end(), keyLess);
+
+        seeds_.clear();
+        seeds_.reserve(interiorSeeds.size() + nonInteriorSeeds.size());
+        for (const auto& keyAndSeed : interiorSeeds)
+            seeds_.push_back(keyAndSeed.second);
+        numInterior_ = seeds_.size();
+        for (const auto& keyAndSeed : nonInteriorSeeds)
+            seeds_.push_back(keyAndSeed.second);
+    }
+
+    const Grid* grid_;
+    std::vector<ElementSeed> seeds_;
+    size_t numInterior_;
+    size_t chunkSize_;
+    int sequenceNumber_;
+};
+
+} // namespace Opm
+
+#endif
@@ -43,6 +43,7 @@
 #include <opm/models/common/multiphasebasemodel.hh>
 #include <opm/models/common/diffusionmodule.hh>
 #include <opm/models/common/energymodule.hh>
+#include <opm/models/io/restart.hh>
 #include <opm/models/io/vtkcompositionmodule.hh>
 #include <opm/models/io/vtkenergymodule.hh>
 #include <opm/models/io/vtkdiffusionmodule.hh>
@@ -459,7 +460,8 @@ public:
         if (!outstream.good())
             throw std::runtime_error("Could not serialize DOF "+std::to_string(dofIdx));
 
-        outstream << this->solution(/*timeIdx=*/0)[dofIdx].phasePresence() << " ";
+        short phasePresence = static_cast<short>(this->solution(/*timeIdx=*/0)[dofIdx].phasePresence());
+        Restart::serializeValue(outstream, phasePresence);
     }
 
     /*!
@@ -477,7 +479,7 @@ public:
             throw std::runtime_error("Could not deserialize DOF "+std::to_string(dofIdx));
 
         short tmp;
-        instream >> tmp;
+        Restart::deserializeValue(instream, tmp);
         this->solution(/*timeIdx=*/0)[dofIdx].setPhasePresence(tmp);
         this->solution(/*timeIdx=*/1)[dofIdx].setPhasePresence(tmp);
     }
@@ -105,6 +105,17 @@ struct GridPart { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct GridGlobalRefinements { using type = UndefinedProperty; };
 
+/*!
+ * \brief The order in which the degrees of freedom are numbered.
+ *
+ * Possible values are "none" (use the numbering of the grid), "rcm" (reverse
+ * Cuthill-McKee) and "hilbert" (Hilbert space-filling curve). The same ordering is
+ * used by all mappers of the grid, i.e., for the solution vectors, the Jacobian matrix,
+ * the traversal of the elements and the output.
+ */
+template<class TypeTag, class MyTypeTag>
+struct DofOrdering { using type = UndefinedProperty; };
+
 //! Property provides the name of the file from which the additional runtime
 //! parameters should to be loaded from
 template<class TypeTag, class MyTypeTag>
@@ -144,6 +155,18 @@ struct RestartTime { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct PredeterminedTimeStepsFile { using type = UndefinedProperty; };
 
+//! Specify whether restart files are written by a separate thread
+template<class TypeTag, class MyTypeTag>
+struct EnableAsyncRestartOutput { using type = UndefinedProperty; };
+
+//! The maximum number of restart files which may be written in the background at the same time
+template<class TypeTag, class MyTypeTag>
+struct MaxPendingRestartFiles { using type = UndefinedProperty; };
+
+//! Specify whether the time spent in the profiled regions of the code is recorded
+template<class TypeTag, class MyTypeTag>
+struct EnableProfiling { using type = UndefinedProperty; };
+
 //! domain size
 template<class TypeTag, class MyTypeTag>
 struct DomainSizeX { using type = UndefinedProperty; };
@@ -274,6 +297,18 @@ struct RestartTime<TypeTag, TTag::NumericModel>
 template<class TypeTag>
 struct PredeterminedTimeStepsFile<TypeTag, TTag::NumericModel> { static constexpr auto value = ""; };
 
+//! By default, restart files are written by the simulator thread
+template<class TypeTag>
+struct EnableAsyncRestartOutput<TypeTag, TTag::NumericModel> { static constexpr bool value = false; };
+
+//! By default, at most one restart file is kept in memory while it is written
+template<class TypeTag>
+struct MaxPendingRestartFiles<TypeTag, TTag::NumericModel> { static constexpr unsigned value = 1; };
+
+//! By default, no profiling data is recorded
+template<class TypeTag>
+struct EnableProfiling<TypeTag, TTag::NumericModel> { static constexpr bool value = false; };
+
 
 } // namespace Opm::Properties
 
@@ -44,7 +44,9 @@
 #include <dune/common/classname.hh>
 #include <dune/common/parametertree.hh>
 
+#include <atomic>
 #include <map>
+#include <mutex>
 #include <set>
 #include <list>
 #include <sstream>
@@ -104,7 +106,9 @@
  *
  * \brief Retrieve a runtime parameter.
  *
- * The default value is specified via the property system.
+ * The default value is specified via the property system. The value of the parameter
+ * is only looked up once after the parameters have been changed, i.e., subsequent
+ * calls are cheap enough to be used in performance critical code.
  *
  * Example:
  *
@@ -115,14 +119,16 @@
  * \endcode
  */
 #define EWOMS_GET_PARAM(TypeTag, ParamType, ParamName)                         \
-    (::Opm::Parameters::get<TypeTag, ParamType>(#ParamName, #ParamName, \
-                                                getPropValue<TypeTag, Properties::ParamName>()))
+    (::Opm::Parameters::getCached<TypeTag, ParamType, Properties::ParamName>(#ParamName, \
+                                                                            #ParamName, \
+                                                                            getPropValue<TypeTag, Properties::ParamName>()))
 
 //!\cond SKIP_THIS
 #define EWOMS_GET_PARAM_(TypeTag, ParamType, ParamName)                 \
-    (::Opm::Parameters::get<TypeTag, ParamType>(#ParamName, #ParamName, \
-                                                getPropValue<TypeTag, Properties::ParamName>(), \
-                                                /*errorIfNotRegistered=*/false))
+    (::Opm::Parameters::getCached<TypeTag, ParamType, Properties::ParamName>(#ParamName, \
+                                                                            #ParamName, \
+                                                                            getPropValue<TypeTag, Properties::ParamName>(), \
+                                                                            /*errorIfNotRegistered=*/false))
 
 /*!
  * \ingroup Parameter
@@ -256,12 +262,24 @@ struct ParameterMetaData<TypeTag, TTag::ParameterSystem>
     static bool& registrationOpen()
     { return storage_().registrationOpen; }
 
+    /*!
+     * \brief The generation of the parameter values.
+     *
+     * This is incremented each time the values of the parameters may have changed and
+     * is used to decide whether a cached parameter value is still valid. It must only be
+     * incremented _after_ the parameter tree has been modified, or a concurrent reader
+     * may cache an outdated value for the new generation.
+     */
+    static std::atomic<unsigned>& generation()
+    { return storage_().generation; }
+
     static void clear()
     {
         storage_().tree.reset(new Dune::ParameterTree());
         storage_().finalizers.clear();
         storage_().registrationOpen = true;
         storage_().registry.clear();
+        ++ storage_().generation;
     }
 
 private:
@@ -274,12 +292,14 @@ private:
         {
             tree.reset(new Dune::ParameterTree());
             registrationOpen = true;
+            generation = 1;
         }
 
         std::unique_ptr<Dune::ParameterTree> tree;
         std::map<std::string, ::Opm::Parameters::ParamInfo> registry;
         std::list<std::unique_ptr<::Opm::Parameters::ParamRegFinalizerBase_> > finalizers;
         bool registrationOpen;
+        std::atomic<unsigned> generation;
     };
     static Storage_& storage_() {
         static Storage_ obj;
@@ -555,6 +575,16 @@ inline int noPositionalParameters_(std::set<std::string>& seenParams OPM_UNUSED,
     return 0;
 }
 
+// increments the generation of the parameter values when it goes out of scope, i.e.,
+// after the parameter tree has been modified. this way, concurrent readers never cache
+// the value of a parameter from before the modification for the new generation.
+template <class TypeTag>
+struct ParamGenerationGuard_
+{
+    ~ParamGenerationGuard_()
+    { ++ GetProp<TypeTag, Properties::ParameterMetaData>::generation(); }
+};
+
 /// \endcond
 
 
@@ -685,6 +715,7 @@ std::string parseCommandLineOptions(int argc,
                                     const PositionalArgumentCallback& posArgCallback = noPositionalParameters_)
 {
     Dune::ParameterTree& paramTree = GetProp<TypeTag, Properties::ParameterMetaData>::tree();
+    ParamGenerationGuard_<TypeTag> generationGuard;
 
     // handle the "--help" parameter
     if (!helpPreamble.empty()) {
@@ -786,6 +817,7 @@ template <class TypeTag>
 void parseParameterFile(const std::string& fileName, bool overwrite = true)
 {
     Dune::ParameterTree& paramTree = GetProp<TypeTag, Properties::ParameterMetaData>::tree();
+    ParamGenerationGuard_<TypeTag> generationGuard;
 
     std::set<std::string> seenKeys;
     std::ifstream ifs(fileName);
@@ -972,6 +1004,36 @@ public:
         return retrieve_<ParamType>(propTagName, paramName, defaultValue, errorIfNotRegistered);
     }
     
+    template <class ParamType, template<class, class> class Property>
+    static ParamType getCached(const char *propTagName,
+                               const char *paramName,
+                               const ParamType& defaultValue,
+                               bool errorIfNotRegistered = true)
+    {
+        using Slot = CacheSlot_<ParamType, Property>;
+
+        // fast path: the value has already been retrieved since the parameters were
+        // last changed
+        unsigned generation = ParamsMeta::generation();
+        if (Slot::generation.load(std::memory_order_acquire) == generation)
+            return Slot::value;
+
+        std::lock_guard<std::mutex> lock(Slot::mutex);
+        if (Slot::generation.load(std::memory_order_relaxed) != generation) {
+            ParamType value = retrieve_<ParamType>(propTagName, paramName, defaultValue, errorIfNotRegistered);
+
+            // the parameter tree may still be modified while the registration is open,
+            // so we must not cache anything yet
+            if (ParamsMeta::registrationOpen())
+                return value;
+
+            Slot::value = value;
+            Slot::generation.store(generation, std::memory_order_release);
+        }
+
+        return Slot::value;
+    }
+
     static void clear()
     {
         ParamsMeta::clear();
@@ -1008,6 +1070,17 @@ public:
 
 
 private:
+    // the typed storage for the cached value of a parameter. since the slot is
+    // identified by the property which specifies the parameter's default value,
+    // retrieving the value from the slot does not involve any string operations.
+    template <class ParamType, template<class, class> class Property>
+    struct CacheSlot_
+    {
+        static inline std::atomic<unsigned> generation{0};
+        static inline ParamType value{};
+        static inline std::mutex mutex;
+    };
+
     struct Blubb
     {
         std::string propertyName;
@@ -1105,6 +1178,15 @@ const ParamType get(const char *propTagName, const char *paramName, const ParamT
     return Param<TypeTag>::template get<ParamType>(propTagName, paramName, defaultValue, errorIfNotRegistered);
 }
 
+template <class TypeTag, class ParamType, template<class, class> class Property>
+const ParamType getCached(const char *propTagName, const char *paramName, const ParamType& defaultValue, bool errorIfNotRegistered = true)
+{
+    return Param<TypeTag>::template getCached<ParamType, Property>(propTagName,
+                                                                   paramName,
+                                                                   defaultValue,
+                                                                   errorIfNotRegistered);
+}
+
 template <class TypeTag, class Container>
 void getLists(Container& usedParams, Container& unusedParams)
 {
@@ -1207,6 +1289,7 @@ void endParamRegistration()
                                "to close it once.");
 
     ParamsMeta::registrationOpen() = false;
+    ++ ParamsMeta::generation();
 
     // loop over all parameters and retrieve their values to make sure
     // that there is no syntax error
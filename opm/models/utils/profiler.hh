@@ -0,0 +1,490 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \copydoc Opm::Profiler
+ */
+#ifndef EWOMS_PROFILER_HH
+#define EWOMS_PROFILER_HH
+
+#include <opm/models/parallel/mpiutil.hh>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Opm {
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Collects the time spent in named regions of the code.
+ *
+ * Regions are marked using the EWOMS_PROFILE_REGION() macro and may be nested, i.e.,
+ * the profile is a tree of regions. Each thread accumulates the number of calls and the
+ * wall clock time of each region in its own data structures, so no locks are taken
+ * once a thread has visited a region for the first time. Regions which are entered by
+ * a thread that does not have any open regions -- e.g., by the worker threads of an
+ * OpenMP parallel region -- are attached to the region which was open on the main
+ * thread when it last was in a sequential context.
+ *
+ * If the profiler is disabled, which is the default, marking a region costs a single
+ * load of a flag. The report contains the minimum, maximum and mean time spent in each
+ * region across threads and processes, and the resulting imbalance, i.e., the ratio of
+ * the maximum and the mean.
+ */
+class Profiler
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Accumulator_
+    {
+        uint64_t calls = 0;
+        double seconds = 0.0;
+    };
+
+    struct ThreadData_
+    {
+        bool isMainThread = false;
+        std::vector<Accumulator_> accumulators;
+        // the children of each node which are known to the thread as pairs of region
+        // and node indices
+        std::vector<std::vector<std::pair<unsigned, unsigned> > > children;
+        std::vector<std::pair<unsigned, Clock::time_point> > openRegions;
+    };
+
+    struct Node_
+    {
+        unsigned regionId;
+        unsigned parent;
+    };
+
+public:
+    /*!
+     * \brief Returns the profiler object of the process.
+     */
+    static Profiler& instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    /*!
+     * \brief Returns true iff regions are currently recorded.
+     */
+    static bool isEnabled()
+    { return instance().enabled_.load(std::memory_order_relaxed); }
+
+    /*!
+     * \brief Returns the index of the region with a given name.
+     *
+     * This takes a lock, so the result should be stored in a static variable as
+     * done by EWOMS_PROFILE_REGION().
+     */
+    static unsigned regionId(const std::string& name)
+    {
+        auto& self = instance();
+        std::lock_guard<std::mutex> lock(self.mutex_);
+        auto it = self.regionIds_.find(name);
+        if (it != self.regionIds_.end())
+            return it->second;
+
+        unsigned id = static_cast<unsigned>(self.regionNames_.size());
+        self.regionNames_.push_back(name);
+        self.regionIds_[name] = id;
+        return id;
+    }
+
+    /*!
+     * \brief Discard all recorded data and start recording.
+     *
+     * The calling thread becomes the main thread. This method must be called in a
+     * sequential context.
+     */
+    void start()
+    {
+        for (auto& threadData : threads_) {
+            threadData->isMainThread = false;
+            std::fill(threadData->accumulators.begin(), threadData->accumulators.end(),
+                      Accumulator_());
+        }
+        localThreadData_().isMainThread = true;
+        forkNode_.store(0, std::memory_order_relaxed);
+        enabled_.store(true, std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief Stop recording.
+     */
+    void stop()
+    { enabled_.store(false, std::memory_order_relaxed); }
+
+    /*!
+     * \brief Enter a region on the calling thread.
+     */
+    void enter(unsigned regionId)
+    {
+        auto& td = localThreadData_();
+        unsigned parent;
+        if (!td.openRegions.empty())
+            parent = td.openRegions.back().first;
+        else
+            parent = td.isMainThread ? 0 : forkNode_.load(std::memory_order_relaxed);
+
+        unsigned node = childNode_(td, parent, regionId);
+        if (td.isMainThread && !inParallel_())
+            forkNode_.store(node, std::memory_order_relaxed);
+        td.openRegions.emplace_back(node, Clock::now());
+    }
+
+    /*!
+     * \brief Leave the region which was entered last on the calling thread.
+     */
+    void leave()
+    {
+        auto endTime = Clock::now();
+        auto& td = localThreadData_();
+        const auto& nodeAndStart = td.openRegions.back();
+        auto& accumulator = td.accumulators[nodeAndStart.first];
+        ++ accumulator.calls;
+        accumulator.seconds += std::chrono::duration<double>(endTime - nodeAndStart.second).count();
+        td.openRegions.pop_back();
+
+        if (td.isMainThread && !inParallel_())
+            forkNode_.store(td.openRegions.empty() ? 0 : td.openRegions.back().first,
+                            std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief Write the profile of all processes as JSON to a stream.
+     *
+     * This method is collective, i.e., it must be called by all processes in a
+     * sequential context. Only the stream of the first process is written to.
+     */
+    void writeJson(std::ostream& os) const
+    {
+        auto regions = gatherRegions_();
+        os << "{\n"
+           << "  \"numProcesses\": " << numProcesses_ << ",\n"
+           << "  \"regions\": [";
+        for (size_t i = 0; i < regions.size(); ++i) {
+            const auto& r = regions[i];
+            os << (i > 0 ? "," : "") << "\n"
+               << "    {\"path\": \"" << escapeJson_(r.path) << "\""
+               << ", \"calls\": " << r.calls
+               << ", \"seconds\": " << r.seconds
+               << ", \"threads\": {\"min\": " << r.threadMin
+               << ", \"max\": " << r.threadMax
+               << ", \"mean\": " << r.threadMean()
+               << ", \"imbalance\": " << imbalance_(r.threadMax, r.threadMean()) << "}"
+               << ", \"processes\": {\"min\": " << r.processMin
+               << ", \"max\": " << r.processMax
+               << ", \"mean\": " << r.processMean()
+               << ", \"imbalance\": " << imbalance_(r.processMax, r.processMean()) << "}}";
+        }
+        os << "\n  ]\n}\n";
+    }
+
+    /*!
+     * \brief Write the profile of all processes as comma separated values to a stream.
+     *
+     * This method is collective, i.e., it must be called by all processes in a
+     * sequential context. Only the stream of the first process is written to.
+     */
+    void writeCsv(std::ostream& os) const
+    {
+        auto regions = gatherRegions_();
+        os << "path,calls,seconds,"
+           << "threadMin,threadMax,threadMean,threadImbalance,"
+           << "processMin,processMax,processMean,processImbalance\n";
+        for (const auto& r : regions) {
+            os << "\"" << r.path << "\"," << r.calls << "," << r.seconds << ","
+               << r.threadMin << "," << r.threadMax << "," << r.threadMean() << ","
+               << imbalance_(r.threadMax, r.threadMean()) << ","
+               << r.processMin << "," << r.processMax << "," << r.processMean() << ","
+               << imbalance_(r.processMax, r.processMean()) << "\n";
+        }
+    }
+
+private:
+    // the statistics of a region. the thread statistics consider the time which each
+    // thread has spent in a region, the process statistics the sum over all threads
+    // of a process.
+    struct RegionStats_
+    {
+        std::string path;
+        uint64_t calls = 0;
+        double seconds = 0.0;
+        double threadMin = 0.0;
+        double threadMax = 0.0;
+        unsigned numThreads = 0;
+        double processMin = 0.0;
+        double processMax = 0.0;
+        unsigned numProcesses = 0;
+
+        double threadMean() const
+        { return numThreads > 0 ? seconds/numThreads : 0.0; }
+
+        double processMean() const
+        { return numProcesses > 0 ? seconds/numProcesses : 0.0; }
+    };
+
+    Profiler()
+        : enabled_(false)
+        , forkNode_(0)
+        , nodes_(1, Node_{/*regionId=*/0, /*parent=*/0})
+    {}
+
+    static bool inParallel_()
+    {
+#ifdef _OPENMP
+        return omp_in_parallel();
+#else
+        return false;
+#endif
+    }
+
+    ThreadData_& localThreadData_()
+    {
+        thread_local ThreadData_* td = nullptr;
+        if (!td) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threads_.emplace_back(new ThreadData_);
+            td = threads_.back().get();
+        }
+        return *td;
+    }
+
+    // returns the index of the node which represents a region below a given parent
+    // node, creates the node if it does not exist yet
+    unsigned childNode_(ThreadData_& td, unsigned parent, unsigned regionId)
+    {
+        if (parent < td.children.size())
+            for (const auto& child : td.children[parent])
+                if (child.first == regionId)
+                    return child.second;
+
+        unsigned node;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = std::find_if(nodes_.begin() + 1, nodes_.end(),
+                                   [parent, regionId](const Node_& n)
+                                   { return n.parent == parent && n.regionId == regionId; });
+            node = static_cast<unsigned>(it - nodes_.begin());
+            if (it == nodes_.end())
+                nodes_.push_back(Node_{regionId, parent});
+        }
+
+        if (td.children.size() <= parent)
+            td.children.resize(parent + 1);
+        td.children[parent].emplace_back(regionId, node);
+        if (td.accumulators.size() <= node)
+            td.accumulators.resize(node + 1);
+        return node;
+    }
+
+    std::string path_(unsigned node) const
+    {
+        std::string result = regionNames_[nodes_[node].regionId];
+        for (node = nodes_[node].parent; node != 0; node = nodes_[node].parent)
+            result = regionNames_[nodes_[node].regionId] + "/" + result;
+        return result;
+    }
+
+    // returns the statistics of all regions of all processes in depth-first order
+    std::vector<RegionStats_> gatherRegions_() const
+    {
+        // serialize the statistics of the local process. the seconds are stored with
+        // full precision to avoid rounding errors in the process statistics
+        std::ostringstream oss;
+        oss.precision(17);
+        for (const auto& node : depthFirstNodes_()) {
+            RegionStats_ r;
+            for (const auto& threadData : threads_) {
+                if (node >= threadData->accumulators.size())
+                    continue;
+                const auto& accumulator = threadData->accumulators[node];
+                if (accumulator.calls == 0)
+                    continue;
+                r.threadMin = (r.numThreads == 0) ? accumulator.seconds : std::min(r.threadMin, accumulator.seconds);
+                r.threadMax = std::max(r.threadMax, accumulator.seconds);
+                r.calls += accumulator.calls;
+                r.seconds += accumulator.seconds;
+                ++ r.numThreads;
+            }
+            if (r.numThreads > 0)
+                oss << path_(node) << '\t' << r.calls << '\t' << r.seconds << '\t'
+                    << r.threadMin << '\t' << r.threadMax << '\t' << r.numThreads << '\n';
+        }
+
+        // gather the statistics of all processes. the strings of the processes are
+        // prefixed by a dummy character because empty strings are skipped
+        auto processProfiles = gatherStrings("#" + oss.str());
+        numProcesses_ = static_cast<unsigned>(processProfiles.size());
+
+        std::vector<RegionStats_> result;
+        std::map<std::string, size_t> pathIndices;
+        for (const auto& processProfile : processProfiles) {
+            std::istringstream iss(processProfile.substr(1));
+            std::string line;
+            while (std::getline(iss, line)) {
+                std::istringstream lineStream(line);
+                RegionStats_ p;
+                std::getline(lineStream, p.path, '\t');
+                lineStream >> p.calls >> p.seconds >> p.threadMin >> p.threadMax >> p.numThreads;
+
+                auto it = pathIndices.find(p.path);
+                if (it == pathIndices.end()) {
+                    it = pathIndices.emplace(p.path, result.size()).first;
+                    result.push_back(p);
+                    result.back().processMin = p.seconds;
+                    result.back().processMax = p.seconds;
+                    result.back().numProcesses = 1;
+                    continue;
+                }
+
+                auto& r = result[it->second];
+                r.calls += p.calls;
+                r.seconds += p.seconds;
+                r.threadMin = std::min(r.threadMin, p.threadMin);
+                r.threadMax = std::max(r.threadMax, p.threadMax);
+                r.numThreads += p.numThreads;
+                r.processMin = std::min(r.processMin, p.seconds);
+                r.processMax = std::max(r.processMax, p.seconds);
+                ++ r.numProcesses;
+            }
+        }
+
+        return result;
+    }
+
+    std::vector<unsigned> depthFirstNodes_() const
+    {
+        std::vector<std::vector<unsigned> > children(nodes_.size());
+        for (unsigned node = 1; node < nodes_.size(); ++node)
+            children[nodes_[node].parent].push_back(node);
+
+        std::vector<unsigned> result;
+        std::vector<unsigned> stack(children[0].rbegin(), children[0].rend());
+        while (!stack.empty()) {
+            unsigned node = stack.back();
+            stack.pop_back();
+            result.push_back(node);
+            stack.insert(stack.end(), children[node].rbegin(), children[node].rend());
+        }
+        return result;
+    }
+
+    static double imbalance_(double max, double mean)
+    { return mean > 0.0 ? max/mean : 1.0; }
+
+    static std::string escapeJson_(const std::string& s)
+    {
+        std::string result;
+        for (char c : s) {
+            if (c == '"' || c == '\\')
+                result += '\\';
+            result += c;
+        }
+        return result;
+    }
+
+    std::atomic<bool> enabled_;
+    std::atomic<unsigned> forkNode_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::string> regionNames_;
+    std::map<std::string, unsigned> regionIds_;
+    // node 0 is the root of the tree, which does not correspond to a region
+    std::vector<Node_> nodes_;
+    std::vector<std::unique_ptr<ThreadData_> > threads_;
+    mutable unsigned numProcesses_ = 1;
+};
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Records the time spent in a region of the code until the object is destroyed.
+ */
+class ProfilerRegion
+{
+public:
+    explicit ProfilerRegion(unsigned regionId)
+        : active_(Profiler::isEnabled())
+    {
+        if (active_)
+            Profiler::instance().enter(regionId);
+    }
+
+    ~ProfilerRegion()
+    { leave(); }
+
+    /*!
+     * \brief Stop recording before the object is destroyed.
+     */
+    void leave()
+    {
+        if (active_)
+            Profiler::instance().leave();
+        active_ = false;
+    }
+
+    ProfilerRegion(const ProfilerRegion&) = delete;
+    ProfilerRegion& operator=(const ProfilerRegion&) = delete;
+
+private:
+    bool active_;
+};
+
+} // namespace Opm
+
+#define EWOMS_PROFILE_CONCAT_IMPL_(a, b) a ## b
+#define EWOMS_PROFILE_CONCAT_(a, b) EWOMS_PROFILE_CONCAT_IMPL_(a, b)
+
+/*!
+ * \ingroup Common
+ *
+ * \brief Record the time spent in the remainder of the current scope as a region of
+ *        the profile.
+ */
+#define EWOMS_PROFILE_REGION(name)                                      \
+    static const unsigned EWOMS_PROFILE_CONCAT_(ewomsProfileRegionId_, __LINE__) = \
+        ::Opm::Profiler::regionId(name);                                \
+    ::Opm::ProfilerRegion EWOMS_PROFILE_CONCAT_(ewomsProfileRegion_, __LINE__)( \
+        EWOMS_PROFILE_CONCAT_(ewomsProfileRegionId_, __LINE__))
+
+#endif
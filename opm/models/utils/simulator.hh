@@ -28,10 +28,12 @@
 #ifndef EWOMS_SIMULATOR_HH
 #define EWOMS_SIMULATOR_HH
 
+#include <opm/models/io/asyncrestartwriter.hh>
 #include <opm/models/io/restart.hh>
 #include <opm/models/utils/parametersystem.hh>
 
 #include <opm/models/utils/propertysystem.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/utils/timer.hh>
 #include <opm/models/utils/timerguard.hh>
 #include <opm/models/parallel/mpiutil.hh>
@@ -45,6 +47,7 @@
 #include <iomanip>
 #include <vector>
 #include <string>
+#include <sstream>
 #include <memory>
 
 #define EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(code)                      \
@@ -131,6 +134,9 @@ public:
 
         finished_ = false;
 
+        restartWriter_.reset(new AsyncRestartWriter(EWOMS_GET_PARAM(TypeTag, bool, EnableAsyncRestartOutput),
+                                                    EWOMS_GET_PARAM(TypeTag, unsigned, MaxPendingRestartFiles)));
+
         if (verbose_)
             std::cout << "Allocating the simulation vanguard\n" << std::flush;
 
@@ -245,6 +251,14 @@ public:
         EWOMS_REGISTER_PARAM(TypeTag, std::string, PredeterminedTimeStepsFile,
                              "A file with a list of predetermined time step sizes (one "
                              "time step per line)");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableAsyncRestartOutput,
+                             "Write restart files in a separate thread");
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, MaxPendingRestartFiles,
+                             "The maximum number of restart files which are kept in memory "
+                             "while they are written in the background");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, EnableProfiling,
+                             "Record the time spent in each phase of the simulation and "
+                             "write a report to '$OUTPUT_DIR/$PROBLEM_NAME.profile.{json,csv}'");
 
         Vanguard::registerParameters();
         Model::registerParameters();
@@ -630,7 +644,12 @@ public:
         TimerGuard prePostProcessTimerGuard(prePostProcessTimer_);
         TimerGuard writeTimerGuard(writeTimer_);
 
+        bool enableProfiling = EWOMS_GET_PARAM(TypeTag, bool, EnableProfiling);
+        if (enableProfiling)
+            Profiler::instance().start();
+
         setupTimer_.start();
+        ProfilerRegion initializationProfilerRegion(Profiler::regionId("initialization"));
         Scalar restartTime = EWOMS_GET_PARAM(TypeTag, Scalar, RestartTime);
         if (restartTime > -1e30) {
             // try to restart a previous simulation
@@ -672,6 +691,7 @@ public:
             timeStepIdx_ = oldTimeStepIdx;
         }
         setupTimer_.stop();
+        initializationProfilerRegion.leave();
 
         executionTimer_.start();
         bool episodeBegins = episodeIsOver() || (timeStepIdx_ == 0);
@@ -717,6 +737,7 @@ public:
 
             try {
                 // execute the time integration scheme
+                EWOMS_PROFILE_REGION("timeIntegration");
                 problem_->timeIntegration();
             }
             catch (...) {
@@ -744,8 +765,10 @@ public:
 
             // write the result to disk
             writeTimer_.start();
-            if (problem_->shouldWriteOutput())
+            if (problem_->shouldWriteOutput()) {
+                EWOMS_PROFILE_REGION("output");
                 EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(problem_->writeOutput());
+            }
             writeTimer_.stop();
 
             // do the next time integration
@@ -786,13 +809,26 @@ public:
 
             // write restart file if mandated by the problem
             writeTimer_.start();
-            if (problem_->shouldWriteRestartFile())
+            if (problem_->shouldWriteRestartFile()) {
+                EWOMS_PROFILE_REGION("output");
                 EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(serialize());
+            }
             writeTimer_.stop();
         }
         executionTimer_.stop();
 
+        // make sure that all restart files have been written completely
+        writeTimer_.start();
+        {
+            EWOMS_PROFILE_REGION("output");
+            EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(restartWriter_->finish());
+        }
+        writeTimer_.stop();
+
         EWOMS_CATCH_PARALLEL_EXCEPTIONS_FATAL(problem_->finalize());
+
+        if (enableProfiling)
+            writeProfile_();
     }
 
     /*!
@@ -888,17 +924,21 @@ public:
     void serialize()
     {
         using Restarter = Opm::Restart;
-        Restarter res;
-        res.serializeBegin(*this);
+        std::unique_ptr<Restarter> res(new Restarter);
+        res->serializeBegin(*this);
         if (gridView().comm().rank() == 0)
-            std::cout << "Serialize to file '" << res.fileName() << "'"
+            std::cout << "Serialize to file '" << res->fileName() << "'"
                       << ", next time step size: " << timeStepSize()
                       << "\n" << std::flush;
 
-        this->serialize(res);
-        problem_->serialize(res);
-        model_->serialize(res);
-        res.serializeEnd();
+        this->serialize(*res);
+        problem_->serialize(*res);
+        model_->serialize(*res);
+
+        // the state of the simulation is now stored in memory, so the file can be
+        // written without blocking the simulation
+        res->finishSerialization();
+        restartWriter_->write(std::move(res));
     }
 
     /*!
@@ -944,6 +984,28 @@ public:
     }
 
 private:
+    // write the report of the profiler. this must be called by all processes because
+    // the profiles of the processes are gathered, but only the first one writes files.
+    void writeProfile_()
+    {
+        auto& profiler = Profiler::instance();
+        profiler.stop();
+
+        std::ostringstream json;
+        std::ostringstream csv;
+        profiler.writeJson(json);
+        profiler.writeCsv(csv);
+
+        if (gridView().comm().rank() != 0)
+            return;
+
+        std::string baseName = problem_->outputDir() + "/" + problem_->name() + ".profile";
+        std::ofstream(baseName + ".json") << json.str();
+        std::ofstream(baseName + ".csv") << csv.str();
+        if (verbose_)
+            std::cout << "Profile written to '" << baseName << ".{json,csv}'\n" << std::flush;
+    }
+
     std::unique_ptr<Vanguard> vanguard_;
     std::unique_ptr<Model> model_;
     std::unique_ptr<Problem> problem_;
@@ -960,6 +1022,8 @@ private:
     Opm::Timer updateTimer_;
     Opm::Timer writeTimer_;
 
+    std::unique_ptr<AsyncRestartWriter> restartWriter_;
+
     std::vector<Scalar> forcedTimeSteps_;
     Scalar startTime_;
     Scalar time_;
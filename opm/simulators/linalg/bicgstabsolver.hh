@@ -36,7 +36,11 @@
 
 #include <opm/material/common/Exceptions.hpp>
 
+#include <dune/istl/scalarproducts.hh>
+
+#include <cstddef>
 #include <memory>
+#include <utility>
 
 namespace Opm {
 namespace Linear {
@@ -48,17 +52,28 @@ namespace Linear {
  *
  * See https://en.wikipedia.org/wiki/Biconjugate_gradient_stabilized_method, (article
  * date: December 19, 2016)
+ *
+ * The vector updates are done by all OpenMP threads. If the scalar product provides a
+ * method to compute two dot products which share an operand in a single pass, i.e.,
+ * dot(x, y1, y2, xy1, xy2), it is used to compute (t, t) and (t, s) at once.
  */
-template <class LinearOperator, class Vector, class Preconditioner>
+template <class LinearOperator, class Vector, class Preconditioner,
+          class ScalarProduct = Dune::ScalarProduct<Vector> >
 class BiCGStabSolver
 {
     using ConvergenceCriterion = Opm::Linear::ConvergenceCriterion<Vector>;
     using Scalar = typename LinearOperator::field_type;
 
+    static constexpr size_t blockSize = Vector::block_type::dimension;
+
+    // the minimum number of vector entries for which the vector updates are
+    // distributed amongst the threads
+    static constexpr size_t minParallelEntries = 4096;
+
 public:
     BiCGStabSolver(Preconditioner& preconditioner,
                    ConvergenceCriterion& convergenceCriterion,
-                   Dune::ScalarProduct<Vector>& scalarProduct)
+                   ScalarProduct& scalarProduct)
         : preconditioner_(preconditioner)
         , convergenceCriterion_(convergenceCriterion)
         , scalarProduct_(scalarProduct)
@@ -190,7 +205,7 @@ public:
         Vector& s(r);
         Vector z(x);
         Vector& t(y);
-        unsigned n = x.size();
+        size_t numEntries = x.size()*blockSize;
 
         for (; report_.iterations() < maxIterations_; report_.increment()) {
             // rho_i = (r0hat,r_(i-1))
@@ -204,21 +219,16 @@ public:
             // make rho correspond to the current iteration (i.e., forget rho_(i-1))
             rho = rho_i;
 
-            // this loop conflates the following operations:
-            //
             // p_i = r_(i-1) + beta*(p_(i-1) - omega_(i-1)*v_(i-1))
-            // y = p
-            for (unsigned i = 0; i < n; ++i) {
-                // p_i = r_(i-1) + beta*(p_(i-1) - omega_(i-1)*v_(i-1))
-                auto tmp = v[i];
-                tmp *= omega;
-                tmp -= p[i];
-                tmp *= -beta;
-                p[i] = r[i];
-                p[i] += tmp;
-
-                // y = p; not required because the precontioner overwrites y anyway...
-                // y[i] = p[i];
+            //
+            // y = p is not required because the precontioner overwrites y anyway...
+            {
+                Scalar* pData = data_(p);
+                const Scalar* rData = data_(r);
+                const Scalar* vData = data_(v);
+                forEachEntry_(numEntries, [=](size_t i) {
+                    pData[i] = rData[i] + beta*(pData[i] - omega*vData[i]);
+                });
             }
 
             // y = K^-1 * p_i
@@ -237,16 +247,17 @@ public:
 
             // h = x_(i-1) + alpha*y
             // s = r_(i-1) - alpha*v_i
-            for (unsigned i = 0; i < n; ++i) {
-                auto tmp = y[i];
-                tmp *= alpha;
-                tmp += x[i];
-                h[i] = tmp;
-
-                //s[i] = r[i]; // not necessary because r and s are the same object
-                tmp = v[i];
-                tmp *= alpha;
-                s[i] -= tmp;
+            //
+            // h and x as well as s and r are the same objects
+            {
+                Scalar* hData = data_(h);
+                Scalar* sData = data_(s);
+                const Scalar* yData = data_(y);
+                const Scalar* vData = data_(v);
+                forEachEntry_(numEntries, [=](size_t i) {
+                    hData[i] += alpha*yData[i];
+                    sData[i] -= alpha*vData[i];
+                });
             }
 
             // do convergence check and print terminal output
@@ -284,16 +295,17 @@ public:
             A_->apply(z, t);
 
             // omega_i = (t*s)/(t*t)
-            denom = scalarProduct_.dot(t, t);
+            Scalar ts;
+            dotTwo_(scalarProduct_, t, t, s, denom, ts, /*dummy=*/0);
             if (std::abs(denom) <= breakdownEps)
                 throw Opm::NumericalIssue("Breakdown of the BiCGStab solver (division by zero)");
-            omega = scalarProduct_.dot(t, s)/denom;
+            omega = ts/denom;
             if (std::abs(omega) <= breakdownEps)
                 throw Opm::NumericalIssue("Breakdown of the BiCGStab solver (stagnation detected)");
 
             // x_i = h + omega_i*z
             // x = h; // not necessary because x and h are the same object
-            x.axpy(/*a=*/omega, /*y=*/z);
+            axpy_(x, omega, z);
 
             // do convergence check and print terminal output
             convergenceCriterion_.update(/*curSol=*/x, /*delta=*/z, r);
@@ -322,7 +334,7 @@ public:
 
             // r_i = s - omega*t
             // r = s; // not necessary because r and s are the same object
-            r.axpy(/*a=*/-omega, /*y=*/t);
+            axpy_(r, -omega, t);
         }
 
         report_.setConverged(false);
@@ -338,12 +350,55 @@ public:
     { return report_; }
 
 private:
+    static Scalar* data_(Vector& v)
+    { return (v.size() > 0) ? &v[0][0] : nullptr; }
+
+    static const Scalar* data_(const Vector& v)
+    { return (v.size() > 0) ? &v[0][0] : nullptr; }
+
+    // call a function for the index of each scalar entry of a vector. the entries of
+    // the vectors are stored contiguously, so the loop can be vectorized.
+    template <class Fn>
+    static void forEachEntry_(size_t numEntries, Fn&& fn)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(static) if(numEntries >= minParallelEntries)
+#endif
+        for (size_t i = 0; i < numEntries; ++i)
+            fn(i);
+    }
+
+    // y += a*x
+    static void axpy_(Vector& y, Scalar a, const Vector& x)
+    {
+        Scalar* yData = data_(y);
+        const Scalar* xData = data_(x);
+        forEachEntry_(y.size()*blockSize, [=](size_t i) {
+            yData[i] += a*xData[i];
+        });
+    }
+
+    // compute (x, y1) and (x, y2) in a single pass if the scalar product supports it
+    template <class SP>
+    static auto dotTwo_(SP& sp, const Vector& x, const Vector& y1, const Vector& y2,
+                        Scalar& xy1, Scalar& xy2, int)
+        -> decltype(sp.dot(x, y1, y2, xy1, xy2), void())
+    { sp.dot(x, y1, y2, xy1, xy2); }
+
+    template <class SP>
+    static void dotTwo_(SP& sp, const Vector& x, const Vector& y1, const Vector& y2,
+                        Scalar& xy1, Scalar& xy2, long)
+    {
+        xy1 = sp.dot(x, y1);
+        xy2 = sp.dot(x, y2);
+    }
+
     const LinearOperator* A_;
     const Vector* b_;
 
     Preconditioner& preconditioner_;
     ConvergenceCriterion& convergenceCriterion_;
-    Dune::ScalarProduct<Vector>& scalarProduct_;
+    ScalarProduct& scalarProduct_;
     Opm::Linear::SolverReport report_;
 
     unsigned maxIterations_;
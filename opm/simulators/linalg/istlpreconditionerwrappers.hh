@@ -40,6 +40,10 @@
  * - \c SOR: A successive overrelaxation (SOR) preconditioner
  * - \c ILUn: An ILU(n) preconditioner
  * - \c ILU0: A specialized (and optimized) ILU(0) preconditioner
+ * - \c LevelScheduledILU0: An ILU(0) preconditioner which uses multiple threads. Its
+ *      results are identical to the ones of the sequential ILU(0) preconditioner.
+ * - \c ThreadedBlockILU0: A block Jacobi preconditioner with one block per thread
+ *      which uses ILU(0) for the diagonal blocks
  */
 #ifndef EWOMS_ISTL_PRECONDITIONER_WRAPPERS_HH
 #define EWOMS_ISTL_PRECONDITIONER_WRAPPERS_HH
@@ -47,6 +51,7 @@
 #include <opm/models/utils/propertysystem.hh>
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/simulators/linalg/linalgproperties.hh>
+#include <opm/simulators/linalg/threadedilu0.hh>
 
 #include <dune/istl/preconditioners.hh>
 
@@ -59,17 +64,20 @@ namespace Linear {
     class PreconditionerWrapper##PREC_NAME                                      \
     {                                                                           \
         using Scalar = GetPropType<TypeTag, Properties::Scalar>;                 \
-        using SparseMatrixAdapter = GetPropType<TypeTag, Properties::SparseMatrixAdapter>; \
-        using IstlMatrix = typename SparseMatrixAdapter::IstlMatrix;            \
-        using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>; \
+        using PreconditionerMatrix = GetPropType<TypeTag, Properties::PreconditionerMatrix>; \
+        using PreconditionerVector = GetPropType<TypeTag, Properties::PreconditionerVector>; \
                                                                                 \
     public:                                                                     \
-        using SequentialPreconditioner = ISTL_PREC_TYPE<IstlMatrix,             \
-                                                        OverlappingVector,      \
-                                                        OverlappingVector>;     \
+        using SequentialPreconditioner = ISTL_PREC_TYPE<PreconditionerMatrix,   \
+                                                        PreconditionerVector,   \
+                                                        PreconditionerVector>;  \
         PreconditionerWrapper##PREC_NAME()                                      \
+            : seqPreCond_(nullptr)                                              \
         {}                                                                      \
                                                                                 \
+        ~PreconditionerWrapper##PREC_NAME()                                     \
+        { cleanup(); }                                                          \
+                                                                                \
         static void registerParameters()                                        \
         {                                                                       \
             EWOMS_REGISTER_PARAM(TypeTag, int, PreconditionerOrder,             \
@@ -79,10 +87,11 @@ namespace Linear {
                                  "preconditioner");                             \
         }                                                                       \
                                                                                 \
-        void prepare(IstlMatrix& matrix)                                        \
+        void prepare(PreconditionerMatrix& matrix)                              \
         {                                                                       \
             int order = EWOMS_GET_PARAM(TypeTag, int, PreconditionerOrder);     \
             Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);   \
+            cleanup();                                                          \
             seqPreCond_ = new SequentialPreconditioner(matrix, order,           \
                                                        relaxationFactor);       \
         }                                                                       \
@@ -91,7 +100,10 @@ namespace Linear {
         { return *seqPreCond_; }                                                \
                                                                                 \
         void cleanup()                                                          \
-        { delete seqPreCond_; }                                                 \
+        {                                                                       \
+            delete seqPreCond_;                                                 \
+            seqPreCond_ = nullptr;                                              \
+        }                                                                       \
                                                                                 \
     private:                                                                    \
         SequentialPreconditioner *seqPreCond_;                                  \
@@ -104,16 +116,20 @@ namespace Linear {
     class PreconditionerWrapper##PREC_NAME                                      \
     {                                                                           \
         using Scalar = GetPropType<TypeTag, Properties::Scalar>;                 \
-        using OverlappingMatrix = GetPropType<TypeTag, Properties::OverlappingMatrix>; \
-        using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>; \
+        using PreconditionerMatrix = GetPropType<TypeTag, Properties::PreconditionerMatrix>; \
+        using PreconditionerVector = GetPropType<TypeTag, Properties::PreconditionerVector>; \
                                                                                 \
     public:                                                                     \
-        using SequentialPreconditioner = ISTL_PREC_TYPE<OverlappingMatrix,      \
-                                                        OverlappingVector,      \
-                                                        OverlappingVector>;     \
+        using SequentialPreconditioner = ISTL_PREC_TYPE<PreconditionerMatrix,   \
+                                                        PreconditionerVector,   \
+                                                        PreconditionerVector>;  \
         PreconditionerWrapper##PREC_NAME()                                      \
+            : seqPreCond_(nullptr)                                              \
         {}                                                                      \
                                                                                 \
+        ~PreconditionerWrapper##PREC_NAME()                                     \
+        { cleanup(); }                                                          \
+                                                                                \
         static void registerParameters()                                        \
         {                                                                       \
             EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,     \
@@ -121,10 +137,11 @@ namespace Linear {
                                  "preconditioner");                             \
         }                                                                       \
                                                                                 \
-        void prepare(OverlappingMatrix& matrix)                                 \
+        void prepare(PreconditionerMatrix& matrix)                              \
         {                                                                       \
             Scalar relaxationFactor =                                           \
                 EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);     \
+            cleanup();                                                          \
             seqPreCond_ = new SequentialPreconditioner(matrix,                  \
                                                        relaxationFactor);       \
         }                                                                       \
@@ -133,7 +150,10 @@ namespace Linear {
         { return *seqPreCond_; }                                                \
                                                                                 \
         void cleanup()                                                          \
-        { delete seqPreCond_; }                                                 \
+        {                                                                       \
+            delete seqPreCond_;                                                 \
+            seqPreCond_ = nullptr;                                              \
+        }                                                                       \
                                                                                 \
     private:                                                                    \
         SequentialPreconditioner *seqPreCond_;                                  \
@@ -153,28 +173,33 @@ template <class TypeTag>
 class PreconditionerWrapperILU
 {
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
-    using OverlappingMatrix = GetPropType<TypeTag, Properties::OverlappingMatrix>;
-    using OverlappingVector = GetPropType<TypeTag, Properties::OverlappingVector>;
+    using PreconditionerMatrix = GetPropType<TypeTag, Properties::PreconditionerMatrix>;
+    using PreconditionerVector = GetPropType<TypeTag, Properties::PreconditionerVector>;
 
     static constexpr int order = getPropValue<TypeTag, Properties::PreconditionerOrder>();
 
 public:
-    using SequentialPreconditioner = Dune::SeqILU<OverlappingMatrix, OverlappingVector, OverlappingVector, order>;
+    using SequentialPreconditioner = Dune::SeqILU<PreconditionerMatrix, PreconditionerVector, PreconditionerVector, order>;
 
     PreconditionerWrapperILU()
+        : seqPreCond_(nullptr)
     {}
 
+    ~PreconditionerWrapperILU()
+    { cleanup(); }
+
     static void registerParameters()
     {
         EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerRelaxation,
                              "The relaxation factor of the preconditioner");
     }
 
-    void prepare(OverlappingMatrix& matrix)
+    void prepare(PreconditionerMatrix& matrix)
     {
         Scalar relaxationFactor = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerRelaxation);
 
         // create the sequential preconditioner.
+        cleanup();
         seqPreCond_ = new SequentialPreconditioner(matrix, relaxationFactor);
     }
 
@@ -182,7 +207,10 @@ public:
     { return *seqPreCond_; }
 
     void cleanup()
-    { delete seqPreCond_; }
+    {
+        delete seqPreCond_;
+        seqPreCond_ = nullptr;
+    }
 
 private:
     SequentialPreconditioner *seqPreCond_;
@@ -193,7 +221,12 @@ EWOMS_WRAP_ISTL_SIMPLE_PRECONDITIONER(ILU0, Dune::SeqILU0)
 EWOMS_WRAP_ISTL_PRECONDITIONER(ILUn, Dune::SeqILUn)
 #endif
 
+// preconditioners which use the threads of the process
+EWOMS_WRAP_ISTL_SIMPLE_PRECONDITIONER(LevelScheduledILU0, Opm::Linear::LevelScheduledILU0)
+EWOMS_WRAP_ISTL_SIMPLE_PRECONDITIONER(ThreadedBlockILU0, Opm::Linear::ThreadedBlockILU0)
+
 #undef EWOMS_WRAP_ISTL_PRECONDITIONER
+#undef EWOMS_WRAP_ISTL_SIMPLE_PRECONDITIONER
 }} // namespace Linear, Opm
 
 #endif
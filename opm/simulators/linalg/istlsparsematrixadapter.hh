@@ -31,6 +31,9 @@
 #include <dune/common/fmatrix.hh>
 #include <dune/common/version.hh>
 
+#include <cassert>
+#include <memory>
+
 namespace Opm {
 namespace Linear {
 
@@ -100,6 +103,35 @@ public:
         istlMatrix_->endindices();
     }
 
+    /*!
+     * \brief Allocate matrix structure given a sparsity pattern in compressed row
+     *        storage format.
+     *
+     * The column indices of row i are given by columnIndices[rowOffsets[i]] to
+     * columnIndices[rowOffsets[i + 1] - 1].
+     */
+    template <class Offset, class Index>
+    void reserve(const std::vector<Offset>& rowOffsets, const std::vector<Index>& columnIndices)
+    {
+        // allocate raw matrix
+        istlMatrix_.reset(new IstlMatrix(rows_, columns_, IstlMatrix::random));
+
+        // make sure the pattern is consistent with number of rows
+        assert(rows_ + 1 == rowOffsets.size());
+        assert(static_cast<size_t>(rowOffsets[rows_]) == columnIndices.size());
+
+        for (size_t dofIdx = 0; dofIdx < rows_; ++ dofIdx)
+            istlMatrix_->setrowsize(dofIdx, static_cast<size_t>(rowOffsets[dofIdx + 1] - rowOffsets[dofIdx]));
+
+        istlMatrix_->endrowsizes();
+
+        for (size_t dofIdx = 0; dofIdx < rows_; ++ dofIdx)
+            istlMatrix_->setIndices(dofIdx,
+                                    columnIndices.begin() + static_cast<std::ptrdiff_t>(rowOffsets[dofIdx]),
+                                    columnIndices.begin() + static_cast<std::ptrdiff_t>(rowOffsets[dofIdx + 1]));
+        istlMatrix_->endindices();
+    }
+
     /*!
      * \brief Return constant reference to matrix implementation.
      */
@@ -108,6 +140,26 @@ public:
     const IstlMatrix& istlMatrix() const
     { return *istlMatrix_; }
 
+    /*!
+     * \brief Use the storage of another matrix for the entries of this one.
+     *
+     * This allows to assemble the matrix directly into the data structure which is used
+     * by the linear solver. The other matrix must exhibit the same sparsity pattern as
+     * this one. The entries of the matrix which was used so far are discarded.
+     */
+    void shareStorage(std::shared_ptr<IstlMatrix> storage)
+    {
+        assert(storage);
+        assert(storage->N() == rows_ && storage->nonzeroes() == istlMatrix_->nonzeroes());
+        istlMatrix_ = std::move(storage);
+    }
+
+    /*!
+     * \brief Returns true if the storage of the matrix is shared with another object.
+     */
+    bool sharesStorage() const
+    { return istlMatrix_.use_count() > 1; }
+
     /*!
      * \brief Return number of rows of the matrix.
      */
@@ -189,7 +241,7 @@ protected:
     size_t rows_;
     size_t columns_;
 
-    std::unique_ptr<IstlMatrix> istlMatrix_;
+    std::shared_ptr<IstlMatrix> istlMatrix_;
 };
 
 }} // namespace Linear, Opm
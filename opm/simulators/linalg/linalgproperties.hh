@@ -46,6 +46,25 @@ struct PreconditionerWrapper { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct LinearSolverScalar { using type = UndefinedProperty; };
 
+/*!
+ * \brief The floating point type used to store and to apply the preconditioner
+ *
+ * If this differs from LinearSolverScalar, the iterations of the linear solver are
+ * still done using LinearSolverScalar, but the matrix is converted once per setup of
+ * the preconditioner. Using 'float' halves the memory and bandwidth required by the
+ * preconditioner.
+ */
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerScalar { using type = UndefinedProperty; };
+
+//! The type of the matrix which is used to set up the preconditioner
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerMatrix { using type = UndefinedProperty; };
+
+//! The type of the vectors to which the preconditioner is applied
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerVector { using type = UndefinedProperty; };
+
 /*!
  * \brief The size of the algebraic overlap of the linear solver.
  *
@@ -90,6 +109,19 @@ struct PreconditionerOrder { using type = UndefinedProperty; };
 template<class TypeTag, class MyTypeTag>
 struct PreconditionerRelaxation { using type = UndefinedProperty; };
 
+//! The maximum number of linear solves for which a preconditioner is reused
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerReuseMaxSolves { using type = UndefinedProperty; };
+
+//! The factor by which the number of linear solver iterations may grow before a reused
+//! preconditioner is rebuilt
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerReuseMaxIterationGrowth { using type = UndefinedProperty; };
+
+//! Specify whether the preconditioner is always rebuilt at the beginning of a time step
+template<class TypeTag, class MyTypeTag>
+struct PreconditionerRebuildAtTimeStepStart { using type = UndefinedProperty; };
+
 //! number of iterations between solver restarts for the GMRES solver
 template<class TypeTag, class MyTypeTag>
 struct GMResRestart { using type = UndefinedProperty; };
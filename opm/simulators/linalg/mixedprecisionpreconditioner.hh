@@ -0,0 +1,167 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ * \copydoc Opm::Linear::MixedPrecisionPreconditioner
+ */
+#ifndef EWOMS_MIXED_PRECISION_PRECONDITIONER_HH
+#define EWOMS_MIXED_PRECISION_PRECONDITIONER_HH
+
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solvercategory.hh>
+
+#include <cstddef>
+#include <memory>
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief Applies a preconditioner which operates on vectors of a different (usually
+ *        lower) precision than the ones of the linear solver.
+ *
+ * The vectors passed by the linear solver are converted to the field type of the
+ * preconditioner, the preconditioner is applied and the result is converted back. The
+ * conversion buffers are kept between the applications of the preconditioner.
+ *
+ * \tparam InnerPreconditioner The preconditioner which operates on the vectors of low
+ *                             precision
+ * \tparam X The type of the vectors used by the linear solver
+ */
+template <class InnerPreconditioner, class X>
+class MixedPrecisionPreconditioner : public Dune::Preconditioner<X, X>
+{
+    using InnerVector = typename InnerPreconditioner::domain_type;
+
+public:
+    using domain_type = X;
+    using range_type = X;
+    using field_type = typename X::field_type;
+
+    explicit MixedPrecisionPreconditioner(InnerPreconditioner& innerPreconditioner)
+        : innerPreconditioner_(innerPreconditioner)
+    {}
+
+    Dune::SolverCategory::Category category() const override
+    { return innerPreconditioner_.category(); }
+
+    void pre(domain_type& x, range_type& b) override
+    {
+        copyFrom_(innerX_, x);
+        copyFrom_(innerB_, b);
+        innerPreconditioner_.pre(innerX_, innerB_);
+        copyTo_(x, innerX_);
+        copyTo_(b, innerB_);
+    }
+
+    void apply(domain_type& v, const range_type& d) override
+    {
+        // the current value of v is passed on because some preconditioners use it as
+        // their initial guess
+        copyFrom_(innerX_, v);
+        copyFrom_(innerB_, d);
+        innerPreconditioner_.apply(innerX_, innerB_);
+        copyTo_(v, innerX_);
+    }
+
+    void post(domain_type& x) override
+    {
+        copyFrom_(innerX_, x);
+        innerPreconditioner_.post(innerX_);
+        copyTo_(x, innerX_);
+    }
+
+    /*!
+     * \brief Returns the preconditioner which operates on the vectors of low precision.
+     */
+    InnerPreconditioner& innerPreconditioner()
+    { return innerPreconditioner_; }
+
+private:
+    template <class DestVector, class SrcVector>
+    static void convert_(DestVector& dest, const SrcVector& src)
+    {
+        using DestField = typename DestVector::field_type;
+        for (size_t blockIdx = 0; blockIdx < src.size(); ++blockIdx) {
+            const auto& srcBlock = src[blockIdx];
+            auto& destBlock = dest[blockIdx];
+            for (size_t i = 0; i < srcBlock.size(); ++i)
+                destBlock[i] = static_cast<DestField>(srcBlock[i]);
+        }
+    }
+
+    static void copyFrom_(InnerVector& dest, const X& src)
+    {
+        if (dest.size() != src.size())
+            dest.resize(src.size());
+        convert_(dest, src);
+    }
+
+    static void copyTo_(X& dest, const InnerVector& src)
+    { convert_(dest, src); }
+
+    InnerPreconditioner& innerPreconditioner_;
+    InnerVector innerX_;
+    InnerVector innerB_;
+};
+
+/*!
+ * \brief Copy the entries of a block compressed row storage matrix to a matrix of a
+ *        different field type.
+ *
+ * If the destination matrix is empty or its sparsity pattern does not exhibit the same
+ * number of non-zero blocks as the source matrix, it is recreated using the pattern of
+ * the source matrix. Otherwise, only the values are converted.
+ */
+template <class DestMatrix, class SrcMatrix>
+void convertMatrix(std::unique_ptr<DestMatrix>& dest, const SrcMatrix& src)
+{
+    using DestField = typename DestMatrix::field_type;
+
+    if (!dest || dest->N() != src.N() || dest->nonzeroes() != src.nonzeroes()) {
+        dest.reset(new DestMatrix(src.N(), src.M(), src.nonzeroes(), DestMatrix::row_wise));
+        for (auto row = dest->createbegin(); row != dest->createend(); ++row) {
+            const auto& srcRow = src[row.index()];
+            for (auto colIt = srcRow.begin(); colIt != srcRow.end(); ++colIt)
+                row.insert(colIt.index());
+        }
+    }
+
+    for (size_t rowIdx = 0; rowIdx < src.N(); ++rowIdx) {
+        const auto& srcRow = src[rowIdx];
+        auto& destRow = (*dest)[rowIdx];
+        auto destColIt = destRow.begin();
+        for (auto srcColIt = srcRow.begin(); srcColIt != srcRow.end(); ++srcColIt, ++destColIt) {
+            const auto& srcBlock = *srcColIt;
+            auto& destBlock = *destColIt;
+            for (size_t i = 0; i < srcBlock.N(); ++i)
+                for (size_t j = 0; j < srcBlock.M(); ++j)
+                    destBlock[i][j] = static_cast<DestField>(srcBlock[i][j]);
+        }
+    }
+}
+
+} // namespace Linear
+} // namespace Opm
+
+#endif
@@ -217,46 +217,57 @@ public:
                                 "row");
     }
 
+    /*!
+     * \brief Returns true if the overlapping matrix exhibits exactly the same rows and
+     *        sparsity pattern as the native matrix it was created from.
+     *
+     * This is the case if the process does not have any peers. Then the native matrix
+     * may be assembled directly into the storage of the overlapping one.
+     */
+    bool sharesNativeLayout() const
+    { return sharesNativeLayout_; }
+
+    /*!
+     * \brief Copy the entries of a non-overlapping matrix to the overlapping one.
+     *
+     * The native matrix must exhibit the same sparsity pattern as the one which was used
+     * to construct the overlapping matrix. If the native matrix is this object, i.e., if
+     * the entries have been assembled directly into the overlapping matrix, nothing
+     * needs to be done.
+     */
     template <class NativeBCRSMatrix>
     void assignFromNative(const NativeBCRSMatrix& nativeMatrix)
     {
-        // first, set everything to 0,
-        BCRSMatrix::operator=(0.0);
+        if (static_cast<const void*>(&nativeMatrix) == static_cast<const void*>(&asParent()))
+            return;
 
-        // then copy the domestic entries of the native matrix to the overlapping matrix
-        for (unsigned nativeRowIdx = 0; nativeRowIdx < nativeMatrix.N(); ++nativeRowIdx) {
-            Index domesticRowIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeRowIdx));
-            if (domesticRowIdx < 0) {
-                continue; // row corresponds to a black-listed entry
-            }
+        if (nativeEntryTargets_.size() != nativeMatrix.nonzeroes()
+            || nativeRowOffsets_.size() != nativeMatrix.N() + 1)
+        {
+            // the mapping from native to domestic entries is not available, e.g.,
+            // because this object was copied from another one
+            assignFromNativeByIndex_(nativeMatrix);
+            return;
+        }
+
+        // set the blocks which do not receive a native entry to zero
+        for (unsigned domRowIdx : partialRows_)
+            (*this)[domRowIdx] = 0.0;
 
+        // copy the native entries using the pre-computed destination blocks
+        size_t numNativeRows = nativeMatrix.N();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(numNativeRows >= minParallelRows_)
+#endif
+        for (size_t nativeRowIdx = 0; nativeRowIdx < numNativeRows; ++nativeRowIdx) {
+            block_type* const* dest = nativeEntryTargets_.data() + nativeRowOffsets_[nativeRowIdx];
             auto nativeColIt = nativeMatrix[nativeRowIdx].begin();
             const auto& nativeColEndIt = nativeMatrix[nativeRowIdx].end();
-            for (; nativeColIt != nativeColEndIt; ++nativeColIt) {
-                Index domesticColIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeColIt.index()));
+            for (; nativeColIt != nativeColEndIt; ++nativeColIt, ++dest) {
+                if (!*dest)
+                    continue; // entry corresponds to a black-listed DOF
 
-                // make sure to include all off-diagonal entries, even those which belong
-                // to DOFs which are managed by a peer process. For this, we have to
-                // re-map the column index of the black-listed index to a native one.
-                if (domesticColIdx < 0)
-                    domesticColIdx = overlap_->blackList().nativeToDomestic(static_cast<Index>(nativeColIt.index()));
-
-                if (domesticColIdx < 0)
-                    // there is no domestic index which corresponds to a black-listed
-                    // one. this can happen if the grid overlap is larger than the
-                    // algebraic one...
-                    continue;
-
-                // we need to copy the block matrices manually since it seems that (at
-                // least some versions of) Dune have an endless recursion bug when
-                // assigning dense matrices of different field type
-                const auto& src = *nativeColIt;
-                auto& dest = (*this)[static_cast<unsigned>(domesticRowIdx)][static_cast<unsigned>(domesticColIdx)];
-                for (unsigned i = 0; i < src.rows; ++i) {
-                    for (unsigned j = 0; j < src.cols; ++j) {
-                        dest[i][j] = static_cast<field_type>(src[i][j]);
-                    }
-                }
+                copyBlock_(**dest, *nativeColIt);
             }
         }
     }
@@ -334,6 +345,122 @@ private:
 
         // communicate the entries
         buildIndices_(nativeMatrix);
+
+        // remember where the native entries end up
+        buildNativeEntryTargets_(nativeMatrix);
+    }
+
+    // returns the domestic index of the column of a native matrix entry or -1 if the
+    // entry does not have a domestic counterpart
+    Index nativeColToDomestic_(Index nativeColIdx) const
+    {
+        Index domesticColIdx = overlap_->nativeToDomestic(nativeColIdx);
+
+        // make sure to include all off-diagonal entries, even those which belong to
+        // DOFs which are managed by a peer process. For this, we have to re-map the
+        // column index of the black-listed index to a native one.
+        if (domesticColIdx < 0)
+            domesticColIdx = overlap_->blackList().nativeToDomestic(nativeColIdx);
+
+        // if there is no domestic index which corresponds to a black-listed one, -1 is
+        // returned. this can happen if the grid overlap is larger than the algebraic
+        // one...
+        return domesticColIdx;
+    }
+
+    // determine the block of the overlapping matrix for each entry of the native
+    // matrix. the blocks are stored in the order of the native entries, so that
+    // assignFromNative() does not need to look up any indices.
+    template <class NativeBCRSMatrix>
+    void buildNativeEntryTargets_(const NativeBCRSMatrix& nativeMatrix)
+    {
+        size_t numNativeRows = nativeMatrix.N();
+        size_t numDomestic = overlap_->numDomestic();
+
+        nativeRowOffsets_.resize(numNativeRows + 1);
+        nativeEntryTargets_.resize(nativeMatrix.nonzeroes());
+        std::vector<size_t> numTargetsOfRow(numDomestic, 0);
+        sharesNativeLayout_ =
+            overlap_->peerSet().empty()
+            && numNativeRows == numDomestic
+            && nativeMatrix.nonzeroes() == this->nonzeroes();
+
+        size_t entryIdx = 0;
+        for (unsigned nativeRowIdx = 0; nativeRowIdx < numNativeRows; ++nativeRowIdx) {
+            nativeRowOffsets_[nativeRowIdx] = entryIdx;
+            Index domesticRowIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeRowIdx));
+            sharesNativeLayout_ = sharesNativeLayout_ && domesticRowIdx == static_cast<Index>(nativeRowIdx);
+
+            auto nativeColIt = nativeMatrix[nativeRowIdx].begin();
+            const auto& nativeColEndIt = nativeMatrix[nativeRowIdx].end();
+            for (; nativeColIt != nativeColEndIt; ++nativeColIt, ++entryIdx) {
+                auto& target = nativeEntryTargets_[entryIdx];
+                target = nullptr;
+                if (domesticRowIdx < 0)
+                    continue; // row corresponds to a black-listed entry
+
+                Index domesticColIdx = nativeColToDomestic_(static_cast<Index>(nativeColIt.index()));
+                sharesNativeLayout_ = sharesNativeLayout_ && domesticColIdx == static_cast<Index>(nativeColIt.index());
+                if (domesticColIdx < 0)
+                    continue;
+
+                auto& domesticRow = (*this)[static_cast<unsigned>(domesticRowIdx)];
+                auto destIt = domesticRow.find(static_cast<unsigned>(domesticColIdx));
+                if (destIt == domesticRow.end())
+                    continue;
+
+                target = &(*destIt);
+                ++ numTargetsOfRow[static_cast<unsigned>(domesticRowIdx)];
+            }
+        }
+        nativeRowOffsets_[numNativeRows] = entryIdx;
+
+        // the rows which are not fully covered by native entries must be set to zero
+        // before the native entries are copied
+        partialRows_.clear();
+        for (unsigned domRowIdx = 0; domRowIdx < numDomestic; ++domRowIdx)
+            if (numTargetsOfRow[domRowIdx] != (*this)[domRowIdx].size())
+                partialRows_.push_back(domRowIdx);
+
+        // the layouts are only identical if each domestic block receives a native entry
+        sharesNativeLayout_ = sharesNativeLayout_ && partialRows_.empty();
+    }
+
+    template <class NativeBCRSMatrix>
+    void assignFromNativeByIndex_(const NativeBCRSMatrix& nativeMatrix)
+    {
+        // first, set everything to 0,
+        BCRSMatrix::operator=(0.0);
+
+        // then copy the domestic entries of the native matrix to the overlapping matrix
+        for (unsigned nativeRowIdx = 0; nativeRowIdx < nativeMatrix.N(); ++nativeRowIdx) {
+            Index domesticRowIdx = overlap_->nativeToDomestic(static_cast<Index>(nativeRowIdx));
+            if (domesticRowIdx < 0) {
+                continue; // row corresponds to a black-listed entry
+            }
+
+            auto nativeColIt = nativeMatrix[nativeRowIdx].begin();
+            const auto& nativeColEndIt = nativeMatrix[nativeRowIdx].end();
+            for (; nativeColIt != nativeColEndIt; ++nativeColIt) {
+                Index domesticColIdx = nativeColToDomestic_(static_cast<Index>(nativeColIt.index()));
+                if (domesticColIdx < 0)
+                    continue;
+
+                copyBlock_((*this)[static_cast<unsigned>(domesticRowIdx)][static_cast<unsigned>(domesticColIdx)],
+                           *nativeColIt);
+            }
+        }
+    }
+
+    // we need to copy the block matrices manually since it seems that (at least some
+    // versions of) Dune have an endless recursion bug when assigning dense matrices of
+    // different field type
+    template <class NativeBlock>
+    static void copyBlock_(block_type& dest, const NativeBlock& src)
+    {
+        for (unsigned i = 0; i < src.rows; ++i)
+            for (unsigned j = 0; j < src.cols; ++j)
+                dest[i][j] = static_cast<field_type>(src[i][j]);
     }
 
     template <class NativeBCRSMatrix>
@@ -670,8 +797,16 @@ private:
             idxBuff[i] = overlap_->globalToDomestic(idxBuff[i]);
     }
 
+    static constexpr size_t minParallelRows_ = 1024;
+
     int myRank_;
     Entries entries_;
+
+    // the destination blocks of the native entries in the order of the native matrix
+    std::vector<block_type*> nativeEntryTargets_;
+    std::vector<size_t> nativeRowOffsets_;
+    std::vector<unsigned> partialRows_;
+    bool sharesNativeLayout_ = false;
     std::shared_ptr<Overlap> overlap_;
 
     std::map<ProcessRank, MpiBuffer<unsigned> *> numRowsSendBuff_;
@@ -27,15 +27,22 @@
 #ifndef EWOMS_OVERLAPPING_SCALAR_PRODUCT_HH
 #define EWOMS_OVERLAPPING_SCALAR_PRODUCT_HH
 
+#include <opm/models/utils/profiler.hh>
+
 #include <dune/common/version.hh>
 #include <dune/common/parallel/mpihelper.hh>
 #include <dune/istl/scalarproducts.hh>
 
+#include <cmath>
+#include <vector>
+
 namespace Opm {
 namespace Linear {
 
 /*!
  * \brief An overlap aware ISTL scalar product.
+ *
+ * The local part of the scalar product is computed by all OpenMP threads.
  */
 template <class OverlappingBlockVector, class Overlap>
 class OverlappingScalarProduct
@@ -47,13 +54,24 @@ public:
 
     using real_type = typename Dune::ScalarProduct<OverlappingBlockVector>::real_type;
 
+    static constexpr size_t blockSize = OverlappingBlockVector::block_type::dimension;
+
     //! the kind of computations supported by the operator. Either overlapping or non-overlapping
     Dune::SolverCategory::Category category() const override
     { return Dune::SolverCategory::overlapping; }
 
     OverlappingScalarProduct(const Overlap& overlap)
         : overlap_(overlap), comm_( Dune::MPIHelper::getCollectiveCommunication() )
-    {}
+    {
+        // only the entries of which the current process is the master contribute to the
+        // scalar product. the contributions of all other entries are skipped by a
+        // select instead of a branch in the hot loops. (multiplying them by zero would
+        // not work if they are not finite.)
+        size_t numLocal = overlap_.numLocal();
+        isMaster_.resize(numLocal);
+        for (size_t localIdx = 0; localIdx < numLocal; ++localIdx)
+            isMaster_[localIdx] = overlap_.iAmMasterOf(static_cast<int>(localIdx));
+    }
 
 #if DUNE_VERSION_NEWER(DUNE_ISTL, 2,7)
     field_type dot(const OverlappingBlockVector& x,
@@ -64,16 +82,65 @@ public:
 #endif
     {
         field_type sum = 0;
-        size_t numLocal = overlap_.numLocal();
-        for (unsigned localIdx = 0; localIdx < numLocal; ++localIdx) {
-            if (overlap_.iAmMasterOf(static_cast<int>(localIdx)))
-                sum += x[localIdx] * y[localIdx];
+        size_t numLocal = isMaster_.size();
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:sum) schedule(static) if(numLocal >= minParallelSize_)
+#endif
+        for (size_t localIdx = 0; localIdx < numLocal; ++localIdx) {
+            const auto& xb = x[localIdx];
+            const auto& yb = y[localIdx];
+            field_type blockSum = 0;
+            for (size_t k = 0; k < blockSize; ++k)
+                blockSum += xb[k]*yb[k];
+            sum += isMaster_[localIdx] ? blockSum : field_type(0);
         }
 
         // return the global sum
+        EWOMS_PROFILE_REGION("mpiReduction");
         return comm_.sum( sum );
     }
 
+    /*!
+     * \brief Compute the two scalar products (x, y1) and (x, y2) at once.
+     *
+     * Compared to two calls of dot(), x is only read once and only a single collective
+     * communication operation is required.
+     */
+    void dot(const OverlappingBlockVector& x,
+             const OverlappingBlockVector& y1,
+             const OverlappingBlockVector& y2,
+             field_type& xy1,
+             field_type& xy2) const
+    {
+        field_type sum1 = 0;
+        field_type sum2 = 0;
+        size_t numLocal = isMaster_.size();
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:sum1,sum2) schedule(static) if(numLocal >= minParallelSize_)
+#endif
+        for (size_t localIdx = 0; localIdx < numLocal; ++localIdx) {
+            const auto& xb = x[localIdx];
+            const auto& y1b = y1[localIdx];
+            const auto& y2b = y2[localIdx];
+            field_type blockSum1 = 0;
+            field_type blockSum2 = 0;
+            for (size_t k = 0; k < blockSize; ++k) {
+                blockSum1 += xb[k]*y1b[k];
+                blockSum2 += xb[k]*y2b[k];
+            }
+            bool isMaster = isMaster_[localIdx];
+            sum1 += isMaster ? blockSum1 : field_type(0);
+            sum2 += isMaster ? blockSum2 : field_type(0);
+        }
+
+        // compute both global sums with a single reduction
+        field_type sums[2] = { sum1, sum2 };
+        EWOMS_PROFILE_REGION("mpiReduction");
+        comm_.sum(sums, 2);
+        xy1 = sums[0];
+        xy2 = sums[1];
+    }
+
 #if DUNE_VERSION_NEWER(DUNE_ISTL, 2,7)
     real_type norm(const OverlappingBlockVector& x) const override
 #else
@@ -82,8 +149,13 @@ public:
     { return std::sqrt(dot(x, x)); }
 
 private:
+    // the minimum number of blocks for which the scalar product is computed by
+    // multiple threads
+    static constexpr size_t minParallelSize_ = 1024;
+
     const Overlap& overlap_;
     const CollectiveCommunication comm_;
+    std::vector<char> isMaster_;
 };
 
 } // namespace Linear
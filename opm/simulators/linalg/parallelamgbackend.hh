@@ -96,11 +96,14 @@ class ParallelAmgBackend : public ParallelBaseBackend<TypeTag>
     using OverlappingVector = typename ParentType::OverlappingVector;
     using ParallelPreconditioner = typename ParentType::ParallelPreconditioner;
     using ParallelScalarProduct = typename ParentType::ParallelScalarProduct;
+    using PreconditionerScalar = typename ParentType::PreconditionerScalar;
 
     static constexpr int numEq = getPropValue<TypeTag, Properties::NumEq>();
-    using VectorBlock = Dune::FieldVector<LinearSolverScalar, numEq>;
     using MatrixBlock = typename SparseMatrixAdapter::MatrixBlock;
-    using IstlMatrix = typename SparseMatrixAdapter::IstlMatrix;
+
+    // the AMG hierarchy is stored using the floating point type of the preconditioner
+    using VectorBlock = Dune::FieldVector<PreconditionerScalar, numEq>;
+    using IstlMatrix = Dune::BCRSMatrix<Opm::MatrixBlock<PreconditionerScalar, numEq, numEq> >;
 
     using Vector = Dune::BlockVector<VectorBlock>;
 
@@ -139,9 +142,16 @@ class ParallelAmgBackend : public ParallelBaseBackend<TypeTag>
     using AMG = Dune::Amg::AMG<FineOperator, Vector, ParallelSmoother>;
 #endif
 
+    // if the AMG uses other floating point values than the linear solver, the vectors
+    // are converted for each of its applications
+    using AmgPreconditioner = std::conditional_t<ParentType::mixedPrecision_,
+                                                 MixedPrecisionPreconditioner<AMG, OverlappingVector>,
+                                                 AMG>;
+
     using RawLinearSolver = BiCGStabSolver<ParallelOperator,
                                            OverlappingVector,
-                                           AMG> ;
+                                           AmgPreconditioner,
+                                           ParallelScalarProduct>;
 
     static_assert(std::is_same<SparseMatrixAdapter, IstlSparseMatrixAdapter<MatrixBlock> >::value,
                   "The ParallelAmgBackend linear solver backend requires the IstlSparseMatrixAdapter");
@@ -149,6 +159,7 @@ class ParallelAmgBackend : public ParallelBaseBackend<TypeTag>
 public:
     ParallelAmgBackend(const Simulator& simulator)
         : ParentType(simulator)
+        , istlCommOverlapVersion_(0)
     { }
 
     static void registerParameters()
@@ -166,26 +177,59 @@ public:
 protected:
     friend ParentType;
 
-    std::shared_ptr<AMG> preparePreconditioner_()
+    std::shared_ptr<AmgPreconditioner> preparePreconditioner_()
     {
 #if HAVE_MPI
-        // create and initialize DUNE's OwnerOverlapCopyCommunication
-        // using the domestic overlap
-        istlComm_ = std::make_shared<OwnerOverlapCopyCommunication>(MPI_COMM_WORLD);
-        setupAmgIndexSet_(this->overlappingMatrix_->overlap(), istlComm_->indexSet());
-        istlComm_->remoteIndices().template rebuild<false>();
+        // create and initialize DUNE's OwnerOverlapCopyCommunication using the
+        // domestic overlap. this only needs to be done if the overlap has changed.
+        if (!istlComm_ || istlCommOverlapVersion_ != this->overlapVersion_) {
+            istlComm_ = std::make_shared<OwnerOverlapCopyCommunication>(MPI_COMM_WORLD);
+            setupAmgIndexSet_(this->overlappingMatrix_->overlap(), istlComm_->indexSet());
+            istlComm_->remoteIndices().template rebuild<false>();
+            istlCommOverlapVersion_ = this->overlapVersion_;
+        }
 #endif
 
         // create the parallel scalar product and the parallel operator
 #if HAVE_MPI
-        fineOperator_ = std::make_shared<FineOperator>(*this->overlappingMatrix_, *istlComm_);
+        fineOperator_ = std::make_shared<FineOperator>(this->preparePreconditionerMatrix_(), *istlComm_);
 #else
-        fineOperator_ = std::make_shared<FineOperator>(*this->overlappingMatrix_);
+        fineOperator_ = std::make_shared<FineOperator>(this->preparePreconditionerMatrix_());
 #endif
 
         setupAmg_();
 
-        return amg_;
+        if constexpr (ParentType::mixedPrecision_)
+            return std::make_shared<AmgPreconditioner>(*amg_);
+        else
+            return amg_;
+    }
+
+    std::shared_ptr<AmgPreconditioner>
+    updatePreconditioner_(std::shared_ptr<AmgPreconditioner> amgPreCond)
+    {
+        // the fine level matrix of a mixed precision AMG is a converted copy of the
+        // matrix of the linear solver, so its values need to be updated first
+        if constexpr (ParentType::mixedPrecision_)
+            this->preparePreconditionerMatrix_();
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,7)
+        // keep the aggregates of the AMG hierarchy, but recompute the coarse level
+        // matrices, the smoothers and the coarse level solver (which might be a
+        // direct solver that stores a factorization) for the current values of the
+        // fine level matrix
+        CoarsenCriterion coarsenCriterion = createCoarsenCriterion_();
+#if HAVE_MPI
+        amg_->updateSolver(coarsenCriterion, *fineOperator_, *istlComm_);
+#else
+        amg_->updateSolver(coarsenCriterion, *fineOperator_, Dune::Amg::SequentialInformation());
+#endif
+        return amgPreCond;
+#else
+        // older versions of dune-istl cannot set up the coarse level solver again
+        // without rebuilding the whole hierarchy
+        return preparePreconditioner_();
+#endif
     }
 
     void cleanupPreconditioner_()
@@ -193,7 +237,7 @@ protected:
 
     std::shared_ptr<RawLinearSolver> prepareSolver_(ParallelOperator& parOperator,
                                                     ParallelScalarProduct& parScalarProduct,
-                                                    AMG& parPreCond)
+                                                    AmgPreconditioner& parPreCond)
     {
         const auto& gridView = this->simulator_.gridView();
         using CCC = CombinedCriterion<OverlappingVector, decltype(gridView.comm())>;
@@ -260,28 +304,20 @@ protected:
     }
 #endif
 
-    void setupAmg_()
-    {
-        if (amg_)
-            amg_.reset();
+    using CoarsenCriterion = Dune::Amg::
+        CoarsenCriterion<Dune::Amg::SymmetricCriterion<IstlMatrix, Dune::Amg::FrobeniusNorm> >;
 
+    CoarsenCriterion createCoarsenCriterion_() const
+    {
         int verbosity = 0;
         if (this->simulator_.vanguard().gridView().comm().rank() == 0)
             verbosity = EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity);
 
-        using SmootherArgs = typename Dune::Amg::SmootherTraits<ParallelSmoother>::Arguments;
-
-        SmootherArgs smootherArgs;
-        smootherArgs.iterations = 1;
-        smootherArgs.relaxationFactor = 1.0;
-
         // specify the coarsen criterion:
         //
         // using CoarsenCriterion =
         // Dune::Amg::CoarsenCriterion<Dune::Amg::SymmetricCriterion<IstlMatrix,
         //                             Dune::Amg::FirstDiagonal>>
-        using CoarsenCriterion = Dune::Amg::
-            CoarsenCriterion<Dune::Amg::SymmetricCriterion<IstlMatrix, Dune::Amg::FrobeniusNorm> >;
         int coarsenTarget = EWOMS_GET_PARAM(TypeTag, int, AmgCoarsenTarget);
         CoarsenCriterion coarsenCriterion(/*maxLevel=*/15, coarsenTarget);
         coarsenCriterion.setDefaultValuesAnisotropic(GridView::dimension,
@@ -297,6 +333,22 @@ protected:
         coarsenCriterion.setAccumulate(Dune::Amg::atOnceAccu);
         coarsenCriterion.setSkipIsolated(false);
 
+        return coarsenCriterion;
+    }
+
+    void setupAmg_()
+    {
+        if (amg_)
+            amg_.reset();
+
+        using SmootherArgs = typename Dune::Amg::SmootherTraits<ParallelSmoother>::Arguments;
+
+        SmootherArgs smootherArgs;
+        smootherArgs.iterations = 1;
+        smootherArgs.relaxationFactor = 1.0;
+
+        CoarsenCriterion coarsenCriterion = createCoarsenCriterion_();
+
 // instantiate the AMG preconditioner
 #if HAVE_MPI
         amg_ = std::make_shared<AMG>(*fineOperator_, coarsenCriterion, smootherArgs, *istlComm_);
@@ -313,6 +365,7 @@ protected:
 #if HAVE_MPI
     std::shared_ptr<OwnerOverlapCopyCommunication> istlComm_;
 #endif
+    unsigned istlCommOverlapVersion_;
 };
 
 } // namespace Linear
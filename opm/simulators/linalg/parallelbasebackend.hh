@@ -35,8 +35,12 @@
 #include <opm/simulators/linalg/overlappingoperator.hh>
 #include <opm/simulators/linalg/parallelbasebackend.hh>
 #include <opm/simulators/linalg/istlpreconditionerwrappers.hh>
+#include <opm/simulators/linalg/mixedprecisionpreconditioner.hh>
 
 #include <opm/models/utils/genericguard.hh>
+#include <opm/models/utils/timer.hh>
+#include <opm/models/utils/timerguard.hh>
+#include <opm/models/utils/profiler.hh>
 #include <opm/models/utils/propertysystem.hh>
 #include <opm/models/utils/parametersystem.hh>
 #include <opm/simulators/linalg/matrixblock.hh>
@@ -47,9 +51,11 @@
 #include <dune/common/fvector.hh>
 #include <dune/common/version.hh>
 
+#include <algorithm>
 #include <sstream>
 #include <memory>
 #include <iostream>
+#include <type_traits>
 
 namespace Opm::Properties {
 
@@ -101,6 +107,26 @@ namespace Linear {
  *            that it is computationally cheaper because it does not
  *            need to consider things which are only required for
  *            higher orders
+ * - \c LevelScheduledILU0: An ILU(0) preconditioner which processes independent rows
+ *            using multiple threads. Its results are the same as the ones of ILU0.
+ * - \c ThreadedBlockILU0: A block Jacobi preconditioner with one ILU(0) factorized
+ *            block per thread
+ *
+ * The preconditioner can be reused for several linear solves: It is rebuilt after
+ * PreconditionerReuseMaxSolves solves, if the number of iterations of the linear solver
+ * grew by more than the factor PreconditionerReuseMaxIterationGrowth since the last
+ * rebuild or, if PreconditionerRebuildAtTimeStepStart is set, for the first solve of
+ * each time step. It is also rebuilt after a linear solve which did not converge. In
+ * between, the preconditioner is only updated to the current values of the matrix: The
+ * sequential preconditioners are set up again (e.g., ILU factorizations are recomputed),
+ * while the AMG keeps its aggregates and only recomputes its coarse level operators,
+ * smoothers and coarse level solver.
+ *
+ * If the PreconditionerScalar property differs from LinearSolverScalar, the
+ * preconditioner is set up for a copy of the matrix which uses PreconditionerScalar
+ * and it is applied to converted vectors, while the iterations of the linear solver
+ * stay in LinearSolverScalar. The conversion of the matrix happens once per setup of
+ * the preconditioner.
  */
 template <class TypeTag>
 class ParallelBaseBackend
@@ -112,6 +138,7 @@ protected:
     using Scalar = GetPropType<TypeTag, Properties::Scalar>;
     using LinearSolverScalar = GetPropType<TypeTag, Properties::LinearSolverScalar>;
     using SparseMatrixAdapter = GetPropType<TypeTag, Properties::SparseMatrixAdapter>;
+    using IstlMatrix = typename SparseMatrixAdapter::IstlMatrix;
     using Vector = GetPropType<TypeTag, Properties::GlobalEqVector>;
     using BorderListCreator = GetPropType<TypeTag, Properties::BorderListCreator>;
     using GridView = GetPropType<TypeTag, Properties::GridView>;
@@ -123,7 +150,20 @@ protected:
     using PreconditionerWrapper = GetPropType<TypeTag, Properties::PreconditionerWrapper>;
     using SequentialPreconditioner = typename PreconditionerWrapper::SequentialPreconditioner;
 
-    using ParallelPreconditioner = Opm::Linear::OverlappingPreconditioner<SequentialPreconditioner, Overlap>;
+    using PreconditionerScalar = GetPropType<TypeTag, Properties::PreconditionerScalar>;
+    using PreconditionerMatrix = GetPropType<TypeTag, Properties::PreconditionerMatrix>;
+
+    // if the preconditioner uses different floating point values than the linear
+    // solver, it operates on a converted copy of the matrix and the vectors
+    static constexpr bool mixedPrecision_ = !std::is_same<PreconditionerScalar, LinearSolverScalar>::value;
+    using MixedPrecisionPreconditioner = Opm::Linear::MixedPrecisionPreconditioner<SequentialPreconditioner,
+                                                                                   OverlappingVector>;
+
+    using ParallelPreconditioner =
+        Opm::Linear::OverlappingPreconditioner<std::conditional_t<mixedPrecision_,
+                                                                  MixedPrecisionPreconditioner,
+                                                                  SequentialPreconditioner>,
+                                               Overlap>;
     using ParallelScalarProduct = Opm::Linear::OverlappingScalarProduct<OverlappingVector, Overlap>;
     using ParallelOperator = Opm::Linear::OverlappingOperator<OverlappingMatrix,
                                                               OverlappingVector,
@@ -136,14 +176,24 @@ public:
         : simulator_(simulator)
         , gridSequenceNumber_( -1 )
         , lastIterations_( -1 )
+        , overlapVersion_( 0 )
+        , numPreconditionerSetups_( 0 )
+        , numSolves_( 0 )
     {
-        overlappingMatrix_ = nullptr;
         overlappingb_ = nullptr;
         overlappingx_ = nullptr;
+
+        reuseMaxSolves_ = EWOMS_GET_PARAM(TypeTag, int, PreconditionerReuseMaxSolves);
+        reuseMaxIterationGrowth_ = EWOMS_GET_PARAM(TypeTag, Scalar, PreconditionerReuseMaxIterationGrowth);
+        rebuildAtTimeStepStart_ = EWOMS_GET_PARAM(TypeTag, bool, PreconditionerRebuildAtTimeStepStart);
+        resetReuseState_();
     }
 
     ~ParallelBaseBackend()
-    { cleanup_(); }
+    {
+        preconditioner_.reset();
+        cleanup_();
+    }
 
     /*!
      * \brief Register all run-time parameters for the linear solver.
@@ -160,6 +210,14 @@ public:
                              "The maximum number of iterations of the linear solver");
         EWOMS_REGISTER_PARAM(TypeTag, int, LinearSolverVerbosity,
                              "The verbosity level of the linear solver");
+        EWOMS_REGISTER_PARAM(TypeTag, int, PreconditionerReuseMaxSolves,
+                             "The maximum number of linear solves for which the preconditioner is reused");
+        EWOMS_REGISTER_PARAM(TypeTag, Scalar, PreconditionerReuseMaxIterationGrowth,
+                             "Rebuild a reused preconditioner if the number of linear iterations "
+                             "grew by more than this factor since it was built. Non-positive values "
+                             "disable this criterion");
+        EWOMS_REGISTER_PARAM(TypeTag, bool, PreconditionerRebuildAtTimeStepStart,
+                             "Always rebuild the preconditioner for the first linear solve of a time step");
 
         PreconditionerWrapper::registerParameters();
     }
@@ -169,7 +227,10 @@ public:
      *        equations the next time it is called.
      */
     void eraseMatrix()
-    { cleanup_(); }
+    {
+        releasePreconditioner_();
+        cleanup_();
+    }
 
     /*!
      * \brief Set up the internal data structures required for the linear solver.
@@ -186,18 +247,20 @@ public:
             // there's noting to do
             return;
 
+        releasePreconditioner_();
         asImp_().cleanup_();
         gridSequenceNumber_ = curSeqNum;
+        ++ overlapVersion_;
 
         BorderListCreator borderListCreator(simulator_.gridView(),
                                             simulator_.model().dofMapper());
 
         // create the overlapping Jacobian matrix
         unsigned overlapSize = EWOMS_GET_PARAM(TypeTag, unsigned, LinearSolverOverlapSize);
-        overlappingMatrix_ = new OverlappingMatrix(M.istlMatrix(),
-                                                   borderListCreator.borderList(),
-                                                   borderListCreator.blackList(),
-                                                   overlapSize);
+        overlappingMatrix_ = std::make_shared<OverlappingMatrix>(M.istlMatrix(),
+                                                                 borderListCreator.borderList(),
+                                                                 borderListCreator.blackList(),
+                                                                 overlapSize);
 
         // create the overlapping vectors for the residual and the
         // solution
@@ -238,10 +301,36 @@ public:
      */
     void setMatrix(const SparseMatrixAdapter& M)
     {
+        EWOMS_PROFILE_REGION("matrixSync");
+
+        // if the matrix has been assembled directly into the overlapping matrix, this
+        // does not copy anything
         overlappingMatrix_->assignFromNative(M.istlMatrix());
         overlappingMatrix_->syncAdd();
     }
 
+    /*!
+     * \brief Sets the values of the residual's Jacobian matrix and lets the matrix
+     *        use the storage of the linear solver if possible.
+     *
+     * If the overlapping matrix exhibits the same layout as the native one (i.e., if
+     * the process does not have any peers), the native matrix is subsequently assembled
+     * directly into the storage of the overlapping matrix, so that its entries do not
+     * need to be copied anymore.
+     */
+    void setMatrix(SparseMatrixAdapter& M)
+    {
+        setMatrix(static_cast<const SparseMatrixAdapter&>(M));
+
+        if constexpr (std::is_convertible<OverlappingMatrix*, IstlMatrix*>::value) {
+            if (overlappingMatrix_->sharesNativeLayout()
+                && &M.istlMatrix() != static_cast<IstlMatrix*>(overlappingMatrix_.get()))
+            {
+                M.shareStorage(std::shared_ptr<IstlMatrix>(overlappingMatrix_, overlappingMatrix_.get()));
+            }
+        }
+    }
+
     /*!
      * \brief Actually solve the linear system of equations.
      *
@@ -256,10 +345,8 @@ public:
 
         (*overlappingx_) = 0.0;
 
-        auto parPreCond = asImp_().preparePreconditioner_();
-        auto precondCleanupFn = [this]() -> void
-                                { this->asImp_().cleanupPreconditioner_(); };
-        auto precondCleanupGuard = Opm::make_guard(precondCleanupFn);
+        auto parPreCond = retrievePreconditioner_();
+
         // create the parallel scalar product and the parallel operator
         ParallelScalarProduct parScalarProduct(overlappingMatrix_->overlap());
         ParallelOperator parOperator(*overlappingMatrix_);
@@ -275,9 +362,38 @@ public:
         GenericGuard<decltype(cleanupSolverFn)> solverGuard(cleanupSolverFn);
 
         // run the linear solver and have some fun
-        auto result = asImp_().runSolver_(solver);
+        std::pair<bool, int> result;
+        try {
+            Opm::TimerGuard solverTimerGuard(solverTimer_);
+            solverTimer_.start();
+            EWOMS_PROFILE_REGION("krylovSolver");
+            result = asImp_().runSolver_(solver);
+        }
+        catch (...) {
+            // do not reuse a preconditioner which caused trouble
+            releasePreconditioner_();
+            throw;
+        }
         // store number of iterations used
         lastIterations_ = result.second;
+        ++ numSolves_;
+        ++ solvesSinceRebuild_;
+        if (iterationsAfterRebuild_ < 0)
+            iterationsAfterRebuild_ = result.second;
+
+        // do not reuse a preconditioner for which the solver did not converge
+        if (!result.first)
+            releasePreconditioner_();
+
+        if (EWOMS_GET_PARAM(TypeTag, int, LinearSolverVerbosity) > 0
+            && simulator_.gridView().comm().rank() == 0)
+        {
+            std::cout << "Linear solver statistics: "
+                      << numSolves_ << " solves, "
+                      << numPreconditionerSetups_ << " preconditioner setups, "
+                      << preconditionerSetupTimer_.realTimeElapsed() << " s preconditioner setup time, "
+                      << solverTimer_.realTimeElapsed() << " s solver time\n" << std::flush;
+        }
 
         // copy the result back to the non-overlapping vector
         overlappingx_->assignTo(x);
@@ -292,6 +408,31 @@ public:
     size_t iterations () const
     { return lastIterations_; }
 
+    /*!
+     * \brief Return the number of times the preconditioner has been built.
+     */
+    size_t numPreconditionerSetups() const
+    { return numPreconditionerSetups_; }
+
+    /*!
+     * \brief Return the number of linear solves.
+     */
+    size_t numSolves() const
+    { return numSolves_; }
+
+    /*!
+     * \brief Return the timer which measures building and updating the preconditioner.
+     */
+    const Opm::Timer& preconditionerSetupTimer() const
+    { return preconditionerSetupTimer_; }
+
+    /*!
+     * \brief Return the timer which measures running the linear solver, i.e., the
+     *        time spent applying the preconditioner and the linear operator.
+     */
+    const Opm::Timer& solverTimer() const
+    { return solverTimer_; }
+
 protected:
     Implementation& asImp_()
     { return *static_cast<Implementation *>(this); }
@@ -302,21 +443,106 @@ protected:
     void cleanup_()
     {
         // create the overlapping Jacobian matrix and vectors
-        delete overlappingMatrix_;
+        overlappingMatrix_.reset();
+        preconditionerMatrix_.reset();
         delete overlappingb_;
         delete overlappingx_;
 
-        overlappingMatrix_ = 0;
         overlappingb_ = 0;
         overlappingx_ = 0;
     }
 
+    // returns the preconditioner for the next linear solve. depending on the reuse
+    // policy, it is either rebuilt or the one of the previous solve is updated.
+    auto retrievePreconditioner_()
+    {
+        // the type of the preconditioner depends on the implementation
+        using PreconditionerPtr = decltype(asImp_().preparePreconditioner_());
+        using PreconditionerType = typename PreconditionerPtr::element_type;
+
+        Opm::TimerGuard setupTimerGuard(preconditionerSetupTimer_);
+        preconditionerSetupTimer_.start();
+        EWOMS_PROFILE_REGION("preconditionerSetup");
+
+        PreconditionerPtr parPreCond;
+        try {
+            if (preconditionerNeedsRebuild_()) {
+                releasePreconditioner_();
+                parPreCond = asImp_().preparePreconditioner_();
+                preconditioner_ = parPreCond;
+                ++ numPreconditionerSetups_;
+            }
+            else {
+                parPreCond = std::static_pointer_cast<PreconditionerType>(preconditioner_);
+                parPreCond = asImp_().updatePreconditioner_(parPreCond);
+                preconditioner_ = parPreCond;
+            }
+        }
+        catch (...) {
+            releasePreconditioner_();
+            throw;
+        }
+
+        lastTimeStepIndex_ = simulator_.timeStepIndex();
+        return parPreCond;
+    }
+
+    // decide whether the preconditioner of the previous linear solve can be reused
+    bool preconditionerNeedsRebuild_() const
+    {
+        if (!preconditioner_)
+            return true;
+
+        if (solvesSinceRebuild_ >= reuseMaxSolves_)
+            return true;
+
+        if (rebuildAtTimeStepStart_ && simulator_.timeStepIndex() != lastTimeStepIndex_)
+            return true;
+
+        if (reuseMaxIterationGrowth_ > 0.0
+            && iterationsAfterRebuild_ >= 0
+            && static_cast<Scalar>(lastIterations_) > reuseMaxIterationGrowth_*std::max(iterationsAfterRebuild_, 1))
+            return true;
+
+        return false;
+    }
+
+    // throw away the current preconditioner, if there is one
+    void releasePreconditioner_()
+    {
+        if (!preconditioner_)
+            return;
+
+        preconditioner_.reset();
+        asImp_().cleanupPreconditioner_();
+        resetReuseState_();
+    }
+
+    void resetReuseState_()
+    {
+        solvesSinceRebuild_ = 0;
+        iterationsAfterRebuild_ = -1;
+        lastTimeStepIndex_ = -1;
+    }
+
+    /*!
+     * \brief Update a reused preconditioner to the current values of the matrix.
+     *
+     * The sequential preconditioner is set up again for the current matrix, e.g.,
+     * incomplete factorizations are recomputed. Since this recreates the sequential
+     * preconditioner object, the parallel preconditioner which refers to it is
+     * recreated as well and returned.
+     */
+    std::shared_ptr<ParallelPreconditioner>
+    updatePreconditioner_(std::shared_ptr<ParallelPreconditioner> /*parPreCond*/)
+    { return preparePreconditioner_(); }
+
     std::shared_ptr<ParallelPreconditioner> preparePreconditioner_()
     {
         int preconditionerIsReady = 1;
         try {
             // update sequential preconditioner
-            precWrapper_.prepare(*overlappingMatrix_);
+            precWrapper_.prepare(preparePreconditionerMatrix_());
         }
         catch (const Dune::Exception& e) {
             std::cout << "Preconditioner threw exception \"" << e.what()
@@ -332,11 +558,35 @@ protected:
             throw Opm::NumericalIssue("Creating the preconditioner failed");
 
         // create the parallel preconditioner
-        return std::make_shared<ParallelPreconditioner>(precWrapper_.get(), overlappingMatrix_->overlap());
+        if constexpr (mixedPrecision_) {
+            mixedPrecisionPreconditioner_ = std::make_unique<MixedPrecisionPreconditioner>(precWrapper_.get());
+            return std::make_shared<ParallelPreconditioner>(*mixedPrecisionPreconditioner_,
+                                                            overlappingMatrix_->overlap());
+        }
+        else
+            return std::make_shared<ParallelPreconditioner>(precWrapper_.get(), overlappingMatrix_->overlap());
+    }
+
+    /*!
+     * \brief Returns the matrix which ought to be used to set up the preconditioner.
+     *
+     * If the preconditioner uses the floating point values of the linear solver, this
+     * is the overlapping matrix itself. Otherwise, the current values of the
+     * overlapping matrix are converted to PreconditionerScalar.
+     */
+    PreconditionerMatrix& preparePreconditionerMatrix_()
+    {
+        if constexpr (mixedPrecision_) {
+            convertMatrix(preconditionerMatrix_, *overlappingMatrix_);
+            return *preconditionerMatrix_;
+        }
+        else
+            return *overlappingMatrix_;
     }
 
     void cleanupPreconditioner_()
     {
+        mixedPrecisionPreconditioner_.reset();
         precWrapper_.cleanup();
     }
 
@@ -381,10 +631,33 @@ protected:
     int gridSequenceNumber_;
     size_t lastIterations_;
 
-    OverlappingMatrix *overlappingMatrix_;
+    // incremented whenever the overlapping matrix is re-created
+    unsigned overlapVersion_;
+
+    // the preconditioner which is reused by subsequent linear solves. the actual type
+    // depends on the implementation.
+    std::shared_ptr<void> preconditioner_;
+    int reuseMaxSolves_;
+    Scalar reuseMaxIterationGrowth_;
+    bool rebuildAtTimeStepStart_;
+    int solvesSinceRebuild_;
+    int iterationsAfterRebuild_;
+    int lastTimeStepIndex_;
+
+    size_t numPreconditionerSetups_;
+    size_t numSolves_;
+    Opm::Timer preconditionerSetupTimer_;
+    Opm::Timer solverTimer_;
+
+    std::shared_ptr<OverlappingMatrix> overlappingMatrix_;
     OverlappingVector *overlappingb_;
     OverlappingVector *overlappingx_;
 
+    // only used if the preconditioner uses different floating point values than the
+    // linear solver
+    std::unique_ptr<PreconditionerMatrix> preconditionerMatrix_;
+    std::unique_ptr<MixedPrecisionPreconditioner> mixedPrecisionPreconditioner_;
+
     PreconditionerWrapper precWrapper_;
 };
 }} // namespace Linear, Opm
@@ -440,6 +713,44 @@ struct OverlappingVector<TypeTag, TTag::ParallelBaseLinearSolver>
     using type = Opm::Linear::OverlappingBlockVector<VectorBlock, Overlap>;
 };
 
+//! by default, the preconditioner uses the same floating point values as the linear
+//! solver
+template<class TypeTag>
+struct PreconditionerScalar<TypeTag, TTag::ParallelBaseLinearSolver>
+{ using type = GetPropType<TypeTag, Properties::LinearSolverScalar>; };
+
+//! if the preconditioner uses a different floating point type than the linear solver,
+//! it is set up using a sequential copy of the overlapping matrix
+template<class TypeTag>
+struct PreconditionerMatrix<TypeTag, TTag::ParallelBaseLinearSolver>
+{
+private:
+    static constexpr int numEq = getPropValue<TypeTag, Properties::NumEq>();
+    using PreconditionerScalar = GetPropType<TypeTag, Properties::PreconditionerScalar>;
+    using LinearSolverScalar = GetPropType<TypeTag, Properties::LinearSolverScalar>;
+    using MatrixBlock = Opm::MatrixBlock<PreconditionerScalar, numEq, numEq>;
+
+public:
+    using type = std::conditional_t<std::is_same<PreconditionerScalar, LinearSolverScalar>::value,
+                                    GetPropType<TypeTag, Properties::OverlappingMatrix>,
+                                    Dune::BCRSMatrix<MatrixBlock> >;
+};
+
+template<class TypeTag>
+struct PreconditionerVector<TypeTag, TTag::ParallelBaseLinearSolver>
+{
+private:
+    static constexpr int numEq = getPropValue<TypeTag, Properties::NumEq>();
+    using PreconditionerScalar = GetPropType<TypeTag, Properties::PreconditionerScalar>;
+    using LinearSolverScalar = GetPropType<TypeTag, Properties::LinearSolverScalar>;
+    using VectorBlock = Dune::FieldVector<PreconditionerScalar, numEq>;
+
+public:
+    using type = std::conditional_t<std::is_same<PreconditionerScalar, LinearSolverScalar>::value,
+                                    GetPropType<TypeTag, Properties::OverlappingVector>,
+                                    Dune::BlockVector<VectorBlock> >;
+};
+
 template<class TypeTag>
 struct OverlappingScalarProduct<TypeTag, TTag::ParallelBaseLinearSolver>
 {
@@ -475,6 +786,22 @@ struct LinearSolverOverlapSize<TypeTag, TTag::ParallelBaseLinearSolver> { static
 template<class TypeTag>
 struct LinearSolverMaxIterations<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 1000; };
 
+//! rebuild the preconditioner for each linear solve by default
+template<class TypeTag>
+struct PreconditionerReuseMaxSolves<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr int value = 1; };
+
+//! rebuild a reused preconditioner if the linear solver needs twice as many iterations
+template<class TypeTag>
+struct PreconditionerReuseMaxIterationGrowth<TypeTag, TTag::ParallelBaseLinearSolver>
+{
+    using type = GetPropType<TypeTag, Scalar>;
+    static constexpr type value = 2.0;
+};
+
+//! always rebuild the preconditioner at the beginning of a time step by default
+template<class TypeTag>
+struct PreconditionerRebuildAtTimeStepStart<TypeTag, TTag::ParallelBaseLinearSolver> { static constexpr bool value = true; };
+
 } // namespace Opm::Properties
 
 #endif
@@ -107,7 +107,8 @@ class ParallelBiCGStabSolverBackend : public ParallelBaseBackend<TypeTag>
 
     using RawLinearSolver = BiCGStabSolver<ParallelOperator,
                                            OverlappingVector,
-                                           ParallelPreconditioner>;
+                                           ParallelPreconditioner,
+                                           ParallelScalarProduct>;
 
     static_assert(std::is_same<SparseMatrixAdapter, IstlSparseMatrixAdapter<MatrixBlock> >::value,
                   "The ParallelIstlSolverBackend linear solver backend requires the IstlSparseMatrixAdapter");
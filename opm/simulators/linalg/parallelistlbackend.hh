@@ -76,6 +76,8 @@ namespace Opm::Linear {
  * - \c SOR: A successive overrelaxation (SOR) preconditioner
  * - \c ILUn: An ILU(n) preconditioner
  * - \c ILU0: A specialized (and optimized) ILU(0) preconditioner
+ * - \c LevelScheduledILU0: A multi-threaded ILU(0) preconditioner
+ * - \c ThreadedBlockILU0: A block Jacobi preconditioner with one ILU(0) block per thread
  */
 template <class TypeTag>
 class ParallelIstlSolverBackend : public ParallelBaseBackend<TypeTag>
@@ -0,0 +1,388 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief ILU(0) preconditioners which use multiple threads for the factorization and
+ *        for the triangular solves.
+ */
+#ifndef EWOMS_THREADED_ILU0_HH
+#define EWOMS_THREADED_ILU0_HH
+
+#include <opm/material/common/Exceptions.hpp>
+
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/solvercategory.hh>
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Opm {
+namespace Linear {
+
+/*!
+ * \brief The functionality which is shared by the threaded ILU(0) preconditioners.
+ *
+ * The factorization is stored in a copy of the matrix: the strictly lower part holds
+ * L without its unit diagonal, the strictly upper part holds U and the diagonal blocks
+ * hold the inverses of the diagonal blocks of U. All operations only consider the
+ * columns within a given range, so that the factorization of a diagonal block of the
+ * matrix can be computed independently of the remaining matrix.
+ */
+template <class M, class X, class Y>
+class ThreadedILU0Base : public Dune::Preconditioner<X, Y>
+{
+public:
+    using matrix_type = M;
+    using domain_type = X;
+    using range_type = Y;
+    using field_type = typename X::field_type;
+
+    //! the preconditioner works on the local part of the system of equations
+    Dune::SolverCategory::Category category() const override
+    { return Dune::SolverCategory::sequential; }
+
+    void pre(X&, Y&) override
+    {}
+
+    void post(X&) override
+    {}
+
+protected:
+    using Block = typename M::block_type;
+    using IluMatrix = Dune::BCRSMatrix<Block>;
+
+    ThreadedILU0Base(const M& A, field_type relaxationFactor)
+        : ilu_(A)
+        , relaxationFactor_(relaxationFactor)
+    {}
+
+    static unsigned maxThreads_()
+    {
+#ifdef _OPENMP
+        return static_cast<unsigned>(std::max(omp_get_max_threads(), 1));
+#else
+        return 1;
+#endif
+    }
+
+    // compute row i of the factorization. all rows with smaller indices in the column
+    // range [colBegin, colEnd) which row i depends on must have been factorized before.
+    void factorizeRow_(size_t rowIdx, size_t colBegin, size_t colEnd)
+    {
+        auto& row = ilu_[rowIdx];
+        auto ij = row.begin();
+        const auto& endi = row.end();
+        while (ij != endi && ij.index() < colBegin)
+            ++ij;
+
+        for (; ij != endi && ij.index() < rowIdx; ++ij) {
+            // the diagonal block of row j already holds its inverse
+            auto& rowJ = ilu_[ij.index()];
+            auto jj = rowJ.find(ij.index());
+            (*ij).rightmultiply(*jj);
+
+            // subtract L_ij*U_jk from all entries (i, k) with k > j of the pattern
+            auto ik = ij;
+            ++ik;
+            auto jk = jj;
+            ++jk;
+            const auto& endj = rowJ.end();
+            while (ik != endi && jk != endj && jk.index() < colEnd) {
+                if (ik.index() == jk.index()) {
+                    Block tmp(*jk);
+                    tmp.leftmultiply(*ij);
+                    *ik -= tmp;
+                    ++ik;
+                    ++jk;
+                }
+                else if (ik.index() < jk.index())
+                    ++ik;
+                else
+                    ++jk;
+            }
+        }
+
+        if (ij == endi || ij.index() != rowIdx)
+            throw Opm::NumericalIssue("ILU(0) preconditioner: row without a diagonal entry");
+        (*ij).invert();
+    }
+
+    // solve row i of L v = d
+    void forwardRow_(X& v, const Y& d, size_t rowIdx, size_t colBegin) const
+    {
+        typename Y::block_type rhs(d[rowIdx]);
+        const auto& row = ilu_[rowIdx];
+        for (auto ij = row.begin(); ij.index() < rowIdx; ++ij)
+            if (ij.index() >= colBegin)
+                (*ij).mmv(v[ij.index()], rhs);
+        v[rowIdx] = rhs;
+    }
+
+    // solve row i of U v = w in place
+    void backwardRow_(X& v, size_t rowIdx, size_t colEnd) const
+    {
+        typename X::block_type rhs(v[rowIdx]);
+        const auto& row = ilu_[rowIdx];
+        auto ij = row.beforeEnd();
+        for (; ij.index() > rowIdx; --ij)
+            if (ij.index() < colEnd)
+                (*ij).mmv(v[ij.index()], rhs);
+        (*ij).mv(rhs, v[rowIdx]);
+    }
+
+    // execute a function for a range of indices in parallel and bridge exceptions out of
+    // the parallel region
+    template <class Fn>
+    static void parallelFor_(size_t begin, size_t end, bool useThreads, Fn&& fn)
+    {
+        std::mutex exceptionLock;
+        std::exception_ptr exceptionPtr = nullptr;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(useThreads)
+#endif
+        for (size_t i = begin; i < end; ++i) {
+            try {
+                fn(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> take(exceptionLock);
+                exceptionPtr = std::current_exception();
+            }
+        }
+
+        if (exceptionPtr)
+            std::rethrow_exception(exceptionPtr);
+    }
+
+    // the minimum number of rows for which multiple threads are used
+    static constexpr size_t minParallelSize_ = 1024;
+
+    IluMatrix ilu_;
+    field_type relaxationFactor_;
+};
+
+/*!
+ * \brief An ILU(0) preconditioner which uses level scheduling to distribute the work
+ *        amongst the threads.
+ *
+ * The rows are grouped into levels such that each row only depends on rows of earlier
+ * levels. The rows of a level are processed concurrently. In contrast to the
+ * ThreadedBlockILU0 preconditioner, the result is identical to the one of the
+ * sequential ILU(0) preconditioner, but the available parallelism depends on the
+ * ordering of the unknowns.
+ */
+template <class M, class X, class Y>
+class LevelScheduledILU0 : public ThreadedILU0Base<M, X, Y>
+{
+    using ParentType = ThreadedILU0Base<M, X, Y>;
+
+public:
+    using field_type = typename ParentType::field_type;
+
+    LevelScheduledILU0(const M& A, field_type relaxationFactor)
+        : ParentType(A, relaxationFactor)
+    {
+        size_t numRows = this->ilu_.N();
+        useThreads_ = numRows >= ParentType::minParallelSize_ && ParentType::maxThreads_() > 1;
+
+        // the factorization and the forward solve of row i depend on all rows j < i of
+        // the pattern, the backward solve depends on all rows j > i
+        std::vector<unsigned> level(numRows, 0);
+        for (size_t rowIdx = 0; rowIdx < numRows; ++rowIdx) {
+            const auto& row = this->ilu_[rowIdx];
+            for (auto ij = row.begin(); ij != row.end() && ij.index() < rowIdx; ++ij)
+                level[rowIdx] = std::max(level[rowIdx], level[ij.index()] + 1);
+        }
+        groupByLevel_(level, lowerRows_, lowerOffsets_);
+
+        level.assign(numRows, 0);
+        for (size_t rowIdx = numRows; rowIdx-- > 0;) {
+            const auto& row = this->ilu_[rowIdx];
+            for (auto ij = row.begin(); ij != row.end(); ++ij)
+                if (ij.index() > rowIdx)
+                    level[rowIdx] = std::max(level[rowIdx], level[ij.index()] + 1);
+        }
+        groupByLevel_(level, upperRows_, upperOffsets_);
+
+        forEachRow_(lowerRows_, lowerOffsets_, [this, numRows](size_t rowIdx) {
+            this->factorizeRow_(rowIdx, /*colBegin=*/0, /*colEnd=*/numRows);
+        });
+    }
+
+    /*!
+     * \brief Returns the number of levels of the forward and the backward solve.
+     */
+    std::pair<size_t, size_t> numLevels() const
+    { return std::make_pair(lowerOffsets_.size() - 1, upperOffsets_.size() - 1); }
+
+    void apply(X& v, const Y& d) override
+    {
+        size_t numRows = this->ilu_.N();
+        forEachRow_(lowerRows_, lowerOffsets_, [&](size_t rowIdx) {
+            this->forwardRow_(v, d, rowIdx, /*colBegin=*/0);
+        });
+        forEachRow_(upperRows_, upperOffsets_, [&](size_t rowIdx) {
+            this->backwardRow_(v, rowIdx, /*colEnd=*/numRows);
+        });
+        v *= this->relaxationFactor_;
+    }
+
+private:
+    // sort the rows by their level and determine the offsets of the levels
+    static void groupByLevel_(const std::vector<unsigned>& level,
+                              std::vector<unsigned>& rows,
+                              std::vector<size_t>& offsets)
+    {
+        unsigned numLevels = level.empty() ? 0 : *std::max_element(level.begin(), level.end()) + 1;
+        offsets.assign(numLevels + 1, 0);
+        for (unsigned rowLevel : level)
+            ++ offsets[rowLevel + 1];
+        for (unsigned levelIdx = 0; levelIdx < numLevels; ++levelIdx)
+            offsets[levelIdx + 1] += offsets[levelIdx];
+
+        rows.resize(level.size());
+        std::vector<size_t> nextPos(offsets.begin(), offsets.end() - 1);
+        for (size_t rowIdx = 0; rowIdx < level.size(); ++rowIdx)
+            rows[nextPos[level[rowIdx]]++] = static_cast<unsigned>(rowIdx);
+    }
+
+    // process the levels one after the other and the rows of each level concurrently.
+    template <class Fn>
+    void forEachRow_(const std::vector<unsigned>& rows,
+                     const std::vector<size_t>& offsets,
+                     Fn&& fn) const
+    {
+        if (!useThreads_) {
+            for (unsigned rowIdx : rows)
+                fn(rowIdx);
+            return;
+        }
+
+        std::mutex exceptionLock;
+        std::exception_ptr exceptionPtr = nullptr;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        for (size_t levelIdx = 0; levelIdx + 1 < offsets.size(); ++levelIdx) {
+            // the implicit barrier at the end of the loop makes sure that a level is
+            // completed before the next one is started
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+            for (size_t i = offsets[levelIdx]; i < offsets[levelIdx + 1]; ++i) {
+                try {
+                    fn(rows[i]);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> take(exceptionLock);
+                    exceptionPtr = std::current_exception();
+                }
+            }
+        }
+
+        if (exceptionPtr)
+            std::rethrow_exception(exceptionPtr);
+    }
+
+    bool useThreads_;
+    std::vector<unsigned> lowerRows_;
+    std::vector<size_t> lowerOffsets_;
+    std::vector<unsigned> upperRows_;
+    std::vector<size_t> upperOffsets_;
+};
+
+/*!
+ * \brief A block Jacobi preconditioner which uses an ILU(0) decomposition of the
+ *        diagonal blocks.
+ *
+ * The rows are split into one contiguous block per thread and the couplings between
+ * the blocks are ignored, so that each thread factorizes and solves its block
+ * independently. This scales better than the LevelScheduledILU0 preconditioner, but it
+ * is weaker the more threads are used. If the degrees of freedom are numbered such that
+ * the couplings are close to the diagonal (e.g., using '--dof-ordering=rcm'), only few
+ * couplings are lost.
+ */
+template <class M, class X, class Y>
+class ThreadedBlockILU0 : public ThreadedILU0Base<M, X, Y>
+{
+    using ParentType = ThreadedILU0Base<M, X, Y>;
+
+public:
+    using field_type = typename ParentType::field_type;
+
+    ThreadedBlockILU0(const M& A, field_type relaxationFactor)
+        : ParentType(A, relaxationFactor)
+    {
+        size_t numRows = this->ilu_.N();
+        size_t numBlocks = ParentType::maxThreads_();
+        if (numRows < ParentType::minParallelSize_)
+            numBlocks = 1;
+
+        blockOffsets_.resize(numBlocks + 1);
+        for (size_t blockIdx = 0; blockIdx <= numBlocks; ++blockIdx)
+            blockOffsets_[blockIdx] = (numRows*blockIdx)/numBlocks;
+
+        ParentType::parallelFor_(0, numBlocks, numBlocks > 1, [this](size_t blockIdx) {
+            size_t begin = blockOffsets_[blockIdx];
+            size_t end = blockOffsets_[blockIdx + 1];
+            for (size_t rowIdx = begin; rowIdx < end; ++rowIdx)
+                this->factorizeRow_(rowIdx, begin, end);
+        });
+    }
+
+    /*!
+     * \brief Returns the number of diagonal blocks.
+     */
+    size_t numBlocks() const
+    { return blockOffsets_.size() - 1; }
+
+    void apply(X& v, const Y& d) override
+    {
+        ParentType::parallelFor_(0, numBlocks(), numBlocks() > 1, [&](size_t blockIdx) {
+            size_t begin = blockOffsets_[blockIdx];
+            size_t end = blockOffsets_[blockIdx + 1];
+            for (size_t rowIdx = begin; rowIdx < end; ++rowIdx)
+                this->forwardRow_(v, d, rowIdx, begin);
+            for (size_t rowIdx = end; rowIdx-- > begin;)
+                this->backwardRow_(v, rowIdx, end);
+        });
+        v *= this->relaxationFactor_;
+    }
+
+private:
+    std::vector<size_t> blockOffsets_;
+};
+
+} // namespace Linear
+} // namespace Opm
+
+#endif
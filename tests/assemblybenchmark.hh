@@ -0,0 +1,296 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Measures the throughput of the kernels which are used to linearize the system
+ *        of equations of a model.
+ *
+ * For an increasing number of threads, the number of elements per second is reported
+ * for the update of the intensive quantities, the update of the extensive quantities
+ * including the evaluation of the fluxes, the linearization of a single element by the
+ * local linearizer and the assembly of the global system of equations. All kernels are
+ * applied to the initial solution of the problem.
+ */
+#ifndef EWOMS_ASSEMBLY_BENCHMARK_HH
+#define EWOMS_ASSEMBLY_BENCHMARK_HH
+
+#include <opm/models/utils/start.hh>
+#include <opm/models/parallel/threadedelementscheduler.hh>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Opm::Properties {
+
+//! The number of times each kernel is applied to all elements of the grid
+template<class TypeTag, class MyTypeTag>
+struct BenchmarkRepetitions { using type = UndefinedProperty; };
+
+template<class TypeTag>
+struct BenchmarkRepetitions<TypeTag, TTag::NumericModel> { static constexpr unsigned value = 5; };
+
+} // namespace Opm::Properties
+
+namespace Opm {
+
+/*!
+ * \brief Measures the throughput of the kernels which are used to linearize the system
+ *        of equations of a model.
+ */
+template <class TypeTag>
+class AssemblyBenchmark
+{
+    using Simulator = GetPropType<TypeTag, Properties::Simulator>;
+    using ElementContext = GetPropType<TypeTag, Properties::ElementContext>;
+    using LocalResidual = GetPropType<TypeTag, Properties::LocalResidual>;
+    using ThreadManager = GetPropType<TypeTag, Properties::ThreadManager>;
+    using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using Element = typename GridView::template Codim<0>::Entity;
+    using ElementScheduler = ThreadedElementScheduler<GridView>;
+    using LocalEvalBlockVector = typename LocalResidual::LocalEvalBlockVector;
+    using Clock = std::chrono::high_resolution_clock;
+
+    enum { intensiveQuantitiesKernel, fluxesKernel, localLinearizationKernel,
+           globalAssemblyKernel, numKernels };
+
+    using KernelSeconds = std::array<double, numKernels>;
+
+public:
+    explicit AssemblyBenchmark(Simulator& simulator)
+        : simulator_(simulator)
+    {}
+
+    /*!
+     * \brief Apply all kernels for 1, 2, 4, ... and the maximum number of threads and
+     *        print the results.
+     */
+    void run(unsigned numRepetitions, std::ostream& os)
+    {
+        auto& model = simulator_.model();
+        numRepetitions = std::max(numRepetitions, 1u);
+
+        // make sure that the global Jacobian matrix has been allocated and that all
+        // caches have been populated before anything is measured
+        model.linearizer().linearizeDomain();
+
+        std::vector<unsigned> threadCounts;
+        for (unsigned n = 1; n < ThreadManager::maxThreads(); n *= 2)
+            threadCounts.push_back(n);
+        threadCounts.push_back(ThreadManager::maxThreads());
+
+        size_t numElements = model.elementScheduler().numInteriorElements();
+        os << "Benchmarking the linearization of the '" << simulator_.problem().name()
+           << "' problem: " << numElements << " elements, "
+           << numRepetitions << " repetitions\n"
+           << std::left << std::setw(22) << "kernel"
+           << std::right << std::setw(8) << "threads"
+           << std::setw(16) << "elements/s"
+           << std::setw(10) << "speedup" << "\n";
+
+        std::vector<KernelSeconds> results;
+        for (unsigned numThreads : threadCounts) {
+            KernelSeconds seconds = timeElementKernels_(numThreads, numRepetitions);
+            seconds[globalAssemblyKernel] = timeGlobalAssembly_(numThreads, numRepetitions);
+            results.push_back(seconds);
+        }
+
+        static const char* kernelNames[numKernels] =
+            { "intensiveQuantities", "fluxes", "localLinearization", "globalAssembly" };
+        for (unsigned kernelIdx = 0; kernelIdx < numKernels; ++kernelIdx) {
+            for (size_t i = 0; i < threadCounts.size(); ++i) {
+                double elementsPerSecond =
+                    numElements*numRepetitions/std::max(results[i][kernelIdx], 1e-30);
+                double speedup = results[0][kernelIdx]/std::max(results[i][kernelIdx], 1e-30);
+                os << std::left << std::setw(22) << kernelNames[kernelIdx]
+                   << std::right << std::setw(8) << threadCounts[i]
+                   << std::setw(16) << std::setprecision(4) << elementsPerSecond
+                   << std::setw(10) << std::setprecision(3) << speedup << "\n";
+            }
+        }
+        os << std::flush;
+    }
+
+private:
+    // apply the kernels which work on single elements. each kernel is timed separately
+    // by each thread and the time of the slowest thread is reported.
+    KernelSeconds timeElementKernels_(unsigned numThreads, unsigned numRepetitions)
+    {
+        auto& model = simulator_.model();
+        std::vector<KernelSeconds> threadSeconds(numThreads, KernelSeconds{});
+
+        std::mutex exceptionLock;
+        std::exception_ptr exceptionPtr = nullptr;
+        for (unsigned repIdx = 0; repIdx < numRepetitions && !exceptionPtr; ++repIdx) {
+            typename ElementScheduler::Loop elemLoop(model.elementScheduler(), numThreads);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(numThreads)
+#endif
+            {
+                // Attention: the variables below are thread specific and thus cannot be
+                // moved in front of the #pragma!
+                unsigned threadId = ThreadManager::threadId();
+                ElementContext elemCtx(simulator_);
+                LocalEvalBlockVector residual;
+                auto& localLinearizer = model.localLinearizer(threadId);
+                const auto& localResidual = model.localResidual(threadId);
+                KernelSeconds& seconds = threadSeconds[threadId];
+
+                try {
+                    elemLoop.forEach(threadId, [&](const Element& elem) {
+                        auto t0 = Clock::now();
+                        elemCtx.updateStencil(elem);
+                        elemCtx.updateAllIntensiveQuantities();
+
+                        auto t1 = Clock::now();
+                        elemCtx.updateAllExtensiveQuantities();
+                        residual.resize(elemCtx.numDof(/*timeIdx=*/0));
+                        residual = 0.0;
+                        localResidual.evalFluxes(residual, elemCtx, /*timeIdx=*/0);
+
+                        auto t2 = Clock::now();
+                        localLinearizer.linearize(elemCtx, elem);
+
+                        auto t3 = Clock::now();
+                        seconds[intensiveQuantitiesKernel] += seconds_(t0, t1);
+                        seconds[fluxesKernel] += seconds_(t1, t2);
+                        seconds[localLinearizationKernel] += seconds_(t2, t3);
+                    });
+                }
+                catch (...) {
+                    elemLoop.setFinished();
+
+                    std::lock_guard<std::mutex> take(exceptionLock);
+                    exceptionPtr = std::current_exception();
+                }
+            }
+        }
+
+        if (exceptionPtr)
+            std::rethrow_exception(exceptionPtr);
+
+        KernelSeconds result{};
+        for (const auto& seconds : threadSeconds)
+            for (unsigned kernelIdx = 0; kernelIdx < numKernels; ++kernelIdx)
+                result[kernelIdx] = std::max(result[kernelIdx], seconds[kernelIdx]);
+        return result;
+    }
+
+    // assemble the global system of equations, i.e., the element kernels plus the
+    // scatter into the global Jacobian matrix and the global residual
+    double timeGlobalAssembly_(unsigned numThreads, unsigned numRepetitions)
+    {
+#ifdef _OPENMP
+        omp_set_num_threads(static_cast<int>(numThreads));
+#endif
+        auto& linearizer = simulator_.model().linearizer();
+        auto start = Clock::now();
+        for (unsigned repIdx = 0; repIdx < numRepetitions; ++repIdx)
+            linearizer.linearizeDomain();
+        auto end = Clock::now();
+#ifdef _OPENMP
+        omp_set_num_threads(static_cast<int>(ThreadManager::maxThreads()));
+#endif
+
+        return seconds_(start, end);
+    }
+
+    static double seconds_(Clock::time_point start, Clock::time_point end)
+    { return std::chrono::duration<double>(end - start).count(); }
+
+    Simulator& simulator_;
+};
+
+/*!
+ * \brief Set up the simulator for a given type tag and benchmark the linearization of
+ *        its initial solution.
+ *
+ * \param argc The number of command line arguments
+ * \param argv Array with the command line argument strings
+ */
+template <class TypeTag>
+int runAssemblyBenchmark(int argc, char **argv)
+{
+    using Simulator = GetPropType<TypeTag, Properties::Simulator>;
+    using ThreadManager = GetPropType<TypeTag, Properties::ThreadManager>;
+
+    int myRank = 0;
+    try {
+        registerAllParameters_<TypeTag>(/*finalizeRegistration=*/false);
+        EWOMS_REGISTER_PARAM(TypeTag, unsigned, BenchmarkRepetitions,
+                             "The number of times each kernel is applied to all elements");
+        EWOMS_END_PARAM_REGISTRATION(TypeTag);
+
+        int paramStatus = setupParameters_<TypeTag>(argc,
+                                                    const_cast<const char**>(argv),
+                                                    /*registerParams=*/false);
+        if (paramStatus == 1)
+            return 1;
+        if (paramStatus == 2)
+            return 0;
+
+        ThreadManager::init();
+
+        // initialize MPI, finalize is done automatically on exit
+#if HAVE_DUNE_FEM
+        Dune::Fem::MPIManager::initialize(argc, argv);
+        myRank = Dune::Fem::MPIManager::rank();
+#else
+        myRank = Dune::MPIHelper::instance(argc, argv).rank();
+#endif
+
+        Simulator simulator;
+        simulator.model().applyInitialSolution();
+
+        // all processes run the benchmark, but only the first one reports the results
+        std::ostringstream report;
+        AssemblyBenchmark<TypeTag> benchmark(simulator);
+        benchmark.run(EWOMS_GET_PARAM(TypeTag, unsigned, BenchmarkRepetitions), report);
+        if (myRank == 0)
+            std::cout << report.str() << std::flush;
+
+        return 0;
+    }
+    catch (std::exception& e) {
+        if (myRank == 0)
+            std::cout << e.what() << ". Abort!\n" << std::flush;
+
+        return 1;
+    }
+}
+
+} // namespace Opm
+
+#endif
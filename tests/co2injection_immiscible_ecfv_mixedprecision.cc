@@ -0,0 +1,67 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Test for the isothermal immiscible model using the CO2 injection example
+ *        problem and an AMG preconditioner which is stored in single precision
+ */
+#include "config.h"
+
+#include <opm/models/utils/start.hh>
+#include <opm/models/immiscible/immisciblemodel.hh>
+#include <opm/models/discretization/ecfv/ecfvdiscretization.hh>
+
+#include "problems/co2injectionproblem.hh"
+
+namespace Opm::Properties {
+
+namespace TTag {
+
+struct Co2InjectionImmiscibleEcfvMixedPrecisionProblem
+{ using InheritsFrom = std::tuple<Co2InjectionBaseProblem, ImmiscibleModel>; };
+
+} // end namespace TTag
+
+template<class TypeTag>
+struct SpatialDiscretizationSplice<TypeTag, TTag::Co2InjectionImmiscibleEcfvMixedPrecisionProblem>
+{ using type = TTag::EcfvDiscretization; };
+
+// the linear solver uses double precision, the AMG hierarchy is stored using floats
+template<class TypeTag>
+struct LinearSolverScalar<TypeTag, TTag::Co2InjectionImmiscibleEcfvMixedPrecisionProblem>
+{ using type = double; };
+template<class TypeTag>
+struct PreconditionerScalar<TypeTag, TTag::Co2InjectionImmiscibleEcfvMixedPrecisionProblem>
+{ using type = float; };
+
+} // namespace Opm::Properties
+
+////////////////////////
+// the main function
+////////////////////////
+int main(int argc, char **argv)
+{
+    using ProblemTypeTag = Opm::Properties::TTag::Co2InjectionImmiscibleEcfvMixedPrecisionProblem;
+    return Opm::start<ProblemTypeTag>(argc, argv);
+}
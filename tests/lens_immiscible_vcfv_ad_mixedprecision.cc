@@ -0,0 +1,59 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Two-phase test for the immiscible model which uses the vertex-centered finite
+ *        volume discretization and a preconditioner which is stored in single precision
+ */
+#include "config.h"
+
+#include <opm/models/utils/start.hh>
+#include <opm/models/immiscible/immisciblemodel.hh>
+#include "problems/lensproblem.hh"
+
+namespace Opm::Properties {
+
+// Create new type tags
+namespace TTag {
+struct LensProblemVcfvAdMixedPrecision { using InheritsFrom = std::tuple<LensBaseProblem, ImmiscibleTwoPhaseModel>; };
+} // end namespace TTag
+
+// use automatic differentiation for this simulator
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::LensProblemVcfvAdMixedPrecision> { using type = TTag::AutoDiffLocalLinearizer; };
+
+// the linear solver uses double precision, the preconditioner is set up and applied
+// using floats
+template<class TypeTag>
+struct LinearSolverScalar<TypeTag, TTag::LensProblemVcfvAdMixedPrecision> { using type = double; };
+template<class TypeTag>
+struct PreconditionerScalar<TypeTag, TTag::LensProblemVcfvAdMixedPrecision> { using type = float; };
+
+} // namespace Opm::Properties
+
+int main(int argc, char **argv)
+{
+    using ProblemTypeTag = Opm::Properties::TTag::LensProblemVcfvAdMixedPrecision;
+    return Opm::start<ProblemTypeTag>(argc, argv);
+}
@@ -0,0 +1,99 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Two-phase test for the immiscible model which uses the vertex-centered finite
+ *        volume discretization and only writes a region of interest.
+ */
+#include "config.h"
+
+#include <opm/models/utils/start.hh>
+#include <opm/models/immiscible/immisciblemodel.hh>
+#include "problems/lensproblem.hh"
+
+#include <functional>
+
+namespace Opm {
+template <class TypeTag>
+class LensOutputRegionProblem;
+}
+
+namespace Opm::Properties {
+
+// Create new type tags
+namespace TTag {
+struct LensProblemVcfvAdOutputRegion { using InheritsFrom = std::tuple<LensBaseProblem, ImmiscibleTwoPhaseModel>; };
+} // end namespace TTag
+
+// Set the problem property
+template<class TypeTag>
+struct Problem<TypeTag, TTag::LensProblemVcfvAdOutputRegion> { using type = Opm::LensOutputRegionProblem<TypeTag>; };
+
+// use automatic differentiation for this simulator
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::LensProblemVcfvAdOutputRegion> { using type = TTag::AutoDiffLocalLinearizer; };
+
+// a region of interest requires that the geometry of the grid is only encoded once
+template<class TypeTag>
+struct EnableVtkStaticGrid<TypeTag, TTag::LensProblemVcfvAdOutputRegion> { static constexpr bool value = true; };
+
+} // namespace Opm::Properties
+
+namespace Opm {
+/*!
+ * \brief The lens problem, but only the left half of the domain is written to disk.
+ *
+ * The region cuts through the lens, so the vertices on its boundary are shared by
+ * written and by omitted elements.
+ */
+template <class TypeTag>
+class LensOutputRegionProblem : public LensProblem<TypeTag>
+{
+    using ParentType = LensProblem<TypeTag>;
+
+    using Simulator = GetPropType<TypeTag, Properties::Simulator>;
+    using GridView = GetPropType<TypeTag, Properties::GridView>;
+    using Element = typename GridView::template Codim<0>::Entity;
+
+public:
+    LensOutputRegionProblem(Simulator& simulator)
+        : ParentType(simulator)
+    {}
+
+    /*!
+     * \copydoc FvBaseProblem::outputRegion
+     */
+    std::function<bool(const Element&)> outputRegion() const
+    {
+        double xMid = 0.5*(this->boundingBoxMin()[0] + this->boundingBoxMax()[0]);
+        return [xMid](const Element& elem) { return elem.geometry().center()[0] < xMid; };
+    }
+};
+} // namespace Opm
+
+int main(int argc, char **argv)
+{
+    using ProblemTypeTag = Opm::Properties::TTag::LensProblemVcfvAdOutputRegion;
+    return Opm::start<ProblemTypeTag>(argc, argv);
+}
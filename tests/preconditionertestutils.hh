@@ -0,0 +1,128 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief Helpers which are shared by the tests of the sequential preconditioners.
+ *
+ * They assemble a non-symmetric block matrix on a structured grid and solve a linear
+ * system using the BiCGStab solver with a given preconditioner.
+ */
+#ifndef EWOMS_PRECONDITIONER_TEST_UTILS_HH
+#define EWOMS_PRECONDITIONER_TEST_UTILS_HH
+
+#include <opm/simulators/linalg/bicgstabsolver.hh>
+#include <opm/simulators/linalg/residreductioncriterion.hh>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/scalarproducts.hh>
+
+#include <cstddef>
+#include <iostream>
+
+static constexpr int blockSize = 3;
+using Matrix = Dune::BCRSMatrix<Dune::FieldMatrix<double, blockSize, blockSize> >;
+using Vector = Dune::BlockVector<Dune::FieldVector<double, blockSize> >;
+
+// assemble a non-symmetric matrix with the pattern of a five point stencil on a
+// structured two-dimensional grid
+inline void createMatrix(Matrix& A, size_t nx, size_t ny)
+{
+    size_t numBlocks = nx*ny;
+    A.setSize(numBlocks, numBlocks, 5*numBlocks);
+    A.setBuildMode(Matrix::row_wise);
+    for (auto row = A.createbegin(); row != A.createend(); ++row) {
+        size_t rowIdx = row.index();
+        size_t i = rowIdx % nx;
+        size_t j = rowIdx / nx;
+        if (j > 0)
+            row.insert(rowIdx - nx);
+        if (i > 0)
+            row.insert(rowIdx - 1);
+        row.insert(rowIdx);
+        if (i < nx - 1)
+            row.insert(rowIdx + 1);
+        if (j < ny - 1)
+            row.insert(rowIdx + nx);
+    }
+
+    for (size_t rowIdx = 0; rowIdx < numBlocks; ++rowIdx) {
+        for (auto colIt = A[rowIdx].begin(); colIt != A[rowIdx].end(); ++colIt) {
+            auto& block = *colIt;
+            for (int k = 0; k < blockSize; ++k) {
+                for (int l = 0; l < blockSize; ++l) {
+                    if (colIt.index() == rowIdx)
+                        block[k][l] = (k == l) ? 8.0 : 0.1*(k - l);
+                    else if (colIt.index() < rowIdx)
+                        block[k][l] = (k == l) ? -1.3 : 0.05;
+                    else
+                        block[k][l] = (k == l) ? -0.7 : -0.05;
+                }
+            }
+        }
+    }
+}
+
+template <class Preconditioner>
+bool solve(const Matrix& A, const Vector& b, Preconditioner& precond, const char* name)
+{
+    using Operator = Dune::MatrixAdapter<Matrix, Vector, Vector>;
+    using ScalarProduct = Dune::SeqScalarProduct<Vector>;
+    using Solver = Opm::Linear::BiCGStabSolver<Operator, Vector, Preconditioner, ScalarProduct>;
+
+    Operator op(A);
+    ScalarProduct scalarProduct;
+    Opm::Linear::ResidReductionCriterion<Vector> convCrit(scalarProduct, /*tolerance=*/1e-10);
+
+    Solver solver(precond, convCrit, scalarProduct);
+    solver.setMaxIterations(500);
+    solver.setVerbosity(0);
+    solver.setLinearOperator(&op);
+    solver.setRhs(&b);
+
+    Vector x(b.size());
+    x = 0.0;
+    if (!solver.apply(x)) {
+        std::cerr << "BiCGStab did not converge using the " << name << " preconditioner\n";
+        return false;
+    }
+
+    // the accuracy of the solution must not be limited by the preconditioner, e.g., if
+    // it uses a lower precision than the solver
+    Vector r(b);
+    A.mmv(x, r);
+    if (r.two_norm() > 1e-9*b.two_norm()) {
+        std::cerr << "Inaccurate solution using the " << name << " preconditioner\n";
+        return false;
+    }
+
+    std::cout << name << ": " << solver.report().iterations() << " iterations, "
+              << solver.report().timer().realTimeElapsed() << " seconds\n";
+    return true;
+}
+
+#endif
@@ -0,0 +1,176 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the BiCGStab linear solver and measures the cost of its
+ *        iterations for different block sizes.
+ *
+ * The same system of equations is solved using a scalar product which computes each
+ * dot product separately and one which fuses dot products with a common operand.
+ */
+#include "config.h"
+
+#include <opm/simulators/linalg/bicgstabsolver.hh>
+#include <opm/simulators/linalg/residreductioncriterion.hh>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/version.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/scalarproducts.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// a sequential scalar product which is able to compute two dot products at once
+template <class Vector>
+class FusedScalarProduct : public Dune::SeqScalarProduct<Vector>
+{
+public:
+    using field_type = typename Vector::field_type;
+
+    void dot(const Vector& x, const Vector& y1, const Vector& y2,
+             field_type& xy1, field_type& xy2) const
+    {
+        xy1 = 0.0;
+        xy2 = 0.0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            xy1 += x[i]*y1[i];
+            xy2 += x[i]*y2[i];
+        }
+    }
+
+    using Dune::SeqScalarProduct<Vector>::dot;
+};
+
+// assemble a non-symmetric, diagonally dominant block tridiagonal matrix
+template <class Matrix>
+void createMatrix(Matrix& A, size_t numBlocks)
+{
+    static constexpr int blockSize = Matrix::block_type::rows;
+
+    A.setSize(numBlocks, numBlocks, 3*numBlocks);
+    A.setBuildMode(Matrix::row_wise);
+    for (auto row = A.createbegin(); row != A.createend(); ++row) {
+        size_t rowIdx = row.index();
+        if (rowIdx > 0)
+            row.insert(rowIdx - 1);
+        row.insert(rowIdx);
+        if (rowIdx < numBlocks - 1)
+            row.insert(rowIdx + 1);
+    }
+
+    for (size_t rowIdx = 0; rowIdx < numBlocks; ++rowIdx) {
+        for (auto colIt = A[rowIdx].begin(); colIt != A[rowIdx].end(); ++colIt) {
+            auto& block = *colIt;
+            block = 0.0;
+            for (int i = 0; i < blockSize; ++i) {
+                for (int j = 0; j < blockSize; ++j) {
+                    if (colIt.index() == rowIdx)
+                        block[i][j] = (i == j) ? 4.0*blockSize : 0.1*(i - j);
+                    else if (colIt.index() < rowIdx)
+                        block[i][j] = -1.2;
+                    else
+                        block[i][j] = -0.8;
+                }
+            }
+        }
+    }
+}
+
+template <class Vector, class ScalarProduct, class Matrix>
+bool solve(const Matrix& A, const Vector& b, const char* name, int blockSize)
+{
+    using Operator = Dune::MatrixAdapter<Matrix, Vector, Vector>;
+    using Preconditioner = Dune::Richardson<Vector, Vector>;
+    using Solver = Opm::Linear::BiCGStabSolver<Operator, Vector, Preconditioner, ScalarProduct>;
+
+    Operator op(A);
+    Preconditioner precond(/*relaxationFactor=*/1.0);
+    ScalarProduct scalarProduct;
+    Opm::Linear::ResidReductionCriterion<Vector> convCrit(scalarProduct, /*tolerance=*/1e-10);
+
+    Solver solver(precond, convCrit, scalarProduct);
+    solver.setMaxIterations(500);
+    solver.setVerbosity(0);
+    solver.setLinearOperator(&op);
+    solver.setRhs(&b);
+
+    Vector x(b.size());
+    if (!solver.apply(x)) {
+        std::cerr << "BiCGStab did not converge for block size " << blockSize << "\n";
+        return false;
+    }
+
+    // check the solution
+    Vector r(b);
+    A.mmv(x, r);
+    if (r.two_norm() > 1e-8*b.two_norm()) {
+        std::cerr << "Wrong solution for block size " << blockSize << "\n";
+        return false;
+    }
+
+    const auto& report = solver.report();
+    std::cout << "block size " << blockSize << ", " << name << ": "
+              << report.iterations() << " iterations, "
+              << 1e3*report.timer().realTimeElapsed()/std::max<size_t>(report.iterations(), 1)
+              << " ms per iteration\n";
+    return true;
+}
+
+template <int blockSize>
+bool testBlockSize(size_t numBlocks)
+{
+    using MatrixBlock = Dune::FieldMatrix<double, blockSize, blockSize>;
+    using Matrix = Dune::BCRSMatrix<MatrixBlock>;
+    using Vector = Dune::BlockVector<Dune::FieldVector<double, blockSize> >;
+
+    Matrix A;
+    createMatrix(A, numBlocks);
+
+    Vector b(numBlocks);
+    for (size_t i = 0; i < numBlocks; ++i)
+        for (int j = 0; j < blockSize; ++j)
+            b[i][j] = std::sin(0.01*(i*blockSize + j));
+
+    return solve<Vector, Dune::SeqScalarProduct<Vector> >(A, b, "separate dot products", blockSize)
+        && solve<Vector, FusedScalarProduct<Vector> >(A, b, "fused dot products", blockSize);
+}
+
+int main()
+{
+    size_t numBlocks = 200000;
+    bool ok =
+        testBlockSize<2>(numBlocks)
+        && testBlockSize<3>(numBlocks)
+        && testBlockSize<4>(numBlocks)
+        && testBlockSize<5>(numBlocks)
+        && testBlockSize<6>(numBlocks);
+
+    return ok ? 0 : 1;
+}
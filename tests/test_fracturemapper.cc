@@ -0,0 +1,92 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the tables which store the topology of the fractures of the
+ *        discrete fracture model.
+ */
+#include "config.h"
+
+#include <opm/models/discretefracture/fracturemapper.hh>
+
+#include <iostream>
+
+int main()
+{
+    using FractureMapper = Opm::FractureMapper</*TypeTag=*/void>;
+
+    // a mapper without any fractures must not report any
+    FractureMapper emptyMapper;
+    if (emptyMapper.isFractureVertex(0) || emptyMapper.isFractureEdge(0, 1)) {
+        std::cerr << "The empty fracture mapper reports a fracture\n";
+        return 1;
+    }
+
+    // a chain of fracture edges 0-1-2-3 on a structured grid of 4x4 vertices. the
+    // edge 1-2 is added twice and in both directions
+    FractureMapper mapper;
+    mapper.addFractureEdge(0, 1);
+    mapper.addFractureEdge(1, 2);
+    mapper.addFractureEdge(2, 1);
+    mapper.addFractureEdge(3, 2);
+    mapper.finalize(/*numVertices=*/16);
+
+    if (mapper.numFractureEdges() != 3) {
+        std::cerr << "Wrong number of fracture edges: " << mapper.numFractureEdges() << "\n";
+        return 1;
+    }
+
+    for (unsigned vertexIdx = 0; vertexIdx < 16; ++vertexIdx) {
+        if (mapper.isFractureVertex(vertexIdx) != (vertexIdx < 4)) {
+            std::cerr << "Vertex " << vertexIdx << " is wrongly classified\n";
+            return 1;
+        }
+    }
+
+    if (!mapper.isFractureEdge(1, 0) || !mapper.isFractureEdge(2, 3)
+        || mapper.isFractureEdge(0, 2) || mapper.isFractureEdge(0, 4)
+        || mapper.isFractureEdge(1, 1) || mapper.isFractureEdge(17, 1))
+    {
+        std::cerr << "Fracture edges are wrongly classified\n";
+        return 1;
+    }
+
+    if (mapper.numFractureNeighbors(1) != 2
+        || mapper.fractureNeighbor(1, 0) != 0
+        || mapper.fractureNeighbor(1, 1) != 2)
+    {
+        std::cerr << "Wrong fracture neighbors of vertex 1\n";
+        return 1;
+    }
+
+    // edges which are added later must be merged with the existing ones
+    mapper.addFractureEdge(3, 7);
+    mapper.finalize(/*numVertices=*/16);
+    if (mapper.numFractureEdges() != 4 || !mapper.isFractureEdge(7, 3) || !mapper.isFractureEdge(0, 1)) {
+        std::cerr << "Fracture edges were not merged correctly\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the lock-free linearization which uses a coloring of the
+ *        elements.
+ *
+ * The global residual and the Jacobian matrix of the lens problem are assembled once
+ * using the locked and once using the coloring based linearization. Both must agree
+ * up to the rounding errors caused by the different order of summation.
+ */
+#include "config.h"
+
+#include "lens_immiscible_ecfv_ad.hh"
+
+#include <opm/models/utils/start.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace Opm::Properties {
+
+namespace TTag {
+struct LensProblemEcfvAdColored { using InheritsFrom = std::tuple<LensProblemEcfvAd>; };
+
+struct LensProblemVcfvAd { using InheritsFrom = std::tuple<LensBaseProblem, ImmiscibleTwoPhaseModel>; };
+struct LensProblemVcfvAdColored { using InheritsFrom = std::tuple<LensProblemVcfvAd>; };
+} // end namespace TTag
+
+template<class TypeTag>
+struct LocalLinearizerSplice<TypeTag, TTag::LensProblemVcfvAd> { using type = TTag::AutoDiffLocalLinearizer; };
+
+template<class TypeTag>
+struct UseLinearizationColoring<TypeTag, TTag::LensProblemEcfvAdColored> { static constexpr bool value = true; };
+template<class TypeTag>
+struct UseLinearizationColoring<TypeTag, TTag::LensProblemVcfvAdColored> { static constexpr bool value = true; };
+
+} // namespace Opm::Properties
+
+// the linearized system of equations in a format which does not depend on the type tag
+struct LinearSystem
+{
+    std::vector<size_t> rowOffsets;
+    std::vector<size_t> columns;
+    std::vector<double> entries;
+    std::vector<double> residual;
+};
+
+template <class TypeTag>
+static LinearSystem linearizeInitialSolution(int argc, const char **argv)
+{
+    using Simulator = Opm::GetPropType<TypeTag, Opm::Properties::Simulator>;
+    using ThreadManager = Opm::GetPropType<TypeTag, Opm::Properties::ThreadManager>;
+
+    if (Opm::setupParameters_<TypeTag>(argc, argv) != 0)
+        throw std::runtime_error("Could not set up the parameters");
+    ThreadManager::init();
+
+    Simulator simulator;
+    simulator.model().applyInitialSolution();
+
+    auto& linearizer = simulator.model().linearizer();
+    linearizer.linearizeDomain();
+
+    LinearSystem result;
+    const auto& jacobian = linearizer.jacobian().istlMatrix();
+    result.rowOffsets.push_back(0);
+    for (auto rowIt = jacobian.begin(); rowIt != jacobian.end(); ++rowIt) {
+        for (auto colIt = rowIt->begin(); colIt != rowIt->end(); ++colIt) {
+            const auto& block = *colIt;
+            for (unsigned i = 0; i < block.rows; ++i) {
+                for (unsigned j = 0; j < block.cols; ++j) {
+                    result.columns.push_back(colIt.index()*block.cols + j);
+                    result.entries.push_back(static_cast<double>(block[i][j]));
+                }
+            }
+        }
+        result.rowOffsets.push_back(result.entries.size());
+    }
+
+    for (const auto& block : linearizer.residual())
+        for (unsigned i = 0; i < block.size(); ++i)
+            result.residual.push_back(static_cast<double>(block[i]));
+
+    return result;
+}
+
+// compare two linearizations. the entries of a block row are considered to be equal if
+// they differ by less than a small fraction of the largest entry of the block row.
+static bool compare(const LinearSystem& locked, const LinearSystem& colored, const char* name)
+{
+    const double tolerance = 1e-10;
+
+    if (locked.rowOffsets != colored.rowOffsets || locked.columns != colored.columns) {
+        std::cerr << name << ": the sparsity patterns of the Jacobian matrices differ\n";
+        return false;
+    }
+
+    for (size_t rowIdx = 0; rowIdx + 1 < locked.rowOffsets.size(); ++rowIdx) {
+        double scale = 0.0;
+        for (size_t k = locked.rowOffsets[rowIdx]; k < locked.rowOffsets[rowIdx + 1]; ++k)
+            scale = std::max(scale, std::abs(locked.entries[k]));
+
+        for (size_t k = locked.rowOffsets[rowIdx]; k < locked.rowOffsets[rowIdx + 1]; ++k) {
+            if (std::abs(locked.entries[k] - colored.entries[k]) > tolerance*scale) {
+                std::cerr << name << ": the Jacobian matrices differ in block row " << rowIdx
+                          << ": " << locked.entries[k] << " != " << colored.entries[k] << "\n";
+                return false;
+            }
+        }
+    }
+
+    if (locked.residual.size() != colored.residual.size()) {
+        std::cerr << name << ": the sizes of the residuals differ\n";
+        return false;
+    }
+
+    double scale = 0.0;
+    for (double value : locked.residual)
+        scale = std::max(scale, std::abs(value));
+    for (size_t i = 0; i < locked.residual.size(); ++i) {
+        if (std::abs(locked.residual[i] - colored.residual[i]) > tolerance*scale) {
+            std::cerr << name << ": the residuals differ at index " << i
+                      << ": " << locked.residual[i] << " != " << colored.residual[i] << "\n";
+            return false;
+        }
+    }
+
+    std::cout << name << ": the locked and the colored linearizations agree\n";
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    // use multiple threads to make sure that the locked and the coloring based code
+    // paths are actually concurrent
+    const char *params[] = { argv[0],
+                             "--threads-per-process=4",
+                             "--end-time=1000",
+                             "--initial-time-step-size=100",
+                             "--enable-vtk-output=false" };
+    const int numParams = sizeof(params)/sizeof(params[0]);
+
+#if HAVE_DUNE_FEM
+    Dune::Fem::MPIManager::initialize(argc, argv);
+#else
+    Dune::MPIHelper::instance(argc, argv);
+#endif
+
+    try {
+        using namespace Opm::Properties::TTag;
+        bool ok =
+            compare(linearizeInitialSolution<LensProblemEcfvAd>(numParams, params),
+                    linearizeInitialSolution<LensProblemEcfvAdColored>(numParams, params),
+                    "ECFV")
+            && compare(linearizeInitialSolution<LensProblemVcfvAd>(numParams, params),
+                       linearizeInitialSolution<LensProblemVcfvAdColored>(numParams, params),
+                       "VCFV");
+
+        return ok ? 0 : 1;
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,107 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests applying a preconditioner which stores its matrix in single
+ *        precision within a linear solver which uses double precision.
+ *
+ * The BiCGStab solver must converge to the same accuracy as if the preconditioner is
+ * stored in double precision, and the converted matrix must be refreshed correctly if
+ * the values of the original matrix change.
+ */
+#include "config.h"
+
+#include "preconditionertestutils.hh"
+
+#include <opm/simulators/linalg/mixedprecisionpreconditioner.hh>
+
+#include <dune/common/version.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+using FloatMatrix = Dune::BCRSMatrix<Dune::FieldMatrix<float, blockSize, blockSize> >;
+using FloatVector = Dune::BlockVector<Dune::FieldVector<float, blockSize> >;
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,7)
+template <class M, class V>
+using SeqILU0 = Dune::SeqILU<M, V, V>;
+#else
+template <class M, class V>
+using SeqILU0 = Dune::SeqILU0<M, V, V>;
+#endif
+
+int main()
+{
+    Matrix A;
+    createMatrix(A, /*nx=*/300, /*ny=*/200);
+
+    Vector b(A.N());
+    for (size_t i = 0; i < b.size(); ++i)
+        for (int j = 0; j < blockSize; ++j)
+            b[i][j] = std::sin(0.01*(i*blockSize + j));
+
+    std::unique_ptr<FloatMatrix> floatA;
+    Opm::Linear::convertMatrix(floatA, A);
+    if (floatA->N() != A.N() || floatA->nonzeroes() != A.nonzeroes()) {
+        std::cerr << "The converted matrix exhibits the wrong pattern\n";
+        return 1;
+    }
+
+    // converting the values of a changed matrix must not recreate the pattern
+    const FloatMatrix* oldFloatA = floatA.get();
+    A[0][0][0][0] = 9.0;
+    Opm::Linear::convertMatrix(floatA, A);
+    if (floatA.get() != oldFloatA || (*floatA)[0][0][0][0] != 9.0f) {
+        std::cerr << "The values of the converted matrix were not updated correctly\n";
+        return 1;
+    }
+
+    SeqILU0<Matrix, Vector> doubleIlu(A, /*relaxationFactor=*/1.0);
+    SeqILU0<FloatMatrix, FloatVector> floatIlu(*floatA, /*relaxationFactor=*/1.0);
+    Opm::Linear::MixedPrecisionPreconditioner<SeqILU0<FloatMatrix, FloatVector>, Vector>
+        mixedIlu(floatIlu);
+
+    // a single application must agree up to single precision
+    Vector doubleResult(b.size());
+    Vector mixedResult(b.size());
+    doubleResult = 0.0;
+    mixedResult = 0.0;
+    Vector d(b);
+    doubleIlu.apply(doubleResult, d);
+    mixedIlu.apply(mixedResult, b);
+    mixedResult -= doubleResult;
+    if (mixedResult.two_norm() > 1e-5*doubleResult.two_norm()) {
+        std::cerr << "The single precision ILU(0) differs too much from the double precision one\n";
+        return 1;
+    }
+
+    bool ok =
+        solve(A, b, doubleIlu, "double precision ILU(0)")
+        && solve(A, b, mixedIlu, "single precision ILU(0)");
+
+    return ok ? 0 : 1;
+}
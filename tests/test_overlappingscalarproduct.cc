@@ -0,0 +1,132 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the overlap aware scalar product which is used by the
+ *        parallel linear solver backends.
+ *
+ * The dot products which are computed separately and the fused ones must agree with
+ * a sequentially computed reference, including the case that the local part of the
+ * scalar products is computed by multiple threads.
+ */
+#include "config.h"
+
+#include <opm/simulators/linalg/overlappingbcrsmatrix.hh>
+#include <opm/simulators/linalg/overlappingblockvector.hh>
+#include <opm/simulators/linalg/overlappingscalarproduct.hh>
+
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/istl/bcrsmatrix.hh>
+
+#include <cmath>
+#include <iostream>
+
+// compares a dot product with its reference value
+template <class Scalar>
+static bool checkDot(Scalar value, Scalar reference, const char* name, size_t numBlocks)
+{
+    if (std::abs(value - reference) > 1e-12*std::abs(reference)) {
+        std::cerr << "Wrong value of " << name << " for " << numBlocks << " blocks: "
+                  << value << " instead of " << reference << "\n";
+        return false;
+    }
+    return true;
+}
+
+template <int blockSize>
+bool testBlockSize(size_t numBlocks)
+{
+    using MatrixBlock = Dune::FieldMatrix<double, blockSize, blockSize>;
+    using NativeMatrix = Dune::BCRSMatrix<MatrixBlock>;
+    using OverlappingMatrix = Opm::Linear::OverlappingBCRSMatrix<NativeMatrix>;
+    using Overlap = typename OverlappingMatrix::Overlap;
+    using Vector = Opm::Linear::OverlappingBlockVector<Dune::FieldVector<double, blockSize>, Overlap>;
+    using ScalarProduct = Opm::Linear::OverlappingScalarProduct<Vector, Overlap>;
+
+    // the overlap is derived from the sparsity pattern of a block tridiagonal matrix
+    NativeMatrix nativeA;
+    nativeA.setSize(numBlocks, numBlocks, 3*numBlocks);
+    nativeA.setBuildMode(NativeMatrix::row_wise);
+    for (auto row = nativeA.createbegin(); row != nativeA.createend(); ++row) {
+        size_t rowIdx = row.index();
+        if (rowIdx > 0)
+            row.insert(rowIdx - 1);
+        row.insert(rowIdx);
+        if (rowIdx < numBlocks - 1)
+            row.insert(rowIdx + 1);
+    }
+    nativeA = 0.0;
+
+    Opm::Linear::BorderList borderList;
+    Opm::Linear::BlackList blackList;
+    OverlappingMatrix A(nativeA, borderList, blackList, /*overlapSize=*/2);
+    const Overlap& overlap = A.overlap();
+
+    Vector x(overlap);
+    Vector y1(overlap);
+    Vector y2(overlap);
+    double refXy1 = 0.0;
+    double refXy2 = 0.0;
+    double refXx = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        for (int j = 0; j < blockSize; ++j) {
+            size_t k = i*blockSize + j;
+            x[i][j] = std::sin(0.01*k);
+            y1[i][j] = std::cos(0.02*k);
+            y2[i][j] = 1.0/(1.0 + k);
+
+            refXy1 += x[i][j]*y1[i][j];
+            refXy2 += x[i][j]*y2[i][j];
+            refXx += x[i][j]*x[i][j];
+        }
+    }
+
+    ScalarProduct scalarProduct(overlap);
+    double xy1;
+    double xy2;
+    scalarProduct.dot(x, y1, y2, xy1, xy2);
+
+    return checkDot(xy1, refXy1, "the first fused dot product", numBlocks)
+        && checkDot(xy2, refXy2, "the second fused dot product", numBlocks)
+        && checkDot(scalarProduct.dot(x, y1), refXy1, "the dot product", numBlocks)
+        && checkDot(scalarProduct.norm(x), std::sqrt(refXx), "the norm", numBlocks);
+}
+
+int main(int argc, char** argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    // small vectors are processed by a single thread, large ones by all threads
+    bool ok = true;
+    for (size_t numBlocks : {10, 100000}) {
+        ok = ok
+            && testBlockSize<1>(numBlocks)
+            && testBlockSize<3>(numBlocks)
+            && testBlockSize<5>(numBlocks);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the cache for the values of run-time parameters.
+ *
+ * It checks that the cached values are invalidated whenever the parameters may have
+ * changed and compares the cost of retrieving a parameter with and without the cache.
+ */
+#include "config.h"
+
+#include <opm/models/utils/parametersystem.hh>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+namespace Opm::Properties {
+
+namespace TTag {
+struct ParamTest { using InheritsFrom = std::tuple<ParameterSystem>; };
+} // namespace TTag
+
+template<class TypeTag, class MyTypeTag>
+struct SomeTolerance { using type = UndefinedProperty; };
+template<class TypeTag, class MyTypeTag>
+struct SomeMethod { using type = UndefinedProperty; };
+
+template<class TypeTag>
+struct SomeTolerance<TypeTag, TTag::ParamTest> { static constexpr double value = 1e-7; };
+template<class TypeTag>
+struct SomeMethod<TypeTag, TTag::ParamTest> { static constexpr int value = 1; };
+
+} // namespace Opm::Properties
+
+using namespace Opm;
+using TypeTag = Properties::TTag::ParamTest;
+
+static void registerParameters()
+{
+    EWOMS_REGISTER_PARAM(TypeTag, double, SomeTolerance, "Some tolerance.");
+    EWOMS_REGISTER_PARAM(TypeTag, int, SomeMethod, "Some method.");
+    EWOMS_END_PARAM_REGISTRATION(TypeTag);
+}
+
+template <class Fn>
+static double measure(unsigned numCalls, Fn&& fn)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    double sum = 0.0;
+    for (unsigned i = 0; i < numCalls; ++i)
+        sum += fn();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    // make sure that the loop is not optimized away
+    if (sum < 0.0)
+        std::cout << sum;
+
+    return std::chrono::duration<double, std::nano>(end - start).count()/numCalls;
+}
+
+int main(int, char **argv)
+{
+    registerParameters();
+
+    // nothing was specified, so the default must be returned
+    if (EWOMS_GET_PARAM(TypeTag, int, SomeMethod) != 1) {
+        std::cerr << "Wrong default value for parameter SomeMethod\n";
+        return 1;
+    }
+
+    // specifying the parameter must invalidate the cached value
+    const char *testArgv[] = { argv[0], "--some-method=2", "--some-tolerance=1e-3" };
+    std::string errorMsg =
+        Parameters::parseCommandLineOptions<TypeTag>(3, testArgv, /*helpPreamble=*/"",
+                                                     Parameters::noPositionalParameters_);
+    if (!errorMsg.empty()) {
+        std::cerr << "Could not parse the command line: " << errorMsg << "\n";
+        return 1;
+    }
+    if (EWOMS_GET_PARAM(TypeTag, int, SomeMethod) != 2
+        || EWOMS_GET_PARAM(TypeTag, double, SomeTolerance) != 1e-3)
+    {
+        std::cerr << "Cached parameter value was not updated\n";
+        return 1;
+    }
+
+    // compare the cost of retrieving the parameter with and without cache
+    unsigned numCalls = 1000000;
+    double uncachedNs = measure(numCalls, [] {
+        return Parameters::get<TypeTag, double>("SomeTolerance",
+                                                "SomeTolerance",
+                                                getPropValue<TypeTag, Properties::SomeTolerance>());
+    });
+    double cachedNs = measure(numCalls, [] {
+        return EWOMS_GET_PARAM(TypeTag, double, SomeTolerance);
+    });
+    std::cout << "Retrieving a parameter takes " << uncachedNs << " ns without and "
+              << cachedNs << " ns with the cache\n";
+
+    // after resetting the parameters, the cached values must not be used anymore
+    Parameters::reset<TypeTag>();
+    registerParameters();
+    if (EWOMS_GET_PARAM(TypeTag, int, SomeMethod) != 1
+        || EWOMS_GET_PARAM(TypeTag, double, SomeTolerance) != 1e-7)
+    {
+        std::cerr << "Cached parameter value survived resetting the parameters\n";
+        return 1;
+    }
+
+    return 0;
+}
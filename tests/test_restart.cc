@@ -0,0 +1,211 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests writing and reading restart files.
+ *
+ * It checks that the data written by serializers is restored exactly, also if the files
+ * are written in the background, and that corrupted files or files for a different
+ * simulation are rejected.
+ */
+#include "config.h"
+
+#include <opm/models/io/asyncrestartwriter.hh>
+#include <opm/models/io/restart.hh>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// a minimal replacement for a grid view with a given number of elements
+struct TestGridView
+{
+    static constexpr int dimension = 2;
+
+    struct Comm
+    {
+        int size() const { return 1; }
+        int rank() const { return 0; }
+    };
+
+    template <int codim>
+    struct Codim
+    { using Iterator = std::vector<unsigned>::const_iterator; };
+
+    Comm comm() const
+    { return Comm(); }
+
+    int size(int codim) const
+    { return codim == 0 ? static_cast<int>(elements.size()) : 0; }
+
+    template <int codim>
+    typename Codim<codim>::Iterator begin() const
+    { return elements.begin(); }
+
+    template <int codim>
+    typename Codim<codim>::Iterator end() const
+    { return elements.end(); }
+
+    std::vector<unsigned> elements;
+};
+
+struct TestProblem
+{
+    std::string outputDir() const { return "."; }
+    std::string name() const { return "test_restart"; }
+};
+
+// mimics the interface of Opm::Simulator which is used by the Restart class
+struct TestSimulator
+{
+    const TestGridView& gridView() const { return gridView_; }
+    const TestProblem& problem() const { return problem_; }
+    double time() const { return 1.0; }
+
+    TestGridView gridView_;
+    TestProblem problem_;
+};
+
+// stores binary values for each element and a textual value as the models do
+struct TestSerializer
+{
+    void serializeEntity(std::ostream& os, unsigned elemIdx)
+    {
+        Opm::Restart::serializeValue(os, values[elemIdx]);
+        os << elemIdx << " ";
+    }
+
+    void deserializeEntity(std::istream& is, unsigned elemIdx)
+    {
+        unsigned storedIdx;
+        Opm::Restart::deserializeValue(is, values[elemIdx]);
+        is >> storedIdx;
+        if (storedIdx != elemIdx)
+            throw std::runtime_error("Wrong element index");
+    }
+
+    std::vector<double> values;
+};
+
+static void writeFile(const TestSimulator& simulator,
+                      TestSerializer& serializer,
+                      Opm::AsyncRestartWriter& writer)
+{
+    std::unique_ptr<Opm::Restart> res(new Opm::Restart);
+    res->serializeBegin(simulator);
+    res->serializeSectionBegin("Header");
+    res->serializeStream() << 42 << " " << 0.1 << " ";
+    res->serializeSectionEnd();
+    res->serializeEntities</*codim=*/0>(serializer, simulator.gridView());
+    res->finishSerialization();
+    writer.write(std::move(res));
+}
+
+static void readFile(const TestSimulator& simulator, TestSerializer& serializer)
+{
+    Opm::Restart res;
+    res.deserializeBegin(simulator, simulator.time());
+    res.deserializeSectionBegin("Header");
+    int intValue;
+    double doubleValue;
+    res.deserializeStream() >> intValue >> doubleValue;
+    if (intValue != 42 || doubleValue != 0.1)
+        throw std::runtime_error("Wrong values in header section");
+    res.deserializeSectionEnd();
+    res.deserializeEntities</*codim=*/0>(serializer, simulator.gridView());
+    res.deserializeEnd();
+}
+
+template <class Fn>
+static bool throws(Fn&& fn)
+{
+    try {
+        fn();
+    }
+    catch (const std::exception&) {
+        return true;
+    }
+    return false;
+}
+
+int main()
+{
+    const unsigned numElements = 10000;
+    TestSimulator simulator;
+    TestSerializer serializer;
+    for (unsigned elemIdx = 0; elemIdx < numElements; ++elemIdx) {
+        simulator.gridView_.elements.push_back(elemIdx);
+        // some values contain bytes which correspond to newlines or blanks
+        serializer.values.push_back(1.0/(elemIdx + 1) + 10.0*elemIdx);
+    }
+
+    // write a file synchronously and asynchronously and read it back
+    TestSerializer deserializer;
+    for (bool asyncWriting : { false, true }) {
+        Opm::AsyncRestartWriter writer(asyncWriting, /*maxPending=*/1);
+        writeFile(simulator, serializer, writer);
+
+        // the data must have been copied, i.e., changing it must not affect the file
+        std::vector<double> values = serializer.values;
+        for (double& value : serializer.values)
+            value = 0.0;
+        writer.finish();
+        serializer.values = values;
+
+        deserializer.values.assign(numElements, 0.0);
+        readFile(simulator, deserializer);
+        if (deserializer.values != serializer.values) {
+            std::cerr << "Restored values differ from the serialized ones\n";
+            return 1;
+        }
+    }
+
+    // a file for a different grid must be rejected
+    TestSimulator otherSimulator(simulator);
+    otherSimulator.gridView_.elements.pop_back();
+    if (!throws([&] { readFile(otherSimulator, deserializer); })) {
+        std::cerr << "Restart file for a different grid was not rejected\n";
+        return 1;
+    }
+
+    // flip a byte in the middle of the file, this must be detected by the checksums
+    std::string fileName = "test_restart_time=1_rank=0.ers";
+    {
+        std::fstream fs(fileName, std::ios::in | std::ios::out | std::ios::binary);
+        fs.seekg(0, std::ios::end);
+        auto fileSize = fs.tellg();
+        fs.seekp(fileSize/2);
+        char c = 0x55;
+        fs.write(&c, 1);
+    }
+    if (!throws([&] { readFile(simulator, deserializer); })) {
+        std::cerr << "Corrupted restart file was not rejected\n";
+        return 1;
+    }
+
+    std::remove(fileName.c_str());
+    return 0;
+}
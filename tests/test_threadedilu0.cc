@@ -0,0 +1,87 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the multi-threaded ILU(0) preconditioners.
+ *
+ * The level scheduled ILU(0) preconditioner must produce the same results as the
+ * sequential ILU(0) preconditioner of dune-istl, and the BiCGStab solver must converge
+ * using each of the preconditioners.
+ */
+#include "config.h"
+
+#include "preconditionertestutils.hh"
+
+#include <opm/simulators/linalg/threadedilu0.hh>
+
+#include <dune/common/version.hh>
+#include <dune/istl/preconditioners.hh>
+
+#include <cmath>
+#include <iostream>
+
+int main()
+{
+    size_t nx = 300;
+    size_t ny = 200;
+    Matrix A;
+    createMatrix(A, nx, ny);
+
+    Vector b(A.N());
+    for (size_t i = 0; i < b.size(); ++i)
+        for (int j = 0; j < blockSize; ++j)
+            b[i][j] = std::sin(0.01*(i*blockSize + j));
+
+    // the level scheduled ILU(0) must be identical to the sequential one
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2,7)
+    Dune::SeqILU<Matrix, Vector, Vector> seqIlu(A, /*relaxationFactor=*/1.0);
+#else
+    Dune::SeqILU0<Matrix, Vector, Vector> seqIlu(A, /*relaxationFactor=*/1.0);
+#endif
+    Opm::Linear::LevelScheduledILU0<Matrix, Vector, Vector> levelIlu(A, /*relaxationFactor=*/1.0);
+    Opm::Linear::ThreadedBlockILU0<Matrix, Vector, Vector> blockIlu(A, /*relaxationFactor=*/1.0);
+
+    if (levelIlu.numLevels().first != nx + ny - 1 || levelIlu.numLevels().second != nx + ny - 1) {
+        std::cerr << "Wrong number of levels\n";
+        return 1;
+    }
+
+    Vector seqResult(b.size());
+    Vector levelResult(b.size());
+    Vector d(b);
+    seqIlu.apply(seqResult, d);
+    levelIlu.apply(levelResult, b);
+    levelResult -= seqResult;
+    if (levelResult.two_norm() > 1e-12*seqResult.two_norm()) {
+        std::cerr << "The level scheduled ILU(0) differs from the sequential one\n";
+        return 1;
+    }
+
+    bool ok =
+        solve(A, b, seqIlu, "sequential ILU(0)")
+        && solve(A, b, levelIlu, "level scheduled ILU(0)")
+        && solve(A, b, blockIlu, "threaded block ILU(0)");
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,321 @@
+// -*- mode: C++; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*-
+// vi: set et ts=4 sw=4 sts=4:
+/*
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+
+  Consult the COPYING file in the top-level source directory of this
+  module for the precise wording of the license and the list of
+  copyright holders.
+*/
+/*!
+ * \file
+ *
+ * \brief This file tests the encoding of the VTK files written by VtkStaticGridWriter.
+ *
+ * The files are read back: The offsets of the data arrays must match the UInt64 headers
+ * of the appended data, the geometry and the fields must decode to the values which
+ * were written and, if zlib is available, the decompressed arrays of a compressed file
+ * must be identical to the ones of an uncompressed file.
+ */
+#include "config.h"
+
+#include <opm/models/io/vtkstaticgridwriter.hh>
+
+#include <dune/common/fvector.hh>
+#include <dune/common/parallel/mpihelper.hh>
+#include <dune/grid/common/mcmgmapper.hh>
+#include <dune/grid/yaspgrid.hh>
+
+#if HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Grid = Dune::YaspGrid<2>;
+using GridView = Grid::LeafGridView;
+using Mapper = Dune::MultipleCodimMultipleGeomTypeMapper<GridView>;
+using Writer = Opm::VtkStaticGridWriter<GridView>;
+
+// the decoded data arrays of a VTK file
+struct VtkFile
+{
+    size_t numPoints;
+    size_t numCells;
+    std::map<std::string, std::vector<char> > arrays;
+
+    template <class T>
+    std::vector<T> values(const std::string& name) const
+    {
+        const auto& bytes = arrays.at(name);
+        std::vector<T> result(bytes.size()/sizeof(T));
+        std::memcpy(result.data(), bytes.data(), bytes.size());
+        return result;
+    }
+};
+
+template <class T>
+static T readFromBuffer(const std::string& buffer, size_t pos)
+{
+    if (pos + sizeof(T) > buffer.size())
+        throw std::runtime_error("Read beyond the end of the appended data");
+
+    T value;
+    std::memcpy(&value, buffer.data() + pos, sizeof(T));
+    return value;
+}
+
+// decode the array which starts at a given offset of the appended data and return the
+// offset of the byte behind it
+static size_t decodeArray(const std::string& data, size_t offset, bool compressed, std::vector<char>& result)
+{
+    if (!compressed) {
+        uint64_t numBytes = readFromBuffer<uint64_t>(data, offset);
+        size_t payloadPos = offset + sizeof(uint64_t);
+        if (payloadPos + numBytes > data.size())
+            throw std::runtime_error("The header of an array exceeds the appended data");
+        result.assign(data.begin() + payloadPos, data.begin() + payloadPos + numBytes);
+        return payloadPos + numBytes;
+    }
+
+#if HAVE_ZLIB
+    // the header consists of the number of blocks, the uncompressed size of the blocks,
+    // the uncompressed size of the last block and the compressed size of each block
+    uint64_t numBlocks = readFromBuffer<uint64_t>(data, offset);
+    uint64_t blockSize = readFromBuffer<uint64_t>(data, offset + sizeof(uint64_t));
+    uint64_t lastBlockSize = readFromBuffer<uint64_t>(data, offset + 2*sizeof(uint64_t));
+    if (blockSize != 32768)
+        throw std::runtime_error("Unexpected size of the compressed blocks");
+
+    size_t blockPos = offset + (3 + numBlocks)*sizeof(uint64_t);
+    result.clear();
+    for (uint64_t blockIdx = 0; blockIdx < numBlocks; ++blockIdx) {
+        uint64_t compressedSize = readFromBuffer<uint64_t>(data, offset + (3 + blockIdx)*sizeof(uint64_t));
+        if (blockPos + compressedSize > data.size())
+            throw std::runtime_error("A compressed block exceeds the appended data");
+
+        uLongf uncompressedSize = static_cast<uLongf>(blockSize);
+        if (blockIdx == numBlocks - 1 && lastBlockSize > 0)
+            uncompressedSize = static_cast<uLongf>(lastBlockSize);
+        size_t resultPos = result.size();
+        result.resize(resultPos + uncompressedSize);
+
+        uLongf decodedSize = uncompressedSize;
+        int ret = uncompress(reinterpret_cast<Bytef*>(result.data() + resultPos),
+                             &decodedSize,
+                             reinterpret_cast<const Bytef*>(data.data() + blockPos),
+                             static_cast<uLong>(compressedSize));
+        if (ret != Z_OK || decodedSize != uncompressedSize)
+            throw std::runtime_error("A block could not be decompressed");
+
+        blockPos += compressedSize;
+    }
+    return blockPos;
+#else
+    (void) result;
+    throw std::logic_error("Compressed VTK files can only be read if zlib is available");
+#endif
+}
+
+// read a VTK file and check that the data arrays are stored contiguously in the
+// appended data
+static VtkFile readVtkFile(const std::string& fileName, bool compressed)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Could not open '" + fileName + "'");
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    VtkFile result;
+    std::smatch match;
+    if (!std::regex_search(content, match, std::regex("NumberOfPoints=\"(\\d+)\" NumberOfCells=\"(\\d+)\"")))
+        throw std::runtime_error("The piece of '" + fileName + "' is not specified");
+    result.numPoints = std::stoul(match[1]);
+    result.numCells = std::stoul(match[2]);
+
+    bool isCompressed = content.find("compressor=\"vtkZLibDataCompressor\"") != std::string::npos;
+    if (isCompressed != compressed)
+        throw std::runtime_error("The compressor of '" + fileName + "' is not specified correctly");
+
+    const std::string appendedTag = "<AppendedData encoding=\"raw\">\n_";
+    size_t dataBegin = content.find(appendedTag);
+    size_t dataEnd = content.rfind("\n </AppendedData>");
+    if (dataBegin == std::string::npos || dataEnd == std::string::npos || dataEnd < dataBegin)
+        throw std::runtime_error("'" + fileName + "' does not contain appended data");
+    dataBegin += appendedTag.size();
+    std::string data = content.substr(dataBegin, dataEnd - dataBegin);
+    std::string xml = content.substr(0, dataBegin);
+
+    // the arrays ordered by their offset
+    std::map<size_t, std::string> arrayOffsets;
+    std::regex dataArrayRegex("<DataArray type=\"\\w+\" Name=\"(\\w+)\" NumberOfComponents=\"\\d+\" "
+                              "format=\"appended\" offset=\"(\\d+)\"/>");
+    for (std::sregex_iterator it(xml.begin(), xml.end(), dataArrayRegex), endIt; it != endIt; ++it)
+        arrayOffsets[std::stoul((*it)[2])] = (*it)[1];
+
+    size_t expectedOffset = 0;
+    for (const auto& [offset, name] : arrayOffsets) {
+        if (offset != expectedOffset)
+            throw std::runtime_error("The offset of array '" + name + "' does not match the "
+                                     "size of the preceding array");
+        expectedOffset = decodeArray(data, offset, compressed, result.arrays[name]);
+    }
+    if (expectedOffset != data.size())
+        throw std::runtime_error("The appended data of '" + fileName + "' exceeds its arrays");
+
+    return result;
+}
+
+// check the decoded arrays of a file written for a structured grid of quadrilaterals
+static void checkFile(const VtkFile& file, const GridView& gridView, const Mapper& elementMapper)
+{
+    if (file.numPoints != static_cast<size_t>(gridView.size(/*codim=*/2))
+        || file.numCells != static_cast<size_t>(gridView.size(/*codim=*/0)))
+        throw std::runtime_error("Wrong number of points or cells");
+
+    const auto coords = file.values<float>("Coordinates");
+    const auto connectivity = file.values<int64_t>("connectivity");
+    const auto offsets = file.values<int64_t>("offsets");
+    const auto types = file.values<uint8_t>("types");
+    const auto cellIndex = file.values<float>("cellIndex");
+    const auto position = file.values<float>("position");
+    if (coords.size() != 3*file.numPoints
+        || connectivity.size() != 4*file.numCells
+        || offsets.size() != file.numCells
+        || types.size() != file.numCells
+        || cellIndex.size() != file.numCells
+        || position.size() != 2*file.numPoints)
+        throw std::runtime_error("Wrong size of the arrays");
+
+    // the cells are written in the order of the grid view
+    size_t cellIdx = 0;
+    for (const auto& elem : elements(gridView)) {
+        if (types[cellIdx] != 9 /* VTK_QUAD */ || offsets[cellIdx] != static_cast<int64_t>(4*(cellIdx + 1)))
+            throw std::runtime_error("Wrong type or offset of a cell");
+        if (cellIndex[cellIdx] != static_cast<float>(elementMapper.index(elem)))
+            throw std::runtime_error("Wrong value of a cell field");
+
+        // the corners of the cell must be at the positions of the element's vertices
+        const auto& geometry = elem.geometry();
+        for (int vtkCornerIdx = 0; vtkCornerIdx < 4; ++vtkCornerIdx) {
+            int duneCornerIdx = Dune::VTK::renumber(elem.type(), vtkCornerIdx);
+            const auto& pos = geometry.corner(duneCornerIdx);
+            int64_t pointIdx = connectivity[4*cellIdx + vtkCornerIdx];
+            if (pointIdx < 0 || static_cast<size_t>(pointIdx) >= file.numPoints)
+                throw std::runtime_error("Invalid point index");
+            for (unsigned k = 0; k < 2; ++k)
+                if (coords[3*pointIdx + k] != static_cast<float>(pos[k])
+                    || position[2*pointIdx + k] != static_cast<float>(pos[k]))
+                    throw std::runtime_error("Wrong coordinates or point field");
+            if (coords[3*pointIdx + 2] != 0.0f)
+                throw std::runtime_error("The third coordinate of a two-dimensional grid is not zero");
+        }
+        ++cellIdx;
+    }
+}
+
+// write a file with a cell and a point field and return the name of the written file
+static std::string writeFile(const GridView& gridView,
+                             const Mapper& vertexMapper,
+                             const Mapper& elementMapper,
+                             bool compress,
+                             const std::string& name)
+{
+    // the positions of the vertices in the order of the vertex mapper
+    std::vector<float> vertexPos(2*vertexMapper.size());
+    for (const auto& vertex : vertices(gridView)) {
+        const auto& pos = vertex.geometry().center();
+        for (unsigned k = 0; k < 2; ++k)
+            vertexPos[2*vertexMapper.index(vertex) + k] = static_cast<float>(pos[k]);
+    }
+
+    Writer writer(gridView, compress);
+    writer.updateGeometry(vertexMapper, elementMapper);
+
+    auto file = writer.createFile();
+    file->addField("cellIndex", /*isCellData=*/true, /*numComponents=*/1,
+                   [](const std::vector<unsigned>& dofs, unsigned, float* values)
+                   {
+                       for (size_t i = 0; i < dofs.size(); ++i)
+                           values[i] = static_cast<float>(dofs[i]);
+                   });
+    file->addField("position", /*isCellData=*/false, /*numComponents=*/2,
+                   [&vertexPos](const std::vector<unsigned>& dofs, unsigned numComponents, float* values)
+                   {
+                       for (size_t i = 0; i < dofs.size(); ++i)
+                           for (unsigned k = 0; k < numComponents; ++k)
+                               values[i*numComponents + k] = vertexPos[2*dofs[i] + k];
+                   });
+    for (size_t fieldIdx = 0; fieldIdx < file->numFields(); ++fieldIdx) {
+        file->fillField(fieldIdx);
+        file->encodeField(fieldIdx);
+    }
+
+    return file->write(".", name, /*commRank=*/0, /*commSize=*/1);
+}
+
+// write a grid with nx times ny cells and check the written file(s)
+static void testGrid(int nx, int ny)
+{
+    Grid grid(Dune::FieldVector<double, 2>(1.0), std::array<int, 2>{{nx, ny}});
+    const auto& gridView = grid.leafGridView();
+    Mapper vertexMapper(gridView, Dune::mcmgVertexLayout());
+    Mapper elementMapper(gridView, Dune::mcmgElementLayout());
+
+    std::string suffix = std::to_string(nx) + "x" + std::to_string(ny);
+    const std::string rawName = writeFile(gridView, vertexMapper, elementMapper,
+                                          /*compress=*/false, "test_vtkstaticgridwriter-" + suffix);
+    const VtkFile rawFile = readVtkFile(rawName, /*compressed=*/false);
+    checkFile(rawFile, gridView, elementMapper);
+
+#if HAVE_ZLIB
+    // the compressed file must decode to exactly the same data
+    const std::string compressedName = writeFile(gridView, vertexMapper, elementMapper,
+                                                 /*compress=*/true, "test_vtkstaticgridwriter-z-" + suffix);
+    const VtkFile compressedFile = readVtkFile(compressedName, /*compressed=*/true);
+    if (compressedFile.arrays != rawFile.arrays)
+        throw std::runtime_error("The compressed file differs from the uncompressed one");
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    Dune::MPIHelper::instance(argc, argv);
+
+    try {
+        // the arrays of the small grid fit into a single compressed block. for the large
+        // grid, most arrays need several blocks and the cell field exactly fills one.
+        testGrid(/*nx=*/4, /*ny=*/3);
+        testGrid(/*nx=*/128, /*ny=*/64);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "VTK file check failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}